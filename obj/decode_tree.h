@@ -0,0 +1,768 @@
+// 由decodegen从src/isa.h生成, 不要手动修改
+// 155条指令, 521个节点, 最多3层switch
+
+static bool decode_rv32(inst_t *inst, uint32_t data) {
+    switch ((data >> 2 & 0x1f) << 3 | (data >> 12 & 0x7)) {
+    case 0x0:
+        DECODE(lb, i, 0);
+    case 0x1:
+        DECODE(lh, i, 0);
+    case 0x2:
+        DECODE(lw, i, 0);
+    case 0x3:
+        DECODE(ld, i, 0);
+    case 0x4:
+        DECODE(lbu, i, 0);
+    case 0x5:
+        DECODE(lhu, i, 0);
+    case 0x6:
+        DECODE(lwu, i, 0);
+    case 0xa:
+        DECODE(flw, i, 0);
+    case 0xb:
+        DECODE(fld, i, 0);
+    case 0x18:
+        DECODE(fence, none, 0);
+    case 0x19:
+        DECODE(fence_i, none, ISA_END);
+    case 0x20:
+        DECODE(addi, i, 0);
+    case 0x21:
+        REQUIRE((data & 0xfc00707f) == 0x00001013);
+        DECODE(slli, i, 0);
+    case 0x22:
+        DECODE(slti, i, 0);
+    case 0x23:
+        DECODE(sltiu, i, 0);
+    case 0x24:
+        DECODE(xori, i, 0);
+    case 0x25:
+        switch ((data >> 26) & 0x3f) {
+        case 0x0:
+            DECODE(srli, i, 0);
+        case 0x10:
+            DECODE(srai, i, 0);
+        default:
+            return false;
+        }
+    case 0x26:
+        DECODE(ori, i, 0);
+    case 0x27:
+        DECODE(andi, i, 0);
+    case 0x28:
+    case 0x29:
+    case 0x2a:
+    case 0x2b:
+    case 0x2c:
+    case 0x2d:
+    case 0x2e:
+    case 0x2f:
+        DECODE(auipc, u, 0);
+    case 0x30:
+        DECODE(addiw, i, 0);
+    case 0x31:
+        REQUIRE((data & 0xfe00707f) == 0x0000101b);
+        DECODE(slliw, i, 0);
+    case 0x35:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(srliw, i, 0);
+        case 0x20:
+            DECODE(sraiw, i, 0);
+        default:
+            return false;
+        }
+    case 0x40:
+        DECODE(sb, s, 0);
+    case 0x41:
+        DECODE(sh, s, 0);
+    case 0x42:
+        DECODE(sw, s, 0);
+    case 0x43:
+        DECODE(sd, s, 0);
+    case 0x4a:
+        DECODE(fsw, s, 0);
+    case 0x4b:
+        DECODE(fsd, s, 0);
+    case 0x5a:
+        switch ((data >> 27) & 0x1f) {
+        case 0x0:
+            DECODE(amoadd_w, r, 0);
+        case 0x1:
+            DECODE(amoswap_w, r, 0);
+        case 0x2:
+            REQUIRE((data & 0xf9f0707f) == 0x1000202f);
+            DECODE(lr_w, r, 0);
+        case 0x3:
+            DECODE(sc_w, r, 0);
+        case 0x4:
+            DECODE(amoxor_w, r, 0);
+        case 0x8:
+            DECODE(amoor_w, r, 0);
+        case 0xc:
+            DECODE(amoand_w, r, 0);
+        case 0x10:
+            DECODE(amomin_w, r, 0);
+        case 0x14:
+            DECODE(amomax_w, r, 0);
+        case 0x18:
+            DECODE(amominu_w, r, 0);
+        case 0x1c:
+            DECODE(amomaxu_w, r, 0);
+        default:
+            return false;
+        }
+    case 0x5b:
+        switch ((data >> 27) & 0x1f) {
+        case 0x0:
+            DECODE(amoadd_d, r, 0);
+        case 0x1:
+            DECODE(amoswap_d, r, 0);
+        case 0x2:
+            REQUIRE((data & 0xf9f0707f) == 0x1000302f);
+            DECODE(lr_d, r, 0);
+        case 0x3:
+            DECODE(sc_d, r, 0);
+        case 0x4:
+            DECODE(amoxor_d, r, 0);
+        case 0x8:
+            DECODE(amoor_d, r, 0);
+        case 0xc:
+            DECODE(amoand_d, r, 0);
+        case 0x10:
+            DECODE(amomin_d, r, 0);
+        case 0x14:
+            DECODE(amomax_d, r, 0);
+        case 0x18:
+            DECODE(amominu_d, r, 0);
+        case 0x1c:
+            DECODE(amomaxu_d, r, 0);
+        default:
+            return false;
+        }
+    case 0x60:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(add, r, 0);
+        case 0x1:
+            DECODE(mul, r, 0);
+        case 0x20:
+            DECODE(sub, r, 0);
+        default:
+            return false;
+        }
+    case 0x61:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(sll, r, 0);
+        case 0x1:
+            DECODE(mulh, r, 0);
+        default:
+            return false;
+        }
+    case 0x62:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(slt, r, 0);
+        case 0x1:
+            DECODE(mulhsu, r, 0);
+        default:
+            return false;
+        }
+    case 0x63:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(sltu, r, 0);
+        case 0x1:
+            DECODE(mulhu, r, 0);
+        default:
+            return false;
+        }
+    case 0x64:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(xor, r, 0);
+        case 0x1:
+            DECODE(div, r, 0);
+        default:
+            return false;
+        }
+    case 0x65:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(srl, r, 0);
+        case 0x1:
+            DECODE(divu, r, 0);
+        case 0x20:
+            DECODE(sra, r, 0);
+        default:
+            return false;
+        }
+    case 0x66:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(or, r, 0);
+        case 0x1:
+            DECODE(rem, r, 0);
+        default:
+            return false;
+        }
+    case 0x67:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(and, r, 0);
+        case 0x1:
+            DECODE(remu, r, 0);
+        default:
+            return false;
+        }
+    case 0x68:
+    case 0x69:
+    case 0x6a:
+    case 0x6b:
+    case 0x6c:
+    case 0x6d:
+    case 0x6e:
+    case 0x6f:
+        DECODE(lui, u, 0);
+    case 0x70:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(addw, r, 0);
+        case 0x1:
+            DECODE(mulw, r, 0);
+        case 0x20:
+            DECODE(subw, r, 0);
+        default:
+            return false;
+        }
+    case 0x71:
+        REQUIRE((data & 0xfe00707f) == 0x0000103b);
+        DECODE(sllw, r, 0);
+    case 0x74:
+        REQUIRE((data & 0xfe00707f) == 0x0200403b);
+        DECODE(divw, r, 0);
+    case 0x75:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(srlw, r, 0);
+        case 0x1:
+            DECODE(divuw, r, 0);
+        case 0x20:
+            DECODE(sraw, r, 0);
+        default:
+            return false;
+        }
+    case 0x76:
+        REQUIRE((data & 0xfe00707f) == 0x0200603b);
+        DECODE(remw, r, 0);
+    case 0x77:
+        REQUIRE((data & 0xfe00707f) == 0x0200703b);
+        DECODE(remuw, r, 0);
+    case 0x80:
+    case 0x81:
+    case 0x82:
+    case 0x83:
+    case 0x84:
+    case 0x85:
+    case 0x86:
+    case 0x87:
+        switch ((data >> 25) & 0x3) {
+        case 0x0:
+            DECODE(fmadd_s, r4, 0);
+        case 0x1:
+            DECODE(fmadd_d, r4, 0);
+        default:
+            return false;
+        }
+    case 0x88:
+    case 0x89:
+    case 0x8a:
+    case 0x8b:
+    case 0x8c:
+    case 0x8d:
+    case 0x8e:
+    case 0x8f:
+        switch ((data >> 25) & 0x3) {
+        case 0x0:
+            DECODE(fmsub_s, r4, 0);
+        case 0x1:
+            DECODE(fmsub_d, r4, 0);
+        default:
+            return false;
+        }
+    case 0x90:
+    case 0x91:
+    case 0x92:
+    case 0x93:
+    case 0x94:
+    case 0x95:
+    case 0x96:
+    case 0x97:
+        switch ((data >> 25) & 0x3) {
+        case 0x0:
+            DECODE(fnmsub_s, r4, 0);
+        case 0x1:
+            DECODE(fnmsub_d, r4, 0);
+        default:
+            return false;
+        }
+    case 0x98:
+    case 0x99:
+    case 0x9a:
+    case 0x9b:
+    case 0x9c:
+    case 0x9d:
+    case 0x9e:
+    case 0x9f:
+        switch ((data >> 25) & 0x3) {
+        case 0x0:
+            DECODE(fnmadd_s, r4, 0);
+        case 0x1:
+            DECODE(fnmadd_d, r4, 0);
+        default:
+            return false;
+        }
+    case 0xa0:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(fadd_s, r, 0);
+        case 0x1:
+            DECODE(fadd_d, r, 0);
+        case 0x4:
+            DECODE(fsub_s, r, 0);
+        case 0x5:
+            DECODE(fsub_d, r, 0);
+        case 0x8:
+            DECODE(fmul_s, r, 0);
+        case 0x9:
+            DECODE(fmul_d, r, 0);
+        case 0xc:
+            DECODE(fdiv_s, r, 0);
+        case 0xd:
+            DECODE(fdiv_d, r, 0);
+        case 0x10:
+            DECODE(fsgnj_s, r, 0);
+        case 0x11:
+            DECODE(fsgnj_d, r, 0);
+        case 0x14:
+            DECODE(fmin_s, r, 0);
+        case 0x15:
+            DECODE(fmin_d, r, 0);
+        case 0x20:
+            REQUIRE((data & 0xfff0007f) == 0x40100053);
+            DECODE(fcvt_s_d, r, 0);
+        case 0x21:
+            REQUIRE((data & 0xfff0007f) == 0x42000053);
+            DECODE(fcvt_d_s, r, 0);
+        case 0x2c:
+            REQUIRE((data & 0xfff0007f) == 0x58000053);
+            DECODE(fsqrt_s, r, 0);
+        case 0x2d:
+            REQUIRE((data & 0xfff0007f) == 0x5a000053);
+            DECODE(fsqrt_d, r, 0);
+        case 0x50:
+            DECODE(fle_s, r, 0);
+        case 0x51:
+            DECODE(fle_d, r, 0);
+        case 0x60:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_s, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_s, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_s, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_s, r, 0);
+            default:
+                return false;
+            }
+        case 0x61:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_d, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_d, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_d, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_d, r, 0);
+            default:
+                return false;
+            }
+        case 0x68:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_s_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_s_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_s_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_s_lu, r, 0);
+            default:
+                return false;
+            }
+        case 0x69:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_d_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_d_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_d_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_d_lu, r, 0);
+            default:
+                return false;
+            }
+        case 0x70:
+            REQUIRE((data & 0xfff0707f) == 0xe0000053);
+            DECODE(fmv_x_w, r, 0);
+        case 0x71:
+            REQUIRE((data & 0xfff0707f) == 0xe2000053);
+            DECODE(fmv_x_d, r, 0);
+        case 0x78:
+            REQUIRE((data & 0xfff0707f) == 0xf0000053);
+            DECODE(fmv_w_x, r, 0);
+        case 0x79:
+            REQUIRE((data & 0xfff0707f) == 0xf2000053);
+            DECODE(fmv_d_x, r, 0);
+        default:
+            return false;
+        }
+    case 0xa1:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(fadd_s, r, 0);
+        case 0x1:
+            DECODE(fadd_d, r, 0);
+        case 0x4:
+            DECODE(fsub_s, r, 0);
+        case 0x5:
+            DECODE(fsub_d, r, 0);
+        case 0x8:
+            DECODE(fmul_s, r, 0);
+        case 0x9:
+            DECODE(fmul_d, r, 0);
+        case 0xc:
+            DECODE(fdiv_s, r, 0);
+        case 0xd:
+            DECODE(fdiv_d, r, 0);
+        case 0x10:
+            DECODE(fsgnjn_s, r, 0);
+        case 0x11:
+            DECODE(fsgnjn_d, r, 0);
+        case 0x14:
+            DECODE(fmax_s, r, 0);
+        case 0x15:
+            DECODE(fmax_d, r, 0);
+        case 0x20:
+            REQUIRE((data & 0xfff0007f) == 0x40100053);
+            DECODE(fcvt_s_d, r, 0);
+        case 0x21:
+            REQUIRE((data & 0xfff0007f) == 0x42000053);
+            DECODE(fcvt_d_s, r, 0);
+        case 0x2c:
+            REQUIRE((data & 0xfff0007f) == 0x58000053);
+            DECODE(fsqrt_s, r, 0);
+        case 0x2d:
+            REQUIRE((data & 0xfff0007f) == 0x5a000053);
+            DECODE(fsqrt_d, r, 0);
+        case 0x50:
+            DECODE(flt_s, r, 0);
+        case 0x51:
+            DECODE(flt_d, r, 0);
+        case 0x60:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_s, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_s, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_s, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_s, r, 0);
+            default:
+                return false;
+            }
+        case 0x61:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_d, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_d, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_d, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_d, r, 0);
+            default:
+                return false;
+            }
+        case 0x68:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_s_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_s_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_s_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_s_lu, r, 0);
+            default:
+                return false;
+            }
+        case 0x69:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_d_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_d_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_d_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_d_lu, r, 0);
+            default:
+                return false;
+            }
+        case 0x70:
+            REQUIRE((data & 0xfff0707f) == 0xe0001053);
+            DECODE(fclass_s, r, 0);
+        case 0x71:
+            REQUIRE((data & 0xfff0707f) == 0xe2001053);
+            DECODE(fclass_d, r, 0);
+        default:
+            return false;
+        }
+    case 0xa2:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(fadd_s, r, 0);
+        case 0x1:
+            DECODE(fadd_d, r, 0);
+        case 0x4:
+            DECODE(fsub_s, r, 0);
+        case 0x5:
+            DECODE(fsub_d, r, 0);
+        case 0x8:
+            DECODE(fmul_s, r, 0);
+        case 0x9:
+            DECODE(fmul_d, r, 0);
+        case 0xc:
+            DECODE(fdiv_s, r, 0);
+        case 0xd:
+            DECODE(fdiv_d, r, 0);
+        case 0x10:
+            DECODE(fsgnjx_s, r, 0);
+        case 0x11:
+            DECODE(fsgnjx_d, r, 0);
+        case 0x20:
+            REQUIRE((data & 0xfff0007f) == 0x40100053);
+            DECODE(fcvt_s_d, r, 0);
+        case 0x21:
+            REQUIRE((data & 0xfff0007f) == 0x42000053);
+            DECODE(fcvt_d_s, r, 0);
+        case 0x2c:
+            REQUIRE((data & 0xfff0007f) == 0x58000053);
+            DECODE(fsqrt_s, r, 0);
+        case 0x2d:
+            REQUIRE((data & 0xfff0007f) == 0x5a000053);
+            DECODE(fsqrt_d, r, 0);
+        case 0x50:
+            DECODE(feq_s, r, 0);
+        case 0x51:
+            DECODE(feq_d, r, 0);
+        case 0x60:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_s, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_s, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_s, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_s, r, 0);
+            default:
+                return false;
+            }
+        case 0x61:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_d, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_d, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_d, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_d, r, 0);
+            default:
+                return false;
+            }
+        case 0x68:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_s_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_s_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_s_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_s_lu, r, 0);
+            default:
+                return false;
+            }
+        case 0x69:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_d_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_d_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_d_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_d_lu, r, 0);
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    case 0xa3:
+    case 0xa4:
+    case 0xa5:
+    case 0xa6:
+    case 0xa7:
+        switch ((data >> 25) & 0x7f) {
+        case 0x0:
+            DECODE(fadd_s, r, 0);
+        case 0x1:
+            DECODE(fadd_d, r, 0);
+        case 0x4:
+            DECODE(fsub_s, r, 0);
+        case 0x5:
+            DECODE(fsub_d, r, 0);
+        case 0x8:
+            DECODE(fmul_s, r, 0);
+        case 0x9:
+            DECODE(fmul_d, r, 0);
+        case 0xc:
+            DECODE(fdiv_s, r, 0);
+        case 0xd:
+            DECODE(fdiv_d, r, 0);
+        case 0x20:
+            REQUIRE((data & 0xfff0007f) == 0x40100053);
+            DECODE(fcvt_s_d, r, 0);
+        case 0x21:
+            REQUIRE((data & 0xfff0007f) == 0x42000053);
+            DECODE(fcvt_d_s, r, 0);
+        case 0x2c:
+            REQUIRE((data & 0xfff0007f) == 0x58000053);
+            DECODE(fsqrt_s, r, 0);
+        case 0x2d:
+            REQUIRE((data & 0xfff0007f) == 0x5a000053);
+            DECODE(fsqrt_d, r, 0);
+        case 0x60:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_s, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_s, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_s, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_s, r, 0);
+            default:
+                return false;
+            }
+        case 0x61:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_w_d, r, 0);
+            case 0x1:
+                DECODE(fcvt_wu_d, r, 0);
+            case 0x2:
+                DECODE(fcvt_l_d, r, 0);
+            case 0x3:
+                DECODE(fcvt_lu_d, r, 0);
+            default:
+                return false;
+            }
+        case 0x68:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_s_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_s_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_s_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_s_lu, r, 0);
+            default:
+                return false;
+            }
+        case 0x69:
+            switch ((data >> 20) & 0x1f) {
+            case 0x0:
+                DECODE(fcvt_d_w, r, 0);
+            case 0x1:
+                DECODE(fcvt_d_wu, r, 0);
+            case 0x2:
+                DECODE(fcvt_d_l, r, 0);
+            case 0x3:
+                DECODE(fcvt_d_lu, r, 0);
+            default:
+                return false;
+            }
+        default:
+            return false;
+        }
+    case 0xc0:
+        DECODE(beq, b, ISA_END);
+    case 0xc1:
+        DECODE(bne, b, ISA_END);
+    case 0xc4:
+        DECODE(blt, b, ISA_END);
+    case 0xc5:
+        DECODE(bge, b, ISA_END);
+    case 0xc6:
+        DECODE(bltu, b, ISA_END);
+    case 0xc7:
+        DECODE(bgeu, b, ISA_END);
+    case 0xc8:
+    case 0xc9:
+    case 0xca:
+    case 0xcb:
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+        DECODE(jalr, i, ISA_END);
+    case 0xd8:
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+    case 0xdc:
+    case 0xdd:
+    case 0xde:
+    case 0xdf:
+        DECODE(jal, j, ISA_END);
+    case 0xe0:
+        REQUIRE((data & 0xffffffff) == 0x00000073);
+        DECODE(ecall, none, ISA_END);
+    case 0xe1:
+        DECODE(csrrw, csr, 0);
+    case 0xe2:
+        DECODE(csrrs, csr, 0);
+    case 0xe3:
+        DECODE(csrrc, csr, 0);
+    case 0xe5:
+        DECODE(csrrwi, csr, 0);
+    case 0xe6:
+        DECODE(csrrsi, csr, 0);
+    case 0xe7:
+        DECODE(csrrci, csr, 0);
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,1072 @@
+// 由stencilgen从src/stencils/stencils.c生成, 不要手动修改
+
+static const stencil_hole_t stencil_lb_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 24, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lb_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x0f, 0xbe, 0x00, 0x48, 0x89, 0x87,
+    0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_lh_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 24, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lh_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x0f, 0xbf, 0x00, 0x48, 0x89, 0x87,
+    0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_lw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x63, 0x00, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_ld_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_ld_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x00, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_lbu_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lbu_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x0f, 0xb6, 0x00, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_lhu_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lhu_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x0f, 0xb7, 0x00, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_lwu_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 22, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lwu_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x8b, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sb_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 8, hole_rs2, R_X86_64_32S, 0 },
+    { 20, hole_rs1, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sb_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x88, 0x10,
+};
+
+static const stencil_hole_t stencil_sh_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 8, hole_rs2, R_X86_64_32S, 0 },
+    { 20, hole_rs1, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sh_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x66, 0x89, 0x10,
+};
+
+static const stencil_hole_t stencil_sw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 8, hole_rs2, R_X86_64_32S, 0 },
+    { 20, hole_rs1, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x89, 0x10,
+};
+
+static const stencil_hole_t stencil_sd_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 8, hole_rs2, R_X86_64_32S, 0 },
+    { 20, hole_rs1, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sd_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x89, 0x10,
+};
+
+static const stencil_hole_t stencil_addi_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_addi_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x03, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_slli_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_slli_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xe0, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_slti_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_slti_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x0f, 0x9c, 0xc0, 0x0f, 0xb6, 0xc0, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sltiu_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sltiu_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x0f, 0x92, 0xc0, 0x0f, 0xb6, 0xc0, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_xori_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_xori_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x33, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_srli_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_srli_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xe8, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_srai_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_srai_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xf8, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_ori_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_ori_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x0b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_andi_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_andi_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x23, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_addiw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 7, hole_rs1, R_X86_64_32S, 0 },
+    { 16, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_addiw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48,
+    0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_slliw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 25, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_slliw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x83, 0xe1, 0x1f, 0x48, 0xd3, 0xe0, 0x48, 0x98, 0x48, 0x89,
+    0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_srliw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 9, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_srliw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x8b, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0xd3, 0xe8, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sraiw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 9, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sraiw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x8b, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0xd3, 0xf8, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_lui_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_lui_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_auipc_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_auipc_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_add_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_add_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x03, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sub_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sub_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x2b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sll_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sll_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xe0, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_slt_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_slt_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x0f, 0x9c, 0xc0, 0x0f, 0xb6, 0xc0, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sltu_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sltu_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x0f, 0x92, 0xc0, 0x0f, 0xb6, 0xc0, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_xor_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_xor_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x33, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_srl_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_srl_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xe8, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sra_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sra_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xf8, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_or_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_or_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x0b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_and_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_and_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x23, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_addw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 9, hole_rs1, R_X86_64_32S, 0 },
+    { 18, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_addw_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x03, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_subw_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 9, hole_rs2, R_X86_64_32S, 0 },
+    { 18, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_subw_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x2b, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sllw_holes[] = {
+    { 2, hole_rs2, R_X86_64_32S, 0 },
+    { 9, hole_rs1, R_X86_64_32S, 0 },
+    { 24, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sllw_code[] = {
+    0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0x83, 0xe1, 0x1f, 0x48, 0xd3, 0xe0, 0x48, 0x98, 0x48, 0x89, 0x87,
+    0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_srlw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 9, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_srlw_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x8b, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0xd3, 0xe8, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_sraw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 9, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_sraw_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x8b, 0x87, 0x00, 0x00, 0x00,
+    0x00, 0xd3, 0xf8, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_mul_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 11, hole_rs2, R_X86_64_32S, 0 },
+    { 18, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_mul_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x0f, 0xaf, 0x87, 0x00,
+    0x00, 0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_mulh_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_mulh_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0xf7, 0xaf, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x97, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_mulhsu_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 34, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_mulhsu_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0xc1, 0x48, 0xc1, 0xf9, 0x3f, 0x48, 0x0f, 0xaf,
+    0xca, 0x48, 0xf7, 0xe2, 0x48, 0x01, 0xd1, 0x48, 0x89, 0x8f, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_mulhu_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_rs2, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_mulhu_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0xf7, 0xa7, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x97, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_mulw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 19, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_mulw_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x0f, 0xaf, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_div_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 50, hole_rd, R_X86_64_32S, 0 },
+    { 75, hole_rd, R_X86_64_32S, 0 },
+    { 55, hole_continue, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_div_code[] = {
+    0x4c, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xc7, 0xc1, 0xff, 0xff, 0xff, 0xff, 0x4d, 0x85, 0xc0,
+    0x74, 0x15, 0x48, 0xb9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+    0x48, 0x39, 0xc8, 0x75, 0x17, 0x49, 0x83, 0xf8, 0xff, 0x75, 0x11, 0x48,
+    0x89, 0x8f, 0x00, 0x00, 0x00, 0x00, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f,
+    0x1f, 0x44, 0x00, 0x00, 0x48, 0x99, 0x49, 0xf7, 0xf8, 0x48, 0x89, 0xc1,
+    0x48, 0x89, 0x8f, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_divu_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 37, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_divu_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x49, 0xc7, 0xc0, 0xff, 0xff, 0xff, 0xff, 0x48, 0x85, 0xc9,
+    0x74, 0x08, 0x31, 0xd2, 0x48, 0xf7, 0xf1, 0x49, 0x89, 0xc0, 0x4c, 0x89,
+    0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_rem_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 45, hole_rd, R_X86_64_32S, 0 },
+    { 75, hole_rd, R_X86_64_32S, 0 },
+    { 50, hole_continue, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_rem_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x85, 0xc9, 0x74, 0x17, 0x48, 0xb8, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x80, 0x48, 0x39, 0xc2, 0x75, 0x1e, 0x48, 0x83,
+    0xf9, 0xff, 0x75, 0x18, 0x31, 0xd2, 0x48, 0x89, 0x97, 0x00, 0x00, 0x00,
+    0x00, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x48, 0x89, 0xd0, 0x48, 0x99, 0x48, 0xf7, 0xf9,
+    0x48, 0x89, 0x97, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_remu_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 30, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_remu_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x85, 0xc9, 0x74, 0x08, 0x48, 0x89, 0xd0, 0x31, 0xd2,
+    0x48, 0xf7, 0xf1, 0x48, 0x89, 0x97, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_divw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 42, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_divw_code[] = {
+    0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xc7, 0xc1, 0xff, 0xff, 0xff, 0xff, 0x48, 0x85, 0xd2,
+    0x74, 0x0d, 0x48, 0x98, 0x48, 0x63, 0xca, 0x48, 0x99, 0x48, 0xf7, 0xf9,
+    0x48, 0x63, 0xc8, 0x48, 0x89, 0x8f, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_divuw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 36, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_divuw_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xc7, 0xc2, 0xff, 0xff, 0xff, 0xff, 0x48, 0x85, 0xc9,
+    0x74, 0x07, 0x31, 0xd2, 0xf7, 0xf1, 0x48, 0x63, 0xd0, 0x48, 0x89, 0x97,
+    0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_remw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 25, hole_rd, R_X86_64_32S, 0 },
+    { 53, hole_rd, R_X86_64_32S, 0 },
+    { 30, hole_continue, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_remw_code[] = {
+    0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x85, 0xd2, 0x75, 0x15, 0x48, 0x63, 0xd0, 0x48, 0x89,
+    0x97, 0x00, 0x00, 0x00, 0x00, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x66, 0x0f,
+    0x1f, 0x44, 0x00, 0x00, 0x48, 0x98, 0x48, 0x63, 0xca, 0x48, 0x99, 0x48,
+    0xf7, 0xf9, 0x48, 0x89, 0x97, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_remuw_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 24, hole_rd, R_X86_64_32S, 0 },
+    { 50, hole_rd, R_X86_64_32S, 0 },
+    { 29, hole_continue, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_remuw_code[] = {
+    0x48, 0x8b, 0x8f, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x85, 0xc9, 0x75, 0x15, 0x48, 0x98, 0x48, 0x89, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x80,
+    0x00, 0x00, 0x00, 0x00, 0x31, 0xd2, 0xf7, 0xf1, 0x48, 0x63, 0xc2, 0x48,
+    0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_beq_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_continue, R_X86_64_PC32, -4 },
+    { 25, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_beq_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x74, 0x08, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x00,
+    0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_bne_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_bne_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x74, 0x08, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x00,
+};
+
+static const stencil_hole_t stencil_blt_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_continue, R_X86_64_PC32, -4 },
+    { 25, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_blt_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x7c, 0x08, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x00,
+    0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_bge_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_continue, R_X86_64_PC32, -4 },
+    { 25, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_bge_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x7d, 0x08, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x00,
+    0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_bltu_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_continue, R_X86_64_PC32, -4 },
+    { 25, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_bltu_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x72, 0x08, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x00,
+    0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_bgeu_holes[] = {
+    { 3, hole_rs2, R_X86_64_32S, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_continue, R_X86_64_PC32, -4 },
+    { 25, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_bgeu_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x39, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x73, 0x08, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x1f, 0x00,
+    0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_jal_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rd, R_X86_64_32S, 0 },
+    { 15, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_jal_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_j_holes[] = {
+    { 1, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_j_code[] = {
+    0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_flw_holes[] = {
+    { 11, hole_imm, R_X86_64_32, 0 },
+    { 23, hole_rs1, R_X86_64_32S, 0 },
+    { 35, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_flw_code[] = {
+    0x48, 0xba, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xb8, 0x00,
+    0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00,
+    0x00, 0x00, 0x00, 0x8b, 0x00, 0x48, 0x09, 0xd0, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fld_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 13, hole_rs1, R_X86_64_32S, 0 },
+    { 23, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fld_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03,
+    0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x00, 0x48, 0x89, 0x87, 0x00,
+    0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fsw_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 8, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_rs1, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fsw_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x89, 0x10,
+};
+
+static const stencil_hole_t stencil_fsd_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 8, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_rs1, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fsd_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8b, 0x97, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x98, 0x48, 0x01, 0xf0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x89, 0x10,
+};
+
+static const stencil_hole_t stencil_fadd_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fadd_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x58, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fsub_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fsub_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x5c, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmul_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmul_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x59, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fdiv_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fdiv_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x5e, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmadd_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frs3, R_X86_64_32S, 0 },
+    { 28, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmadd_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x59, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x58, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmsub_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frs3, R_X86_64_32S, 0 },
+    { 28, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmsub_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x59, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x5c, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fnmsub_s_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frs3, R_X86_64_32S, 0 },
+    { 32, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fnmsub_s_code[] = {
+    0xf3, 0x0f, 0x10, 0x8f, 0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x59, 0x8f,
+    0x00, 0x00, 0x00, 0x00, 0xf3, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0xf3, 0x0f, 0x5c, 0xc1, 0xf3, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fadd_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fadd_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x58, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fsub_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fsub_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x5c, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmul_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmul_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x59, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fdiv_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fdiv_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x5e, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmadd_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frs3, R_X86_64_32S, 0 },
+    { 28, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmadd_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x59, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x58, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmsub_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frs3, R_X86_64_32S, 0 },
+    { 28, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmsub_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x59, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x5c, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fnmsub_d_holes[] = {
+    { 4, hole_frs1, R_X86_64_32S, 0 },
+    { 12, hole_frs2, R_X86_64_32S, 0 },
+    { 20, hole_frs3, R_X86_64_32S, 0 },
+    { 32, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fnmsub_d_code[] = {
+    0xf2, 0x0f, 0x10, 0x8f, 0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x59, 0x8f,
+    0x00, 0x00, 0x00, 0x00, 0xf2, 0x0f, 0x10, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0xf2, 0x0f, 0x5c, 0xc1, 0xf2, 0x0f, 0x11, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmv_x_w_holes[] = {
+    { 3, hole_frs1, R_X86_64_32S, 0 },
+    { 10, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmv_x_w_code[] = {
+    0x48, 0x63, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmv_w_x_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 9, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmv_w_x_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x89, 0x87, 0x00, 0x00, 0x00,
+    0x00,
+};
+
+static const stencil_hole_t stencil_fmv_x_d_holes[] = {
+    { 3, hole_frs1, R_X86_64_32S, 0 },
+    { 10, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmv_x_d_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_fmv_d_x_holes[] = {
+    { 3, hole_rs1, R_X86_64_32S, 0 },
+    { 10, hole_frd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_fmv_d_x_code[] = {
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_slli_srli_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 6, hole_imm2, R_X86_64_32, 0 },
+    { 15, hole_rs1, R_X86_64_32S, 0 },
+    { 30, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_slli_srli_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0xba, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08,
+    0x48, 0x8b, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0xd3, 0xe0, 0x8d, 0x0a,
+    0x48, 0xd3, 0xe8, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_slli_add_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 20, hole_rs2, R_X86_64_32S, 0 },
+    { 27, hole_rd, R_X86_64_32S, 0 },
+};
+static const uint8_t stencil_slli_add_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x8d, 0x08, 0x48, 0x8b, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0xd3, 0xe0, 0x48, 0x03, 0x87, 0x00, 0x00, 0x00, 0x00,
+    0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_addi_bne_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+    { 24, hole_rs2, R_X86_64_32S, 0 },
+    { 31, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_addi_bne_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x03, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x3b, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0x74, 0x0a, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f,
+    0x1f, 0x44, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_addi_blt_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+    { 24, hole_rs2, R_X86_64_32S, 0 },
+    { 31, hole_continue, R_X86_64_PC32, -4 },
+    { 41, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_addi_blt_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x03, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x3b, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0x7c, 0x0a, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f,
+    0x1f, 0x44, 0x00, 0x00, 0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_hole_t stencil_addi_bltu_holes[] = {
+    { 1, hole_imm, R_X86_64_32, 0 },
+    { 10, hole_rs1, R_X86_64_32S, 0 },
+    { 17, hole_rd, R_X86_64_32S, 0 },
+    { 24, hole_rs2, R_X86_64_32S, 0 },
+    { 31, hole_continue, R_X86_64_PC32, -4 },
+    { 41, hole_taken, R_X86_64_PC32, -4 },
+};
+static const uint8_t stencil_addi_bltu_code[] = {
+    0xb8, 0x00, 0x00, 0x00, 0x00, 0x48, 0x98, 0x48, 0x03, 0x87, 0x00, 0x00,
+    0x00, 0x00, 0x48, 0x89, 0x87, 0x00, 0x00, 0x00, 0x00, 0x48, 0x3b, 0x87,
+    0x00, 0x00, 0x00, 0x00, 0x72, 0x0a, 0xe9, 0x00, 0x00, 0x00, 0x00, 0x0f,
+    0x1f, 0x44, 0x00, 0x00, 0xe9, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const stencil_t stencils[num_insns] = {
+    [inst_lb] = { stencil_lb_code, sizeof(stencil_lb_code), stencil_lb_holes, ARRAY_SIZE(stencil_lb_holes) },
+    [inst_lh] = { stencil_lh_code, sizeof(stencil_lh_code), stencil_lh_holes, ARRAY_SIZE(stencil_lh_holes) },
+    [inst_lw] = { stencil_lw_code, sizeof(stencil_lw_code), stencil_lw_holes, ARRAY_SIZE(stencil_lw_holes) },
+    [inst_ld] = { stencil_ld_code, sizeof(stencil_ld_code), stencil_ld_holes, ARRAY_SIZE(stencil_ld_holes) },
+    [inst_lbu] = { stencil_lbu_code, sizeof(stencil_lbu_code), stencil_lbu_holes, ARRAY_SIZE(stencil_lbu_holes) },
+    [inst_lhu] = { stencil_lhu_code, sizeof(stencil_lhu_code), stencil_lhu_holes, ARRAY_SIZE(stencil_lhu_holes) },
+    [inst_lwu] = { stencil_lwu_code, sizeof(stencil_lwu_code), stencil_lwu_holes, ARRAY_SIZE(stencil_lwu_holes) },
+    [inst_sb] = { stencil_sb_code, sizeof(stencil_sb_code), stencil_sb_holes, ARRAY_SIZE(stencil_sb_holes) },
+    [inst_sh] = { stencil_sh_code, sizeof(stencil_sh_code), stencil_sh_holes, ARRAY_SIZE(stencil_sh_holes) },
+    [inst_sw] = { stencil_sw_code, sizeof(stencil_sw_code), stencil_sw_holes, ARRAY_SIZE(stencil_sw_holes) },
+    [inst_sd] = { stencil_sd_code, sizeof(stencil_sd_code), stencil_sd_holes, ARRAY_SIZE(stencil_sd_holes) },
+    [inst_addi] = { stencil_addi_code, sizeof(stencil_addi_code), stencil_addi_holes, ARRAY_SIZE(stencil_addi_holes) },
+    [inst_slli] = { stencil_slli_code, sizeof(stencil_slli_code), stencil_slli_holes, ARRAY_SIZE(stencil_slli_holes) },
+    [inst_slti] = { stencil_slti_code, sizeof(stencil_slti_code), stencil_slti_holes, ARRAY_SIZE(stencil_slti_holes) },
+    [inst_sltiu] = { stencil_sltiu_code, sizeof(stencil_sltiu_code), stencil_sltiu_holes, ARRAY_SIZE(stencil_sltiu_holes) },
+    [inst_xori] = { stencil_xori_code, sizeof(stencil_xori_code), stencil_xori_holes, ARRAY_SIZE(stencil_xori_holes) },
+    [inst_srli] = { stencil_srli_code, sizeof(stencil_srli_code), stencil_srli_holes, ARRAY_SIZE(stencil_srli_holes) },
+    [inst_srai] = { stencil_srai_code, sizeof(stencil_srai_code), stencil_srai_holes, ARRAY_SIZE(stencil_srai_holes) },
+    [inst_ori] = { stencil_ori_code, sizeof(stencil_ori_code), stencil_ori_holes, ARRAY_SIZE(stencil_ori_holes) },
+    [inst_andi] = { stencil_andi_code, sizeof(stencil_andi_code), stencil_andi_holes, ARRAY_SIZE(stencil_andi_holes) },
+    [inst_addiw] = { stencil_addiw_code, sizeof(stencil_addiw_code), stencil_addiw_holes, ARRAY_SIZE(stencil_addiw_holes) },
+    [inst_slliw] = { stencil_slliw_code, sizeof(stencil_slliw_code), stencil_slliw_holes, ARRAY_SIZE(stencil_slliw_holes) },
+    [inst_srliw] = { stencil_srliw_code, sizeof(stencil_srliw_code), stencil_srliw_holes, ARRAY_SIZE(stencil_srliw_holes) },
+    [inst_sraiw] = { stencil_sraiw_code, sizeof(stencil_sraiw_code), stencil_sraiw_holes, ARRAY_SIZE(stencil_sraiw_holes) },
+    [inst_lui] = { stencil_lui_code, sizeof(stencil_lui_code), stencil_lui_holes, ARRAY_SIZE(stencil_lui_holes) },
+    [inst_auipc] = { stencil_auipc_code, sizeof(stencil_auipc_code), stencil_auipc_holes, ARRAY_SIZE(stencil_auipc_holes) },
+    [inst_add] = { stencil_add_code, sizeof(stencil_add_code), stencil_add_holes, ARRAY_SIZE(stencil_add_holes) },
+    [inst_sub] = { stencil_sub_code, sizeof(stencil_sub_code), stencil_sub_holes, ARRAY_SIZE(stencil_sub_holes) },
+    [inst_sll] = { stencil_sll_code, sizeof(stencil_sll_code), stencil_sll_holes, ARRAY_SIZE(stencil_sll_holes) },
+    [inst_slt] = { stencil_slt_code, sizeof(stencil_slt_code), stencil_slt_holes, ARRAY_SIZE(stencil_slt_holes) },
+    [inst_sltu] = { stencil_sltu_code, sizeof(stencil_sltu_code), stencil_sltu_holes, ARRAY_SIZE(stencil_sltu_holes) },
+    [inst_xor] = { stencil_xor_code, sizeof(stencil_xor_code), stencil_xor_holes, ARRAY_SIZE(stencil_xor_holes) },
+    [inst_srl] = { stencil_srl_code, sizeof(stencil_srl_code), stencil_srl_holes, ARRAY_SIZE(stencil_srl_holes) },
+    [inst_sra] = { stencil_sra_code, sizeof(stencil_sra_code), stencil_sra_holes, ARRAY_SIZE(stencil_sra_holes) },
+    [inst_or] = { stencil_or_code, sizeof(stencil_or_code), stencil_or_holes, ARRAY_SIZE(stencil_or_holes) },
+    [inst_and] = { stencil_and_code, sizeof(stencil_and_code), stencil_and_holes, ARRAY_SIZE(stencil_and_holes) },
+    [inst_addw] = { stencil_addw_code, sizeof(stencil_addw_code), stencil_addw_holes, ARRAY_SIZE(stencil_addw_holes) },
+    [inst_subw] = { stencil_subw_code, sizeof(stencil_subw_code), stencil_subw_holes, ARRAY_SIZE(stencil_subw_holes) },
+    [inst_sllw] = { stencil_sllw_code, sizeof(stencil_sllw_code), stencil_sllw_holes, ARRAY_SIZE(stencil_sllw_holes) },
+    [inst_srlw] = { stencil_srlw_code, sizeof(stencil_srlw_code), stencil_srlw_holes, ARRAY_SIZE(stencil_srlw_holes) },
+    [inst_sraw] = { stencil_sraw_code, sizeof(stencil_sraw_code), stencil_sraw_holes, ARRAY_SIZE(stencil_sraw_holes) },
+    [inst_mul] = { stencil_mul_code, sizeof(stencil_mul_code), stencil_mul_holes, ARRAY_SIZE(stencil_mul_holes) },
+    [inst_mulh] = { stencil_mulh_code, sizeof(stencil_mulh_code), stencil_mulh_holes, ARRAY_SIZE(stencil_mulh_holes) },
+    [inst_mulhsu] = { stencil_mulhsu_code, sizeof(stencil_mulhsu_code), stencil_mulhsu_holes, ARRAY_SIZE(stencil_mulhsu_holes) },
+    [inst_mulhu] = { stencil_mulhu_code, sizeof(stencil_mulhu_code), stencil_mulhu_holes, ARRAY_SIZE(stencil_mulhu_holes) },
+    [inst_mulw] = { stencil_mulw_code, sizeof(stencil_mulw_code), stencil_mulw_holes, ARRAY_SIZE(stencil_mulw_holes) },
+    [inst_div] = { stencil_div_code, sizeof(stencil_div_code), stencil_div_holes, ARRAY_SIZE(stencil_div_holes) },
+    [inst_divu] = { stencil_divu_code, sizeof(stencil_divu_code), stencil_divu_holes, ARRAY_SIZE(stencil_divu_holes) },
+    [inst_rem] = { stencil_rem_code, sizeof(stencil_rem_code), stencil_rem_holes, ARRAY_SIZE(stencil_rem_holes) },
+    [inst_remu] = { stencil_remu_code, sizeof(stencil_remu_code), stencil_remu_holes, ARRAY_SIZE(stencil_remu_holes) },
+    [inst_divw] = { stencil_divw_code, sizeof(stencil_divw_code), stencil_divw_holes, ARRAY_SIZE(stencil_divw_holes) },
+    [inst_divuw] = { stencil_divuw_code, sizeof(stencil_divuw_code), stencil_divuw_holes, ARRAY_SIZE(stencil_divuw_holes) },
+    [inst_remw] = { stencil_remw_code, sizeof(stencil_remw_code), stencil_remw_holes, ARRAY_SIZE(stencil_remw_holes) },
+    [inst_remuw] = { stencil_remuw_code, sizeof(stencil_remuw_code), stencil_remuw_holes, ARRAY_SIZE(stencil_remuw_holes) },
+    [inst_beq] = { stencil_beq_code, sizeof(stencil_beq_code), stencil_beq_holes, ARRAY_SIZE(stencil_beq_holes) },
+    [inst_bne] = { stencil_bne_code, sizeof(stencil_bne_code), stencil_bne_holes, ARRAY_SIZE(stencil_bne_holes) },
+    [inst_blt] = { stencil_blt_code, sizeof(stencil_blt_code), stencil_blt_holes, ARRAY_SIZE(stencil_blt_holes) },
+    [inst_bge] = { stencil_bge_code, sizeof(stencil_bge_code), stencil_bge_holes, ARRAY_SIZE(stencil_bge_holes) },
+    [inst_bltu] = { stencil_bltu_code, sizeof(stencil_bltu_code), stencil_bltu_holes, ARRAY_SIZE(stencil_bltu_holes) },
+    [inst_bgeu] = { stencil_bgeu_code, sizeof(stencil_bgeu_code), stencil_bgeu_holes, ARRAY_SIZE(stencil_bgeu_holes) },
+    [inst_jal] = { stencil_jal_code, sizeof(stencil_jal_code), stencil_jal_holes, ARRAY_SIZE(stencil_jal_holes) },
+    [inst_j] = { stencil_j_code, sizeof(stencil_j_code), stencil_j_holes, ARRAY_SIZE(stencil_j_holes) },
+    [inst_flw] = { stencil_flw_code, sizeof(stencil_flw_code), stencil_flw_holes, ARRAY_SIZE(stencil_flw_holes) },
+    [inst_fld] = { stencil_fld_code, sizeof(stencil_fld_code), stencil_fld_holes, ARRAY_SIZE(stencil_fld_holes) },
+    [inst_fsw] = { stencil_fsw_code, sizeof(stencil_fsw_code), stencil_fsw_holes, ARRAY_SIZE(stencil_fsw_holes) },
+    [inst_fsd] = { stencil_fsd_code, sizeof(stencil_fsd_code), stencil_fsd_holes, ARRAY_SIZE(stencil_fsd_holes) },
+    [inst_fadd_s] = { stencil_fadd_s_code, sizeof(stencil_fadd_s_code), stencil_fadd_s_holes, ARRAY_SIZE(stencil_fadd_s_holes) },
+    [inst_fsub_s] = { stencil_fsub_s_code, sizeof(stencil_fsub_s_code), stencil_fsub_s_holes, ARRAY_SIZE(stencil_fsub_s_holes) },
+    [inst_fmul_s] = { stencil_fmul_s_code, sizeof(stencil_fmul_s_code), stencil_fmul_s_holes, ARRAY_SIZE(stencil_fmul_s_holes) },
+    [inst_fdiv_s] = { stencil_fdiv_s_code, sizeof(stencil_fdiv_s_code), stencil_fdiv_s_holes, ARRAY_SIZE(stencil_fdiv_s_holes) },
+    [inst_fmadd_s] = { stencil_fmadd_s_code, sizeof(stencil_fmadd_s_code), stencil_fmadd_s_holes, ARRAY_SIZE(stencil_fmadd_s_holes) },
+    [inst_fmsub_s] = { stencil_fmsub_s_code, sizeof(stencil_fmsub_s_code), stencil_fmsub_s_holes, ARRAY_SIZE(stencil_fmsub_s_holes) },
+    [inst_fnmsub_s] = { stencil_fnmsub_s_code, sizeof(stencil_fnmsub_s_code), stencil_fnmsub_s_holes, ARRAY_SIZE(stencil_fnmsub_s_holes) },
+    [inst_fadd_d] = { stencil_fadd_d_code, sizeof(stencil_fadd_d_code), stencil_fadd_d_holes, ARRAY_SIZE(stencil_fadd_d_holes) },
+    [inst_fsub_d] = { stencil_fsub_d_code, sizeof(stencil_fsub_d_code), stencil_fsub_d_holes, ARRAY_SIZE(stencil_fsub_d_holes) },
+    [inst_fmul_d] = { stencil_fmul_d_code, sizeof(stencil_fmul_d_code), stencil_fmul_d_holes, ARRAY_SIZE(stencil_fmul_d_holes) },
+    [inst_fdiv_d] = { stencil_fdiv_d_code, sizeof(stencil_fdiv_d_code), stencil_fdiv_d_holes, ARRAY_SIZE(stencil_fdiv_d_holes) },
+    [inst_fmadd_d] = { stencil_fmadd_d_code, sizeof(stencil_fmadd_d_code), stencil_fmadd_d_holes, ARRAY_SIZE(stencil_fmadd_d_holes) },
+    [inst_fmsub_d] = { stencil_fmsub_d_code, sizeof(stencil_fmsub_d_code), stencil_fmsub_d_holes, ARRAY_SIZE(stencil_fmsub_d_holes) },
+    [inst_fnmsub_d] = { stencil_fnmsub_d_code, sizeof(stencil_fnmsub_d_code), stencil_fnmsub_d_holes, ARRAY_SIZE(stencil_fnmsub_d_holes) },
+    [inst_fmv_x_w] = { stencil_fmv_x_w_code, sizeof(stencil_fmv_x_w_code), stencil_fmv_x_w_holes, ARRAY_SIZE(stencil_fmv_x_w_holes) },
+    [inst_fmv_w_x] = { stencil_fmv_w_x_code, sizeof(stencil_fmv_w_x_code), stencil_fmv_w_x_holes, ARRAY_SIZE(stencil_fmv_w_x_holes) },
+    [inst_fmv_x_d] = { stencil_fmv_x_d_code, sizeof(stencil_fmv_x_d_code), stencil_fmv_x_d_holes, ARRAY_SIZE(stencil_fmv_x_d_holes) },
+    [inst_fmv_d_x] = { stencil_fmv_d_x_code, sizeof(stencil_fmv_d_x_code), stencil_fmv_d_x_holes, ARRAY_SIZE(stencil_fmv_d_x_holes) },
+    [inst_slli_srli] = { stencil_slli_srli_code, sizeof(stencil_slli_srli_code), stencil_slli_srli_holes, ARRAY_SIZE(stencil_slli_srli_holes) },
+    [inst_slli_add] = { stencil_slli_add_code, sizeof(stencil_slli_add_code), stencil_slli_add_holes, ARRAY_SIZE(stencil_slli_add_holes) },
+    [inst_addi_bne] = { stencil_addi_bne_code, sizeof(stencil_addi_bne_code), stencil_addi_bne_holes, ARRAY_SIZE(stencil_addi_bne_holes) },
+    [inst_addi_blt] = { stencil_addi_blt_code, sizeof(stencil_addi_blt_code), stencil_addi_blt_holes, ARRAY_SIZE(stencil_addi_blt_holes) },
+    [inst_addi_bltu] = { stencil_addi_bltu_code, sizeof(stencil_addi_bltu_code), stencil_addi_bltu_holes, ARRAY_SIZE(stencil_addi_bltu_holes) },
+};
+
+#define STENCIL_MAX_SIZE 79
+#define STENCIL_MAX_HOLES 6
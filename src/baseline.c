@@ -0,0 +1,290 @@
+#include "rvemu.h"
+
+/*
+ * 基线JIT: 不经过clang, 把block中每条指令对应的机器码模板(stencil)依次拼接起来
+ *
+ * 模板在构建时由src/stencils/stencils.c编译得到(见该文件和stencilgen.c),
+ * 这里只需拷贝模板、填上寄存器偏移和立即数、把分支出口连到本block的出口代码,
+ * 编译一个block只要几微秒, 运行时也不依赖任何外部工具链。
+ * 每条指令仍从state里读源寄存器、算完写回, 不做寄存器分配和跨指令优化。
+ * 没有模板(或立即数放不进模板)的指令生成对funcs[]处理函数的调用。
+ *
+ * 生成的函数与machine_compile产出的一致: block_t *f(state_t *state),
+ * state在整个函数中保存在rdi里, 入口把state->mem读进rsi供访存的模板使用。
+ */
+
+#if defined(__x86_64__)
+
+enum hole_t {
+    hole_rd,
+    hole_rs1,
+    hole_rs2,
+    hole_frd,
+    hole_frs1,
+    hole_frs2,
+    hole_frs3,
+    hole_imm,
+    hole_imm2,
+    hole_continue, // 下一条指令
+    hole_taken,    // 分支跳转/jal的出口
+};
+
+typedef struct {
+    uint32_t offset;
+    enum hole_t hole;
+    uint32_t type; // R_X86_64_32/32S/PC32
+    int64_t addend;
+} stencil_hole_t;
+
+typedef struct {
+    const uint8_t *code;
+    uint32_t size;
+    const stencil_hole_t *holes;
+    uint32_t nholes;
+} stencil_t;
+
+#include "stencils.h"
+
+#define BASELINE_GLUE_MAX_BYTES 64 // 出口或处理函数调用的最大长度
+
+enum { rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi };
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *p;
+} asm_t;
+
+// 分支出口的跳转偏移, 出口代码生成在所有指令之后
+typedef struct {
+    uint8_t *loc;
+    int64_t addend;
+    uint64_t target;
+} fixup_t;
+
+static inline void emit1(asm_t *a, uint8_t v) { *a->p++ = v; }
+
+static inline void emit4(asm_t *a, uint32_t v) {
+    memcpy(a->p, &v, 4);
+    a->p += 4;
+}
+
+static inline void emit8(asm_t *a, uint64_t v) {
+    memcpy(a->p, &v, 8);
+    a->p += 8;
+}
+
+static inline uint32_t gp_disp(int r) {
+    return offsetof(state_t, gp_regs) + r * sizeof(uint64_t);
+}
+
+static inline uint32_t fp_disp(int r) {
+    return offsetof(state_t, fp_regs) + r * sizeof(fp_reg_t);
+}
+
+// op reg, [rdi + disp32], rex为0时是32位操作
+static void emit_rm(asm_t *a, uint8_t rex, uint8_t op, int reg, uint32_t disp) {
+    if (rex)
+        emit1(a, rex);
+    emit1(a, op);
+    emit1(a, 0x80 | reg << 3 | rdi);
+    emit4(a, disp);
+}
+
+static void mov_imm64(asm_t *a, int reg, uint64_t imm) {
+    emit1(a, 0x48);
+    emit1(a, 0xb8 + reg);
+    emit8(a, imm);
+}
+
+// mov qword [rdi + disp32], imm
+static void store_imm(asm_t *a, uint32_t disp, uint64_t imm) {
+    if ((int64_t)imm == (int32_t)imm) {
+        emit_rm(a, 0x48, 0xc7, 0, disp);
+        emit4(a, (uint32_t)imm);
+    } else {
+        mov_imm64(a, rax, imm);
+        emit_rm(a, 0x48, 0x89, rax, disp);
+    }
+}
+
+static void emit_return(asm_t *a, block_t *block) {
+    mov_imm64(a, rax, (uint64_t)block);
+    emit1(a, 0xc3); // ret
+}
+
+// 设置exit_reason/reenter_pc, 返回block
+static void emit_exit(
+    asm_t *a, block_t *block, enum exit_reason_t reason, uint64_t target
+) {
+    emit_rm(a, 0, 0xc7, 0, offsetof(state_t, exit_reason));
+    emit4(a, reason);
+    store_imm(a, offsetof(state_t, reenter_pc), target);
+    emit_return(a, block);
+}
+
+// mov rsi, [rdi + offsetof(state_t, mem)]
+static void load_mem_base(asm_t *a) {
+    emit_rm(a, 0x48, 0x8b, rsi, offsetof(state_t, mem));
+}
+
+// add qword [rdi + offsetof(state_t, icount)], n
+static void count_insts(asm_t *a, uint32_t n) {
+    emit_rm(a, 0x48, 0x81, 0, offsetof(state_t, icount));
+    emit4(a, n);
+}
+
+// 设置好state->pc后调用解释器的处理函数, 前后保存rdi(同时让栈按16字节对齐)
+static void emit_call(asm_t *a, inst_t *inst, uint64_t pc) {
+    store_imm(a, offsetof(state_t, pc), pc);
+    emit1(a, 0x57); // push rdi
+    emit1(a, 0x48); // mov rsi, inst
+    emit1(a, 0xbe);
+    emit8(a, (uint64_t)inst);
+    mov_imm64(a, rax, (uint64_t)funcs[inst->type]);
+    emit1(a, 0xff); // call rax
+    emit1(a, 0xd0);
+    emit1(a, 0x5f); // pop rdi
+    load_mem_base(a);
+}
+
+// 拷贝模板并填上空洞, 跳到出口的位置记进fixups, 出口目标是target
+static void emit_stencil(
+    asm_t *a, const stencil_t *st, inst_t *inst, int32_t imm, uint64_t target,
+    fixup_t *fixups, uint32_t *nfixups
+) {
+    uint8_t *base = a->p;
+    memcpy(base, st->code, st->size);
+    a->p += st->size;
+
+    for (uint32_t i = 0; i < st->nholes; i++) {
+        const stencil_hole_t *h = &st->holes[i];
+        uint8_t *loc = base + h->offset;
+        uint64_t val = 0;
+        switch (h->hole) {
+        case hole_rd: val = gp_disp(inst->rd); break;
+        case hole_rs1: val = gp_disp(inst->rs1); break;
+        case hole_rs2: val = gp_disp(inst->rs2); break;
+        case hole_frd: val = fp_disp(inst->rd); break;
+        case hole_frs1: val = fp_disp(inst->rs1); break;
+        case hole_frs2: val = fp_disp(inst->rs2); break;
+        case hole_frs3: val = fp_disp(inst->rs3); break;
+        case hole_imm: val = (uint32_t)imm; break;
+        case hole_imm2: val = (uint32_t)(int32_t)inst->imm2; break;
+        case hole_continue: val = (uint64_t)a->p; break;
+        case hole_taken:
+            fixups[(*nfixups)++] = (fixup_t){ loc, h->addend, target };
+            continue;
+        }
+        // 32/32S只取低32位: 模板里的立即数按int32_t使用, 偏移都是小正数
+        uint32_t v = h->type == R_X86_64_PC32
+                         ? (uint32_t)(val + h->addend - (uint64_t)loc)
+                         : (uint32_t)(val + h->addend);
+        memcpy(loc, &v, 4);
+    }
+}
+
+static void gen_inst(
+    asm_t *a, block_t *block, inst_t *inst, uint64_t pc, fixup_t *fixups,
+    uint32_t *nfixups
+) {
+    uint64_t next_pc = pc + inst->size;
+    uint64_t target = pc + (int64_t)inst_target_offset(inst);
+    // 操作数特化的变体按原指令翻译, 模板里的操作数本来就是常量
+    enum inst_type_t type = inst_generic(inst->type);
+    const stencil_t *st = &stencils[type];
+
+    int64_t imm = (int64_t)inst->imm;
+    if (inst->type == inst_auipc)
+        imm = target;
+    else if (inst->type == inst_jal)
+        imm = next_pc;
+    else if (inst->type >= inst_slli_srli && inst->type <= inst_addi_bltu)
+        imm = inst->imm1; // 融合指令的第二个立即数填进_HOLE_IMM2
+
+    switch (type) {
+    case inst_fence:
+        emit1(a, 0x0f); // mfence, 其它hart要看到之前的store
+        emit1(a, 0xae);
+        emit1(a, 0xf0);
+        return;
+    case inst_nop:
+        return;
+    case inst_jalr:
+    case inst_jr:
+    case inst_ecall:
+    case inst_fence_i:
+        // 处理函数自己设置exit_reason/reenter_pc
+        emit_call(a, inst, pc);
+        emit_return(a, block);
+        return;
+    default:
+        break;
+    }
+
+    if (st->code == NULL || imm != (int32_t)imm) {
+        emit_call(a, inst, pc);
+        if (inst->type == inst_jal)
+            emit_return(a, block);
+        return;
+    }
+
+    emit_stencil(a, st, inst, imm, target, fixups, nfixups);
+}
+
+exec_block_func_t machine_baseline(machine_t *m, block_t *block) {
+    size_t cap = block->len * (STENCIL_MAX_SIZE + BASELINE_GLUE_MAX_BYTES) +
+                 (block->len + 1) * BASELINE_GLUE_MAX_BYTES;
+    asm_t a = { .start = malloc(cap) };
+    a.p = a.start;
+    fixup_t *fixups = malloc(block->len * STENCIL_MAX_HOLES * sizeof(fixup_t));
+    uint32_t nfixups = 0;
+
+    load_mem_base(&a);
+    count_insts(&a, block->ninsts);
+    uint64_t pc = block->pc;
+    inst_t *inst = NULL;
+    for (uint32_t i = 0; i < block->len; i++) {
+        inst = &block->insts[i];
+        gen_inst(&a, block, inst, pc, fixups, &nfixups);
+        pc += inst->size;
+    }
+
+    // 分支未跳转, 或block因长度上限被截断
+    if (!inst_is_jump(inst->type))
+        emit_exit(&a, block, direct_branch, block->end_pc);
+
+    // 分支出口放在函数末尾, 目标相同的出口只生成一份
+    for (uint32_t i = 0; i < nfixups; i++) {
+        uint8_t *stub = a.p;
+        for (uint32_t j = 0; j < i; j++) {
+            if (fixups[j].target == fixups[i].target) {
+                int32_t rel;
+                memcpy(&rel, fixups[j].loc, 4);
+                stub = fixups[j].loc - fixups[j].addend + rel;
+                break;
+            }
+        }
+        if (stub == a.p)
+            emit_exit(&a, block, direct_branch, fixups[i].target);
+        int32_t rel = (int32_t)(stub - fixups[i].loc + fixups[i].addend);
+        memcpy(fixups[i].loc, &rel, 4);
+    }
+
+    size_t size = a.p - a.start;
+    assert(size <= cap);
+    uint8_t *code = cache_alloc_code(m->cache, size);
+    if (code)
+        memcpy(code, a.start, size);
+    free(fixups);
+    free(a.start);
+    return (exec_block_func_t)code;
+}
+
+#else
+
+// 其它宿主架构没有模板, warm block留在解释器里, 直到进入clang层
+exec_block_func_t machine_baseline(machine_t *m, block_t *block) {
+    return NULL;
+}
+
+#endif
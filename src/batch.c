@@ -0,0 +1,322 @@
+#include "rvemu.h"
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
+
+/*
+ * 批量运行: rvemu --batch <任务文件> [-j N] [-o <汇总文件>]
+ *
+ * 任务文件每行是一次guest运行: ELF路径和参数, 以空白分隔(不支持引号),
+ * 可以带上`< 文件`和`> 文件`重定向guest的stdin/stdout, 空行和#开头的行跳过。
+ * 所有任务在同一个宿主进程里由N个线程(默认每个核一个)执行, 没有每次运行的
+ * 进程创建开销; 每个不同的ELF只打开、解析一次(program_open),
+ * 之后的machine直接从解析好的段映射, 磁盘翻译缓存也只打开一次,
+ * 同一个程序的machine还共用clang的编译结果(见compile.c)。
+ *
+ * 开始前任务按文件顺序切成N段, 作为各线程双端队列的初始内容。线程从自己队列的
+ * 尾部取任务, 队列空了就从别的队列头部偷。不会再有新任务入队, 所以队列就是
+ * 任务数组里的一个区间; 一个任务至少要运行几毫秒, 每个队列一把锁就够了。
+ *
+ * 全部结束后按任务文件的顺序写汇总文件(默认<任务文件>.summary),
+ * 每行是以tab分隔的行号、退出码、耗时(微秒)、执行的guest指令数和命令。
+ * 所有任务的退出码都是0时返回0, 否则返回1。
+ * guest在一个宿主进程里运行, 让模拟器本身退出的错误(段错误、
+ * 不支持的系统调用等)会结束整个批次。
+ */
+
+#define BATCH_PROGRAM_BUCKETS 1024
+
+typedef struct {
+    int line;  // 在任务文件中的行号
+    char *cmd; // 任务文件中的原文, 写进汇总
+    program_t *prog;
+    int argc;
+    char **argv; // argv[0]占位, 与rvemu自己的命令行一致, 见machine_setup
+    char *in;    // stdin/stdout重定向到的文件, 没有时为NULL
+    char *out;
+    int exit_code;
+    uint64_t wall_us;
+    uint64_t icount;
+} batch_job_t;
+
+// 一个线程的任务队列: jobs[top, bottom)还没开始, 自己从bottom取, 别人从top偷
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t top;
+    uint64_t bottom;
+} batch_deque_t;
+
+typedef struct program_entry_t {
+    struct program_entry_t *next;
+    char *path;
+    program_t *prog;
+} program_entry_t;
+
+typedef struct {
+    batch_job_t *jobs;
+    uint64_t njobs;
+    batch_deque_t *deques;
+    int nthreads;
+    program_entry_t *programs[BATCH_PROGRAM_BUCKETS]; // 按路径查已打开的程序
+} batch_t;
+
+typedef struct {
+    batch_t *batch;
+    int id;
+} batch_worker_t;
+
+static uint64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: rvemu --batch <jobs> [-j N] [-o <summary>]\n");
+    exit(1);
+}
+
+// 同一个路径只打开一次
+static program_t *batch_program(batch_t *b, const char *path) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char *p = path; *p; p++)
+        h = (h ^ (uint8_t)*p) * 0x100000001b3ULL;
+    program_entry_t **bucket = &b->programs[h % BATCH_PROGRAM_BUCKETS];
+    for (program_entry_t *e = *bucket; e; e = e->next) {
+        if (strcmp(e->path, path) == 0)
+            return e->prog;
+    }
+
+    program_entry_t *e = calloc(1, sizeof(program_entry_t));
+    e->path = strdup(path);
+    e->prog = program_open(path);
+    e->next = *bucket;
+    *bucket = e;
+    return e->prog;
+}
+
+// 把一行拆成ELF、参数和重定向, 空行返回false
+static bool parse_job(
+    batch_t *b, batch_job_t *job, char *line, const char *file, int lineno
+) {
+    char *cmd = line;
+    while (isspace((uint8_t)*cmd))
+        cmd++;
+    size_t len = strlen(cmd);
+    while (len > 0 && isspace((uint8_t)cmd[len - 1]))
+        cmd[--len] = '\0';
+    if (len == 0 || cmd[0] == '#')
+        return false;
+
+    *job = (batch_job_t){ .line = lineno, .cmd = strdup(cmd) };
+    job->argv = calloc(len + 2, sizeof(char *)); // 参数不会比字符多
+    job->argv[job->argc++] = "rvemu";
+
+    char **redirect = NULL;
+    for (char *tok = strtok(cmd, " \t"); tok; tok = strtok(NULL, " \t")) {
+        if (redirect == NULL && (*tok == '<' || *tok == '>')) {
+            redirect = *tok == '<' ? &job->in : &job->out;
+            if (*++tok == '\0')
+                continue; // 文件名是下一个词
+        }
+        if (redirect) {
+            *redirect = strdup(tok);
+            redirect = NULL;
+        } else {
+            job->argv[job->argc++] = strdup(tok);
+        }
+    }
+    if (redirect)
+        fatalf("%s:%d: missing file name after redirect", file, lineno);
+    if (job->argc == 1)
+        fatalf("%s:%d: missing program", file, lineno);
+
+    job->prog = batch_program(b, job->argv[1]);
+    return true;
+}
+
+static void read_jobs(batch_t *b, const char *file) {
+    FILE *fp = fopen(file, "r");
+    if (fp == NULL)
+        fatalf("%s: %s", file, strerror(errno));
+
+    uint64_t cap = 0;
+    char *line = NULL;
+    size_t n = 0;
+    for (int lineno = 1; getline(&line, &n, fp) != -1; lineno++) {
+        if (b->njobs == cap) {
+            cap = cap ? cap * 2 : 64;
+            b->jobs = realloc(b->jobs, cap * sizeof(batch_job_t));
+        }
+        if (parse_job(b, &b->jobs[b->njobs], line, file, lineno))
+            b->njobs++;
+    }
+    free(line);
+    fclose(fp);
+}
+
+// 别的任务正在自己的线程上启动编译器, 打开的文件不能漏给它们
+static int open_redirect(batch_job_t *job, const char *path, int flags) {
+    int fd = open(path, flags | O_CLOEXEC, 0644);
+    if (fd == -1)
+        fprintf(stderr, "job %d: %s: %s\n", job->line, path, strerror(errno));
+    return fd;
+}
+
+// 在当前线程上从头到尾运行一个任务, 重定向的文件打不开时退出码记为-1
+static void run_job(batch_job_t *job) {
+    uint64_t start = now_us();
+    int in = -1, out = -1;
+    job->exit_code = -1;
+    if (job->in && (in = open_redirect(job, job->in, O_RDONLY)) == -1)
+        goto out;
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (job->out && (out = open_redirect(job, job->out, flags)) == -1)
+        goto out;
+
+    machine_t *m = calloc(1, sizeof(machine_t));
+    machine_load_program(m, job->prog);
+    if (in != -1)
+        machine_set_fd(m, STDIN_FILENO, in);
+    if (out != -1)
+        machine_set_fd(m, STDOUT_FILENO, out);
+    machine_setup(m, job->argc, job->argv);
+    job->exit_code = machine_run(m);
+    job->icount = m->icount;
+    machine_free(m);
+    free(m);
+
+out:
+    if (in != -1)
+        close(in);
+    if (out != -1)
+        close(out);
+    job->wall_us = now_us() - start;
+}
+
+static int64_t deque_pop(batch_deque_t *d) {
+    int64_t i = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->top < d->bottom)
+        i = --d->bottom;
+    pthread_mutex_unlock(&d->lock);
+    return i;
+}
+
+static int64_t deque_steal(batch_deque_t *d) {
+    int64_t i = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->top < d->bottom)
+        i = d->top++;
+    pthread_mutex_unlock(&d->lock);
+    return i;
+}
+
+// 从下一个线程开始依次找还有任务的队列, 都空了说明所有任务都已开始
+static int64_t steal(batch_t *b, int self) {
+    for (int k = 1; k < b->nthreads; k++) {
+        int64_t i = deque_steal(&b->deques[(self + k) % b->nthreads]);
+        if (i >= 0)
+            return i;
+    }
+    return -1;
+}
+
+static void *batch_worker(void *arg) {
+    batch_worker_t *w = arg;
+    batch_t *b = w->batch;
+    int64_t i;
+    while ((i = deque_pop(&b->deques[w->id])) >= 0 ||
+           (i = steal(b, w->id)) >= 0)
+        run_job(&b->jobs[i]);
+    return NULL;
+}
+
+static void write_summary(batch_t *b, const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        fatalf("%s: %s", path, strerror(errno));
+    fprintf(fp, "# line\texit\twall_us\tinsns\tcommand\n");
+    for (uint64_t i = 0; i < b->njobs; i++) {
+        batch_job_t *job = &b->jobs[i];
+        fprintf(
+            fp,
+            "%d\t%d\t%" PRIu64 "\t%" PRIu64 "\t%s\n",
+            job->line,
+            job->exit_code,
+            job->wall_us,
+            job->icount,
+            job->cmd
+        );
+    }
+    if (fclose(fp) != 0)
+        fatalf("%s: %s", path, strerror(errno));
+}
+
+int batch_main(int argc, char *argv[]) {
+    if (argc < 3)
+        usage();
+    const char *jobs = argv[2];
+    const char *summary = NULL;
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            nthreads = strtol(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            summary = argv[++i];
+        else
+            usage();
+    }
+    if (nthreads < 1)
+        usage();
+
+    char buf[PATH_MAX];
+    if (summary == NULL) {
+        if (snprintf(buf, sizeof(buf), "%s.summary", jobs) >= (int)sizeof(buf))
+            fatal("summary path too long");
+        summary = buf;
+    }
+
+    // 每个核都已经在跑任务, 每个machine再开编译线程只会互相抢占,
+    // 没有指定时热代码就在任务自己的线程上编译
+    setenv("RVEMU_JIT_WORKERS", "0", 0);
+
+    batch_t *b = calloc(1, sizeof(batch_t));
+    read_jobs(b, jobs);
+    b->nthreads = MIN(nthreads, MAX(b->njobs, 1));
+    b->deques = calloc(b->nthreads, sizeof(batch_deque_t));
+    for (int i = 0; i < b->nthreads; i++) {
+        batch_deque_t *d = &b->deques[i];
+        pthread_mutex_init(&d->lock, NULL);
+        d->top = b->njobs * i / b->nthreads;
+        d->bottom = b->njobs * (i + 1) / b->nthreads;
+    }
+
+    pthread_t *threads = calloc(b->nthreads, sizeof(pthread_t));
+    batch_worker_t *workers = calloc(b->nthreads, sizeof(batch_worker_t));
+    for (int i = 0; i < b->nthreads; i++) {
+        workers[i] = (batch_worker_t){ .batch = b, .id = i };
+        if (pthread_create(&threads[i], NULL, batch_worker, &workers[i]) != 0)
+            fatal("cannot create a batch thread");
+    }
+    for (int i = 0; i < b->nthreads; i++)
+        pthread_join(threads[i], NULL);
+
+    write_summary(b, summary);
+
+    int code = 0;
+    for (uint64_t i = 0; i < b->njobs; i++) {
+        if (b->jobs[i].exit_code != 0)
+            code = 1;
+    }
+    for (int i = 0; i < BATCH_PROGRAM_BUCKETS; i++) {
+        for (program_entry_t *e = b->programs[i]; e;) {
+            program_entry_t *next = e->next;
+            program_close(e->prog);
+            free(e->path);
+            free(e);
+            e = next;
+        }
+    }
+    return code;
+}
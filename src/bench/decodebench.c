@@ -0,0 +1,132 @@
+#include "rvemu.h"
+#include <time.h>
+
+/*
+ * 解码的微基准: 比较逐条decode_try(decode_inst去掉非法指令检查)与decode_batch
+ * 每秒解码的条数, 并检查两者的结果逐字段一致。
+ *
+ *   decodebench [file]
+ *
+ * 给出文件时按2字节步长取其中的每个位置(与预解码相同, 包括数据和4字节指令的后半),
+ * 否则用随机生成的指令字, 其中3/4是常见的32位整数指令, 其余是任意的16位编码。
+ */
+
+#define BENCH_WORDS (1 << 20)
+#define BENCH_SECONDS 0.5
+
+static const uint32_t opcodes[] = {
+    0x03, 0x13, 0x17, 0x1b, 0x23, 0x33, 0x37, 0x3b, 0x63, 0x67, 0x6f,
+};
+
+static const uint32_t funct7s[] = { 0x00, 0x01, 0x20 };
+
+static uint64_t rng = 0x2545f4914f6cdd1dULL;
+
+static uint32_t next_random() {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng >> 32;
+}
+
+static uint32_t *synthetic(uint32_t *n) {
+    uint32_t *words = calloc(BENCH_WORDS, sizeof(uint32_t));
+    for (uint32_t i = 0; i < BENCH_WORDS; i++) {
+        uint32_t w = next_random();
+        if (w % 4 != 0) {
+            w = (w & ~0x7fU) | opcodes[w % ARRAY_SIZE(opcodes)];
+            // R型指令的funct7取合法值
+            uint32_t op = w & 0x7f;
+            if (op == 0x33 || op == 0x3b)
+                w = (w & 0x01ffffff) | funct7s[next_random() % 3] << 25;
+        } else {
+            w &= 0xffff;
+        }
+        words[i] = w;
+    }
+    *n = BENCH_WORDS;
+    return words;
+}
+
+static uint32_t *from_file(const char *path, uint32_t *n) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        fatalf("cannot open %s", path);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 4)
+        fatalf("%s is too small", path);
+
+    uint8_t *bytes = malloc(size);
+    if (fread(bytes, 1, size, f) != (size_t)size)
+        fatalf("cannot read %s", path);
+    fclose(f);
+
+    *n = (size - 2) / 2;
+    uint32_t *words = calloc(*n, sizeof(uint32_t));
+    for (uint32_t i = 0; i < *n; i++)
+        memcpy(&words[i], bytes + 2 * i, 4);
+    free(bytes);
+    return words;
+}
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static bool same(inst_t *a, inst_t *b) {
+    return a->rd == b->rd && a->rs1 == b->rs1 && a->rs2 == b->rs2 &&
+           a->imm == b->imm && a->type == b->type && a->size == b->size &&
+           a->continue_exec == b->continue_exec;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t n;
+    uint32_t *words = argc > 1 ? from_file(argv[1], &n) : synthetic(&n);
+    inst_t *scalar = calloc(n, sizeof(inst_t));
+    inst_t *batch = calloc(n, sizeof(inst_t));
+    bool *ok_scalar = calloc(n, sizeof(bool));
+    bool *ok_batch = calloc(n, sizeof(bool));
+
+    uint32_t decoded = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        scalar[i] = (inst_t){ 0 };
+        ok_scalar[i] = decode_try(&scalar[i], words[i]);
+        decoded += ok_scalar[i];
+    }
+    decode_batch(batch, words, n, ok_batch);
+    for (uint32_t i = 0; i < n; i++) {
+        if (ok_scalar[i] != ok_batch[i] ||
+            (ok_scalar[i] && !same(&scalar[i], &batch[i])))
+            fatalf("mismatch at word %u: %08x", i, words[i]);
+    }
+    printf("%u words, %u decodable, results match\n", n, decoded);
+
+    uint64_t rounds = 0;
+    double t0 = now(), t1;
+    do {
+        for (uint32_t i = 0; i < n; i++)
+            ok_scalar[i] = decode_try(&scalar[i], words[i]);
+        rounds++;
+    } while ((t1 = now()) - t0 < BENCH_SECONDS);
+    double scalar_rate = rounds * n / (t1 - t0);
+
+    rounds = 0;
+    t0 = now();
+    do {
+        decode_batch(batch, words, n, ok_batch);
+        rounds++;
+    } while ((t1 = now()) - t0 < BENCH_SECONDS);
+    double batch_rate = rounds * n / (t1 - t0);
+
+    printf("decode_inst:  %8.1f M decodes/s\n", scalar_rate / 1e6);
+    printf(
+        "decode_batch: %8.1f M decodes/s (%.2fx)\n",
+        batch_rate / 1e6,
+        batch_rate / scalar_rate
+    );
+    return 0;
+}
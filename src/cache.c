@@ -0,0 +1,136 @@
+#include "rvemu.h"
+
+#define CACHE_INIT_CAPACITY (16 * 1024)
+#define CACHE_JITCODE_SIZE (64 * 1024 * 1024)
+
+// 指令至少2字节对齐, pc的最低位恒为0, 先去掉再做乘法散列
+static inline uint64_t hash(uint64_t pc) {
+    return (pc >> 1) * 0x9e3779b97f4a7c15ULL;
+}
+
+static inline uint64_t slot_of(cache_t *cache, uint64_t pc) {
+    return hash(pc) >> (64 - __builtin_ctzll(cache->capacity));
+}
+
+cache_t *new_cache() {
+    cache_t *cache = calloc(1, sizeof(cache_t));
+    cache->capacity = CACHE_INIT_CAPACITY;
+    cache->table = calloc(cache->capacity, sizeof(cache_entry_t));
+    pthread_mutex_init(&cache->code_lock, NULL);
+    return cache;
+}
+
+// 释放缓存里的block和代码缓存, 已经移出缓存的block不在表里(见smc.c), 不释放
+void cache_free(cache_t *cache) {
+    for (uint64_t i = 0; i < cache->capacity; i++)
+        free(cache->table[i].block);
+    if (cache->jitcode)
+        munmap(cache->jitcode, CACHE_JITCODE_SIZE);
+    pthread_mutex_destroy(&cache->code_lock);
+    free(cache->table);
+    free(cache);
+}
+
+block_t *cache_lookup(cache_t *cache, uint64_t pc) {
+    uint64_t mask = cache->capacity - 1;
+    for (uint64_t i = slot_of(cache, pc);; i = (i + 1) & mask) {
+        cache_entry_t *entry = &cache->table[i];
+        if (entry->block == NULL)
+            return NULL;
+        if (entry->pc == pc)
+            return entry->block;
+    }
+}
+
+static void cache_insert(cache_t *cache, block_t *block) {
+    uint64_t mask = cache->capacity - 1;
+    uint64_t i = slot_of(cache, block->pc);
+    while (cache->table[i].block != NULL)
+        i = (i + 1) & mask;
+    cache->table[i] = (cache_entry_t){ .pc = block->pc, .block = block };
+}
+
+// 负载超过3/4时容量翻倍, 避免线性探测的探测链过长
+static void cache_grow(cache_t *cache) {
+    cache_entry_t *old = cache->table;
+    uint64_t old_capacity = cache->capacity;
+
+    cache->capacity *= 2;
+    cache->table = calloc(cache->capacity, sizeof(cache_entry_t));
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old[i].block != NULL)
+            cache_insert(cache, old[i].block);
+    }
+    free(old);
+}
+
+void cache_add(cache_t *cache, block_t *block) {
+    assert(cache_lookup(cache, block->pc) == NULL);
+    if ((cache->size + 1) * 4 > cache->capacity * 3)
+        cache_grow(cache);
+    cache_insert(cache, block);
+    cache->size++;
+}
+
+/*
+ * 删除pc对应的项, 不存在时什么也不做。
+ * 线性探测不用墓碑: 把探测链上后面的项前移填补空位(backward shift),
+ * 只移动那些原本的槽位不在空位之后的项, 删除后查找不受影响。
+ * 从i开始顺序遍历表时删掉第i项, 后面的项可能移到i, 应重新检查第i项。
+ */
+void cache_remove(cache_t *cache, uint64_t pc) {
+    uint64_t mask = cache->capacity - 1;
+    uint64_t i = slot_of(cache, pc);
+    while (cache->table[i].pc != pc) {
+        if (cache->table[i].block == NULL)
+            return;
+        i = (i + 1) & mask;
+    }
+    if (cache->table[i].block == NULL)
+        return;
+
+    for (uint64_t j = i;;) {
+        cache->table[i] = (cache_entry_t){ 0 };
+        uint64_t k;
+        do {
+            j = (j + 1) & mask;
+            if (cache->table[j].block == NULL) {
+                cache->size--;
+                return;
+            }
+            k = slot_of(cache, cache->table[j].pc);
+            // k在(i, j]之间(考虑绕回)时第j项留在原处
+        } while (i <= j ? i < k && k <= j : i < k || k <= j);
+        cache->table[i] = cache->table[j];
+        i = j;
+    }
+}
+
+// 从代码缓存中分配size字节(16字节对齐), 缓存用完后返回NULL, 之后只解释执行
+uint8_t *cache_alloc_code(cache_t *cache, uint64_t size) {
+    pthread_mutex_lock(&cache->code_lock);
+    uint8_t *code = NULL;
+    if (cache->jitcode == NULL) {
+        void *p = mmap(
+            NULL,
+            CACHE_JITCODE_SIZE,
+            PROT_READ | PROT_WRITE | PROT_EXEC,
+            MAP_ANONYMOUS | MAP_PRIVATE,
+            -1,
+            0
+        );
+        if (p == MAP_FAILED)
+            goto out;
+        cache->jitcode = p;
+    }
+
+    uint64_t offset = ROUNDUP(cache->offset, 16);
+    if (offset + size <= CACHE_JITCODE_SIZE) {
+        cache->offset = offset + size;
+        code = cache->jitcode + offset;
+    }
+
+out:
+    pthread_mutex_unlock(&cache->code_lock);
+    return code;
+}
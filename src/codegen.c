@@ -0,0 +1,930 @@
+#include "rvemu.h"
+#include "str.h"
+
+/*
+ * 将一个热点block(或以它为入口的superblock)翻译成C代码, 交给clang编译(见compile.c)
+ *
+ * 生成的函数只接收state_t *, 返回最后执行的block_t *, 供machine_step链接后继;
+ * 寄存器号、立即数、pc都直接作为常量写进代码, 由clang -O3做常量折叠。
+ * 使用最多的guest寄存器在函数入口读进局部变量, 只在出口写回state_t(见alloc_regs),
+ * 其余寄存器仍直接读写state。指令模板统一写成GP(n)/FP(n), 由每个函数前
+ * 生成的GP_n/FP_n宏决定对应局部变量还是state里的槽位。
+ * state_t的布局通过offsetof写进宏里, 不在生成的代码里重复定义结构体。
+ * 代码里不出现宿主机指针, block_t *通过blocks[]表引用, 装载时才填入,
+ * guest内存按state里的基址访问, 因此编译出的目标文件可以跨进程复用(见pcache.c),
+ * 同一进程里的多个machine也可以共用(见compile.c)。
+ */
+
+static const char *prelude =
+    "typedef signed char int8_t;\n"
+    "typedef unsigned char uint8_t;\n"
+    "typedef short int16_t;\n"
+    "typedef unsigned short uint16_t;\n"
+    "typedef int int32_t;\n"
+    "typedef unsigned int uint32_t;\n"
+    "typedef long long int64_t;\n"
+    "typedef unsigned long long uint64_t;\n"
+    "typedef union { uint64_t v; uint32_t w; double d; float f; } fp_reg_t;\n"
+    "#define GP_MEM(r) (((uint64_t *)((char *)state + %zu))[r])\n"
+    "#define FP_MEM(r) (((fp_reg_t *)((char *)state + %zu))[r])\n"
+    "#define GP(r) GP_##r\n"
+    "#define FP(r) FP_##r\n"
+    "#define EXIT_REASON (*(uint32_t *)((char *)state + %zu))\n"
+    "#define REENTER_PC (*(uint64_t *)((char *)state + %zu))\n"
+    "#define RESERVED (*(_Bool *)((char *)state + %zu))\n"
+    "#define RESERVE_ADDR (*(uint64_t *)((char *)state + %zu))\n"
+    "#define RESERVE_VAL (*(uint64_t *)((char *)state + %zu))\n"
+    "#define MEM_BASE (*(uint64_t *)((char *)state + %zu))\n"
+    "#define ICOUNT (*(uint64_t *)((char *)state + %zu))\n"
+    "#define EXITING (**(_Bool **)((char *)state + %zu))\n"
+    "#define MEM(ty, addr) (*(ty *)((uint64_t)(addr) + mem))\n"
+    "#define EXIT(reason, target) \\\n"
+    "    do { SYNC(); ICOUNT += icount; EXIT_REASON = (reason); "
+    "REENTER_PC = (target); return BLOCK; } while (0)\n"
+    "__attribute__((visibility(\"hidden\"))) void *blocks[%u];\n";
+
+#define EMIT(...) str_appendf(s, __VA_ARGS__)
+
+// 写x0的指令直接丢弃结果
+#define GP_WRITE(fmt, ...)                                                     \
+    if (rd != zero)                                                            \
+        EMIT("    GP(%d) = " fmt ";\n", rd, ##__VA_ARGS__);
+
+#define LOAD(ty)                                                               \
+    GP_WRITE("MEM(" #ty ", GP(%d) + %" PRId64 "LL)", rs1, imm);                \
+    return true;
+
+#define STORE(ty)                                                              \
+    EMIT(                                                                      \
+        "    MEM(" #ty ", GP(%d) + %" PRId64 "LL) = (" #ty ")GP(%d);\n",       \
+        rs1,                                                                   \
+        imm,                                                                   \
+        rs2                                                                    \
+    );                                                                         \
+    return true;
+
+// taken: superblock沿跳转方向继续, 只为不跳转的方向生成出口
+#define BRANCH(cond)                                                           \
+    EMIT(                                                                      \
+        taken ? "    if (!(" cond ")) EXIT(%d, 0x%" PRIx64 "ULL);\n"            \
+              : "    if (" cond ") EXIT(%d, 0x%" PRIx64 "ULL);\n",              \
+        rs1,                                                                   \
+        rs2,                                                                   \
+        direct_branch,                                                         \
+        taken ? next_pc : pc + imm                                             \
+    );                                                                         \
+    return true;
+
+// 融合的addi先写rd, 分支再拿rd与rs2比较(融合时保证rd不是x0)
+#define ADDI_BRANCH(cond)                                                      \
+    GP_WRITE("GP(%d) + %dLL", rs1, inst->imm1);                                \
+    rs1 = rd;                                                                  \
+    imm = inst->imm2;                                                          \
+    BRANCH(cond)
+
+#define FP_STMT(fmt, ...)                                                      \
+    EMIT("    " fmt ";\n", ##__VA_ARGS__);                                     \
+    return true;
+
+/*
+ * A扩展, 与interp.c的处理函数一样用宿主的原子操作, lr/sc的保留也在state里。
+ * 有副作用, rd是x0时也要执行; min/max没有对应的原子操作, 用比较交换循环,
+ * cmp成立时保留内存里的旧值。写回rd的old在sc里是成败(0表示成功)。
+ * 不是A扩展的指令返回false。
+ */
+static bool gen_amo(str_t *s, inst_t *inst) {
+    bool w = inst->type <= inst_amomaxu_w; // isa.h中.w都排在.d之前
+    const char *ty = w ? "uint32_t" : "uint64_t";
+    const char *st = w ? "int32_t" : "int64_t";
+    const char *op = NULL, *cmp = NULL;
+    bool sign = false;
+    switch (inst->type) {
+    case inst_lr_w:
+    case inst_lr_d:
+        EMIT(
+            "    { uint64_t a = GP(%d); %s old = __atomic_load_n(&MEM(%s, a), "
+            "__ATOMIC_SEQ_CST); RESERVED = 1; RESERVE_ADDR = a; "
+            "RESERVE_VAL = old;",
+            inst->rs1, ty, ty
+        );
+        break;
+    case inst_sc_w:
+    case inst_sc_d:
+        EMIT(
+            "    { uint64_t a = GP(%d); %s e = RESERVE_VAL; "
+            "%s old = !(RESERVED && RESERVE_ADDR == a && "
+            "__atomic_compare_exchange_n(&MEM(%s, a), &e, (%s)GP(%d), 0, "
+            "__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)); RESERVED = 0;",
+            inst->rs1, ty, ty, ty, ty, inst->rs2
+        );
+        break;
+    // clang-format off
+    case inst_amoswap_w: case inst_amoswap_d: op = "__atomic_exchange_n"; break;
+    case inst_amoadd_w: case inst_amoadd_d: op = "__atomic_fetch_add"; break;
+    case inst_amoxor_w: case inst_amoxor_d: op = "__atomic_fetch_xor"; break;
+    case inst_amoand_w: case inst_amoand_d: op = "__atomic_fetch_and"; break;
+    case inst_amoor_w: case inst_amoor_d: op = "__atomic_fetch_or"; break;
+    case inst_amomin_w: case inst_amomin_d: cmp = "<"; sign = true; break;
+    case inst_amomax_w: case inst_amomax_d: cmp = ">"; sign = true; break;
+    case inst_amominu_w: case inst_amominu_d: cmp = "<"; break;
+    case inst_amomaxu_w: case inst_amomaxu_d: cmp = ">"; break;
+    // clang-format on
+    default:
+        return false;
+    }
+
+    if (op || cmp)
+        EMIT(
+            "    { %s *p = &MEM(%s, GP(%d)); %s v = (%s)GP(%d), old;", ty, ty,
+            inst->rs1, ty, ty, inst->rs2
+        );
+    if (op) {
+        EMIT(" old = %s(p, v, __ATOMIC_SEQ_CST);", op);
+    } else if (cmp) {
+        EMIT(
+            " old = __atomic_load_n(p, __ATOMIC_RELAXED);"
+            " while (!__atomic_compare_exchange_n(p, &old,"
+            " (%s)old %s (%s)v ? old : v, 1, __ATOMIC_SEQ_CST,"
+            " __ATOMIC_RELAXED));",
+            sign ? st : ty, cmp, sign ? st : ty
+        );
+    }
+    if (inst->rd != zero)
+        EMIT(" GP(%d) = (int64_t)(%s)old;", inst->rd, st);
+    EMIT(" }\n");
+    return true;
+}
+
+// 生成一条指令对应的C语句, 遇到不支持翻译的指令返回false
+static bool gen_inst(str_t *s, inst_t *inst, uint64_t pc, bool taken) {
+    int rd = inst->rd, rs1 = inst->rs1, rs2 = inst->rs2, rs3 = inst->rs3;
+    int64_t imm = inst->imm;
+    uint64_t next_pc = pc + inst->size;
+
+    // 操作数特化的变体按原指令翻译, 操作数本来就以常量写进代码
+    switch (inst_generic(inst->type)) {
+    case inst_lb: LOAD(int8_t);
+    case inst_lh: LOAD(int16_t);
+    case inst_lw: LOAD(int32_t);
+    case inst_ld: LOAD(int64_t);
+    case inst_lbu: LOAD(uint8_t);
+    case inst_lhu: LOAD(uint16_t);
+    case inst_lwu: LOAD(uint32_t);
+    case inst_fence:
+        EMIT("    __atomic_thread_fence(__ATOMIC_SEQ_CST);\n");
+        return true;
+    case inst_nop:
+        return true;
+    case inst_fence_i:
+        EMIT("    EXIT(%d, 0x%" PRIx64 "ULL);\n", fence_i, pc + 4);
+        return true;
+    case inst_addi:
+        GP_WRITE("GP(%d) + %" PRId64 "LL", rs1, imm);
+        return true;
+    case inst_slli:
+        GP_WRITE("GP(%d) << %" PRId64, rs1, imm & 0x3f);
+        return true;
+    case inst_slti:
+        GP_WRITE("(int64_t)GP(%d) < %" PRId64 "LL", rs1, imm);
+        return true;
+    case inst_sltiu:
+        GP_WRITE("GP(%d) < (uint64_t)%" PRId64 "LL", rs1, imm);
+        return true;
+    case inst_xori:
+        GP_WRITE("GP(%d) ^ (uint64_t)%" PRId64 "LL", rs1, imm);
+        return true;
+    case inst_srli:
+        GP_WRITE("GP(%d) >> %" PRId64, rs1, imm & 0x3f);
+        return true;
+    case inst_srai:
+        GP_WRITE("(int64_t)GP(%d) >> %" PRId64, rs1, imm & 0x3f);
+        return true;
+    case inst_ori:
+        GP_WRITE("GP(%d) | (uint64_t)%" PRId64 "LL", rs1, imm);
+        return true;
+    case inst_andi:
+        GP_WRITE("GP(%d) & (uint64_t)%" PRId64 "LL", rs1, imm);
+        return true;
+    case inst_auipc:
+        GP_WRITE("0x%" PRIx64 "ULL", pc + imm);
+        return true;
+    case inst_addiw:
+        GP_WRITE("(int64_t)(int32_t)(GP(%d) + %" PRId64 "LL)", rs1, imm);
+        return true;
+    case inst_slliw:
+        GP_WRITE("(int64_t)(int32_t)(GP(%d) << %" PRId64 ")", rs1, imm & 0x1f);
+        return true;
+    case inst_srliw:
+        GP_WRITE(
+            "(int64_t)(int32_t)((uint32_t)GP(%d) >> %" PRId64 ")",
+            rs1,
+            imm & 0x1f
+        );
+        return true;
+    case inst_sraiw:
+        GP_WRITE("(int64_t)((int32_t)GP(%d) >> %" PRId64 ")", rs1, imm & 0x1f);
+        return true;
+    case inst_sb: STORE(uint8_t);
+    case inst_sh: STORE(uint16_t);
+    case inst_sw: STORE(uint32_t);
+    case inst_sd: STORE(uint64_t);
+    case inst_add:
+        GP_WRITE("GP(%d) + GP(%d)", rs1, rs2);
+        return true;
+    case inst_sll:
+        GP_WRITE("GP(%d) << (GP(%d) & 0x3f)", rs1, rs2);
+        return true;
+    case inst_slt:
+        GP_WRITE("(int64_t)GP(%d) < (int64_t)GP(%d)", rs1, rs2);
+        return true;
+    case inst_sltu:
+        GP_WRITE("GP(%d) < GP(%d)", rs1, rs2);
+        return true;
+    case inst_xor:
+        GP_WRITE("GP(%d) ^ GP(%d)", rs1, rs2);
+        return true;
+    case inst_srl:
+        GP_WRITE("GP(%d) >> (GP(%d) & 0x3f)", rs1, rs2);
+        return true;
+    case inst_or:
+        GP_WRITE("GP(%d) | GP(%d)", rs1, rs2);
+        return true;
+    case inst_and:
+        GP_WRITE("GP(%d) & GP(%d)", rs1, rs2);
+        return true;
+    case inst_mul:
+        GP_WRITE("GP(%d) * GP(%d)", rs1, rs2);
+        return true;
+    case inst_mulh:
+        GP_WRITE(
+            "(uint64_t)(((__int128)(int64_t)GP(%d) * "
+            "(__int128)(int64_t)GP(%d)) >> 64)",
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_mulhsu:
+        GP_WRITE(
+            "(uint64_t)(((__int128)(int64_t)GP(%d) * "
+            "(__int128)GP(%d)) >> 64)",
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_mulhu:
+        GP_WRITE(
+            "(uint64_t)(((unsigned __int128)GP(%d) * GP(%d)) >> 64)", rs1, rs2
+        );
+        return true;
+    case inst_div:
+        GP_WRITE(
+            "GP(%d) == 0 ? ~0ULL : "
+            "((int64_t)GP(%d) == (-0x7fffffffffffffffLL - 1) && "
+            "(int64_t)GP(%d) == -1) ? GP(%d) : "
+            "(uint64_t)((int64_t)GP(%d) / (int64_t)GP(%d))",
+            rs2,
+            rs1,
+            rs2,
+            rs1,
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_divu:
+        GP_WRITE(
+            "GP(%d) == 0 ? ~0ULL : GP(%d) / GP(%d)", rs2, rs1, rs2
+        );
+        return true;
+    case inst_rem:
+        GP_WRITE(
+            "GP(%d) == 0 ? GP(%d) : "
+            "((int64_t)GP(%d) == (-0x7fffffffffffffffLL - 1) && "
+            "(int64_t)GP(%d) == -1) ? 0 : "
+            "(uint64_t)((int64_t)GP(%d) %% (int64_t)GP(%d))",
+            rs2,
+            rs1,
+            rs1,
+            rs2,
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_remu:
+        GP_WRITE("GP(%d) == 0 ? GP(%d) : GP(%d) %% GP(%d)", rs2, rs1, rs1, rs2);
+        return true;
+    case inst_sub:
+        GP_WRITE("GP(%d) - GP(%d)", rs1, rs2);
+        return true;
+    case inst_sra:
+        GP_WRITE("(int64_t)GP(%d) >> (GP(%d) & 0x3f)", rs1, rs2);
+        return true;
+    case inst_lui:
+        GP_WRITE("(int64_t)%" PRId64 "LL", imm);
+        return true;
+    case inst_addw:
+        GP_WRITE("(int64_t)(int32_t)(GP(%d) + GP(%d))", rs1, rs2);
+        return true;
+    case inst_sllw:
+        GP_WRITE("(int64_t)(int32_t)(GP(%d) << (GP(%d) & 0x1f))", rs1, rs2);
+        return true;
+    case inst_srlw:
+        GP_WRITE(
+            "(int64_t)(int32_t)((uint32_t)GP(%d) >> (GP(%d) & 0x1f))", rs1, rs2
+        );
+        return true;
+    case inst_mulw:
+        GP_WRITE("(int64_t)(int32_t)(GP(%d) * GP(%d))", rs1, rs2);
+        return true;
+    case inst_divw:
+        GP_WRITE(
+            "GP(%d) == 0 ? ~0ULL : (uint64_t)(int64_t)(int32_t)"
+            "((int64_t)(int32_t)GP(%d) / (int64_t)(int32_t)GP(%d))",
+            rs2,
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_divuw:
+        GP_WRITE(
+            "GP(%d) == 0 ? ~0ULL : (uint64_t)(int64_t)(int32_t)"
+            "((uint32_t)GP(%d) / (uint32_t)GP(%d))",
+            rs2,
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_remw:
+        GP_WRITE(
+            "GP(%d) == 0 ? (uint64_t)(int64_t)(int32_t)GP(%d) : "
+            "(uint64_t)(int64_t)(int32_t)((int64_t)(int32_t)GP(%d) %% "
+            "(int64_t)(int32_t)GP(%d))",
+            rs2,
+            rs1,
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_remuw:
+        GP_WRITE(
+            "GP(%d) == 0 ? (uint64_t)(int64_t)(int32_t)(uint32_t)GP(%d) : "
+            "(uint64_t)(int64_t)(int32_t)((uint32_t)GP(%d) %% "
+            "(uint32_t)GP(%d))",
+            rs2,
+            rs1,
+            rs1,
+            rs2
+        );
+        return true;
+    case inst_subw:
+        GP_WRITE("(int64_t)(int32_t)(GP(%d) - GP(%d))", rs1, rs2);
+        return true;
+    case inst_sraw:
+        GP_WRITE(
+            "(int64_t)(int32_t)((int32_t)GP(%d) >> (GP(%d) & 0x1f))", rs1, rs2
+        );
+        return true;
+    case inst_beq: BRANCH("GP(%d) == GP(%d)");
+    case inst_bne: BRANCH("GP(%d) != GP(%d)");
+    case inst_blt: BRANCH("(int64_t)GP(%d) < (int64_t)GP(%d)");
+    case inst_bge: BRANCH("(int64_t)GP(%d) >= (int64_t)GP(%d)");
+    case inst_bltu: BRANCH("GP(%d) < GP(%d)");
+    case inst_bgeu: BRANCH("GP(%d) >= GP(%d)");
+    case inst_slli_srli:
+        GP_WRITE(
+            "(GP(%d) << %d) >> %d", rs1, inst->imm1 & 0x3f, inst->imm2 & 0x3f
+        );
+        return true;
+    case inst_slli_add:
+        GP_WRITE("GP(%d) + (GP(%d) << %d)", rs2, rs1, inst->imm1 & 0x3f);
+        return true;
+    case inst_addi_bne: ADDI_BRANCH("GP(%d) != GP(%d)");
+    case inst_addi_blt: ADDI_BRANCH("(int64_t)GP(%d) < (int64_t)GP(%d)");
+    case inst_addi_bltu: ADDI_BRANCH("GP(%d) < GP(%d)");
+    case inst_jalr:
+        // rd可能与rs1相同, 先算出跳转目标再写rd
+        EMIT(
+            "    { uint64_t target = (GP(%d) + %" PRId64 "LL) & ~1ULL;\n",
+            rs1,
+            imm
+        );
+        GP_WRITE("0x%" PRIx64 "ULL", next_pc);
+        EMIT("    EXIT(%d, target); }\n", indirect_branch);
+        return true;
+    case inst_jal:
+        GP_WRITE("0x%" PRIx64 "ULL", next_pc);
+        if (!taken)
+            EMIT("    EXIT(%d, 0x%" PRIx64 "ULL);\n", direct_branch, pc + imm);
+        return true;
+    case inst_j:
+        if (!taken)
+            EMIT("    EXIT(%d, 0x%" PRIx64 "ULL);\n", direct_branch, pc + imm);
+        return true;
+    case inst_jr:
+        EMIT(
+            "    EXIT(%d, (GP(%d) + %" PRId64 "LL) & ~1ULL);\n", indirect_branch,
+            rs1, imm
+        );
+        return true;
+    case inst_ecall:
+        EMIT("    EXIT(%d, 0x%" PRIx64 "ULL);\n", ecall, pc + 4);
+        return true;
+    case inst_csrrc:
+    case inst_csrrci:
+    case inst_csrrs:
+    case inst_csrrsi:
+    case inst_csrrw:
+    case inst_csrrwi:
+        if (inst->csr != fflags && inst->csr != frm && inst->csr != fcsr)
+            return false; // 留给解释器报错
+        GP_WRITE("0");
+        return true;
+    case inst_flw:
+        FP_STMT(
+            "FP(%d).v = (uint64_t)MEM(uint32_t, GP(%d) + %" PRId64 "LL) | "
+            "0xffffffff00000000ULL",
+            rd,
+            rs1,
+            imm
+        );
+    case inst_fld:
+        FP_STMT(
+            "FP(%d).v = MEM(uint64_t, GP(%d) + %" PRId64 "LL)", rd, rs1, imm
+        );
+    case inst_fsw:
+        FP_STMT(
+            "MEM(uint32_t, GP(%d) + %" PRId64 "LL) = (uint32_t)FP(%d).v",
+            rs1,
+            imm,
+            rs2
+        );
+    case inst_fsd:
+        FP_STMT(
+            "MEM(uint64_t, GP(%d) + %" PRId64 "LL) = FP(%d).v", rs1, imm, rs2
+        );
+    case inst_fmadd_s:
+        FP_STMT("FP(%d).f = FP(%d).f * FP(%d).f + FP(%d).f", rd, rs1, rs2, rs3);
+    case inst_fmsub_s:
+        FP_STMT("FP(%d).f = FP(%d).f * FP(%d).f - FP(%d).f", rd, rs1, rs2, rs3);
+    case inst_fnmsub_s:
+        FP_STMT(
+            "FP(%d).f = -(FP(%d).f * FP(%d).f) + FP(%d).f", rd, rs1, rs2, rs3
+        );
+    case inst_fnmadd_s:
+        FP_STMT(
+            "FP(%d).f = -(FP(%d).f * FP(%d).f) - FP(%d).f", rd, rs1, rs2, rs3
+        );
+    case inst_fadd_s: FP_STMT("FP(%d).f = FP(%d).f + FP(%d).f", rd, rs1, rs2);
+    case inst_fsub_s: FP_STMT("FP(%d).f = FP(%d).f - FP(%d).f", rd, rs1, rs2);
+    case inst_fmul_s: FP_STMT("FP(%d).f = FP(%d).f * FP(%d).f", rd, rs1, rs2);
+    case inst_fdiv_s: FP_STMT("FP(%d).f = FP(%d).f / FP(%d).f", rd, rs1, rs2);
+    case inst_fsqrt_s:
+        FP_STMT("FP(%d).f = __builtin_sqrtf(FP(%d).f)", rd, rs1);
+    case inst_fsgnj_s:
+        FP_STMT(
+            "FP(%d).v = (uint64_t)((FP(%d).w & 0x7fffffffU) | "
+            "(FP(%d).w & 0x80000000U)) | 0xffffffff00000000ULL",
+            rd,
+            rs1,
+            rs2
+        );
+    case inst_fsgnjn_s:
+        FP_STMT(
+            "FP(%d).v = (uint64_t)((FP(%d).w & 0x7fffffffU) | "
+            "(~FP(%d).w & 0x80000000U)) | 0xffffffff00000000ULL",
+            rd,
+            rs1,
+            rs2
+        );
+    case inst_fsgnjx_s:
+        FP_STMT(
+            "FP(%d).v = (uint64_t)((FP(%d).w & 0x7fffffffU) | "
+            "((FP(%d).w ^ FP(%d).w) & 0x80000000U)) | 0xffffffff00000000ULL",
+            rd,
+            rs1,
+            rs1,
+            rs2
+        );
+    case inst_fmin_s:
+        FP_STMT(
+            "FP(%d).f = FP(%d).f < FP(%d).f ? FP(%d).f : FP(%d).f",
+            rd,
+            rs1,
+            rs2,
+            rs1,
+            rs2
+        );
+    case inst_fmax_s:
+        FP_STMT(
+            "FP(%d).f = FP(%d).f > FP(%d).f ? FP(%d).f : FP(%d).f",
+            rd,
+            rs1,
+            rs2,
+            rs1,
+            rs2
+        );
+    case inst_fcvt_w_s:
+        GP_WRITE("(int64_t)(int32_t)__builtin_llrintf(FP(%d).f)", rs1);
+        return true;
+    case inst_fcvt_wu_s:
+        GP_WRITE(
+            "(int64_t)(int32_t)(uint32_t)__builtin_llrintf(FP(%d).f)", rs1
+        );
+        return true;
+    case inst_fmv_x_w:
+        GP_WRITE("(int64_t)(int32_t)FP(%d).w", rs1);
+        return true;
+    case inst_feq_s:
+        GP_WRITE("FP(%d).f == FP(%d).f", rs1, rs2);
+        return true;
+    case inst_flt_s:
+        GP_WRITE("FP(%d).f < FP(%d).f", rs1, rs2);
+        return true;
+    case inst_fle_s:
+        GP_WRITE("FP(%d).f <= FP(%d).f", rs1, rs2);
+        return true;
+    case inst_fcvt_s_w: FP_STMT("FP(%d).f = (float)(int32_t)GP(%d)", rd, rs1);
+    case inst_fcvt_s_wu: FP_STMT("FP(%d).f = (float)(uint32_t)GP(%d)", rd, rs1);
+    case inst_fmv_w_x: FP_STMT("FP(%d).w = (uint32_t)GP(%d)", rd, rs1);
+    case inst_fcvt_l_s:
+        GP_WRITE("(int64_t)__builtin_llrintf(FP(%d).f)", rs1);
+        return true;
+    case inst_fcvt_lu_s:
+        GP_WRITE("(uint64_t)__builtin_llrintf(FP(%d).f)", rs1);
+        return true;
+    case inst_fcvt_s_l: FP_STMT("FP(%d).f = (float)(int64_t)GP(%d)", rd, rs1);
+    case inst_fcvt_s_lu: FP_STMT("FP(%d).f = (float)GP(%d)", rd, rs1);
+    case inst_fmadd_d:
+        FP_STMT("FP(%d).d = FP(%d).d * FP(%d).d + FP(%d).d", rd, rs1, rs2, rs3);
+    case inst_fmsub_d:
+        FP_STMT("FP(%d).d = FP(%d).d * FP(%d).d - FP(%d).d", rd, rs1, rs2, rs3);
+    case inst_fnmsub_d:
+        FP_STMT(
+            "FP(%d).d = -(FP(%d).d * FP(%d).d) + FP(%d).d", rd, rs1, rs2, rs3
+        );
+    case inst_fnmadd_d:
+        FP_STMT(
+            "FP(%d).d = -(FP(%d).d * FP(%d).d) - FP(%d).d", rd, rs1, rs2, rs3
+        );
+    case inst_fadd_d: FP_STMT("FP(%d).d = FP(%d).d + FP(%d).d", rd, rs1, rs2);
+    case inst_fsub_d: FP_STMT("FP(%d).d = FP(%d).d - FP(%d).d", rd, rs1, rs2);
+    case inst_fmul_d: FP_STMT("FP(%d).d = FP(%d).d * FP(%d).d", rd, rs1, rs2);
+    case inst_fdiv_d: FP_STMT("FP(%d).d = FP(%d).d / FP(%d).d", rd, rs1, rs2);
+    case inst_fsqrt_d: FP_STMT("FP(%d).d = __builtin_sqrt(FP(%d).d)", rd, rs1);
+    case inst_fsgnj_d:
+        FP_STMT(
+            "FP(%d).v = (FP(%d).v & 0x7fffffffffffffffULL) | "
+            "(FP(%d).v & 0x8000000000000000ULL)",
+            rd,
+            rs1,
+            rs2
+        );
+    case inst_fsgnjn_d:
+        FP_STMT(
+            "FP(%d).v = (FP(%d).v & 0x7fffffffffffffffULL) | "
+            "(~FP(%d).v & 0x8000000000000000ULL)",
+            rd,
+            rs1,
+            rs2
+        );
+    case inst_fsgnjx_d:
+        FP_STMT(
+            "FP(%d).v = (FP(%d).v & 0x7fffffffffffffffULL) | "
+            "((FP(%d).v ^ FP(%d).v) & 0x8000000000000000ULL)",
+            rd,
+            rs1,
+            rs1,
+            rs2
+        );
+    case inst_fmin_d:
+        FP_STMT(
+            "FP(%d).d = FP(%d).d < FP(%d).d ? FP(%d).d : FP(%d).d",
+            rd,
+            rs1,
+            rs2,
+            rs1,
+            rs2
+        );
+    case inst_fmax_d:
+        FP_STMT(
+            "FP(%d).d = FP(%d).d > FP(%d).d ? FP(%d).d : FP(%d).d",
+            rd,
+            rs1,
+            rs2,
+            rs1,
+            rs2
+        );
+    case inst_fcvt_s_d: FP_STMT("FP(%d).f = (float)FP(%d).d", rd, rs1);
+    case inst_fcvt_d_s: FP_STMT("FP(%d).d = (double)FP(%d).f", rd, rs1);
+    case inst_feq_d:
+        GP_WRITE("FP(%d).d == FP(%d).d", rs1, rs2);
+        return true;
+    case inst_flt_d:
+        GP_WRITE("FP(%d).d < FP(%d).d", rs1, rs2);
+        return true;
+    case inst_fle_d:
+        GP_WRITE("FP(%d).d <= FP(%d).d", rs1, rs2);
+        return true;
+    case inst_fcvt_w_d:
+        GP_WRITE("(int64_t)(int32_t)__builtin_llrint(FP(%d).d)", rs1);
+        return true;
+    case inst_fcvt_wu_d:
+        GP_WRITE("(int64_t)(int32_t)(uint32_t)__builtin_llrint(FP(%d).d)", rs1);
+        return true;
+    case inst_fcvt_d_w: FP_STMT("FP(%d).d = (double)(int32_t)GP(%d)", rd, rs1);
+    case inst_fcvt_d_wu:
+        FP_STMT("FP(%d).d = (double)(uint32_t)GP(%d)", rd, rs1);
+    case inst_fcvt_l_d:
+        GP_WRITE("(int64_t)__builtin_llrint(FP(%d).d)", rs1);
+        return true;
+    case inst_fcvt_lu_d:
+        GP_WRITE("(uint64_t)__builtin_llrint(FP(%d).d)", rs1);
+        return true;
+    case inst_fmv_x_d:
+        GP_WRITE("FP(%d).v", rs1);
+        return true;
+    case inst_fcvt_d_l: FP_STMT("FP(%d).d = (double)(int64_t)GP(%d)", rd, rs1);
+    case inst_fcvt_d_lu: FP_STMT("FP(%d).d = (double)GP(%d)", rd, rs1);
+    case inst_fmv_d_x: FP_STMT("FP(%d).v = GP(%d)", rd, rs1);
+    default:
+        // fclass等需要辅助函数的指令不翻译, 整个block留在解释器里执行
+        return gen_amo(s, inst);
+    }
+}
+
+#undef LOAD
+#undef STORE
+#undef BRANCH
+#undef ADDI_BRANCH
+#undef FP_STMT
+#undef GP_WRITE
+
+enum trace_dir_t {
+    trace_end,   // superblock在这个block结束
+    trace_taken, // 沿末尾分支/jal的跳转方向继续
+    trace_fall,  // 沿end_pc继续
+};
+
+static inline bool is_branch(inst_t *inst) {
+    enum inst_type_t type = inst_generic(inst->type);
+    return (type >= inst_beq && type <= inst_bgeu) ||
+           (type >= inst_addi_bne && type <= inst_addi_bltu);
+}
+
+/*
+ * 从循环头出发, 按各block的跳转计数选出最常走的路径:
+ * 末尾条件分支跳转次数过半则沿跳转方向, 否则沿end_pc; j沿跳转目标。
+ * 遇到间接跳转/ecall/函数调用(保持返回地址栈平衡)、尚未链接的后继、
+ * 已在路径中的block或长度上限时停止。回到循环头时*loop为true。
+ */
+static uint32_t trace_select(
+    block_t *head, block_t **trace, enum trace_dir_t *dirs, bool *loop
+) {
+    uint32_t n = 0;
+    *loop = false;
+    for (block_t *block = head; block != NULL && n < TRACE_MAX_BLOCKS;) {
+        trace[n] = block;
+        dirs[n] = trace_end;
+        n++;
+
+        inst_t *last = &block->insts[block->len - 1];
+        enum trace_dir_t dir;
+        if (last->type == inst_j)
+            dir = trace_taken;
+        else if (is_branch(last))
+            dir = __atomic_load_n(&block->taken, __ATOMIC_RELAXED) * 2 >
+                          __atomic_load_n(&block->hot, __ATOMIC_RELAXED)
+                      ? trace_taken
+                      : trace_fall;
+        else if (!last->continue_exec)
+            dir = trace_fall;
+        else
+            break;
+
+        uint64_t next_pc = dir == trace_fall
+                               ? block->end_pc
+                               : block->end_pc - last->size +
+                                     inst_target_offset(last);
+        block_t *next = __atomic_load_n(
+            &block->succ[next_pc == block->end_pc], __ATOMIC_ACQUIRE
+        );
+        if (next == NULL)
+            break;
+        if (next == head) {
+            dirs[n - 1] = dir;
+            *loop = true;
+            break;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (trace[i] == next)
+                return n;
+        }
+        if (n < TRACE_MAX_BLOCKS)
+            dirs[n - 1] = dir;
+        block = next;
+    }
+    return n;
+}
+
+/*
+ * 寄存器分配
+ *
+ * 生成的代码里guest寄存器都是state_t的字段, 而guest的访存经过任意指针,
+ * clang无法证明二者不重叠, 每次store之后都要重新从state读寄存器。
+ * 这里统计整个block/superblock里各寄存器的使用次数, 把最常用的若干个
+ * (通常是sp、a0-a5、s0和循环变量)放进局部变量, 中间全部留在宿主寄存器里,
+ * 只在出口把写过的寄存器写回state_t(SYNC)。生成的代码不调用任何函数,
+ * 系统调用也是经由出口返回, 所以出口是唯一的同步点。
+ *
+ * 代码是顺序执行的, 因此只需在入口读取先读后写的寄存器, 每个出口只写回
+ * 此前写过的寄存器; 循环superblock的出口可能在任意一轮, 全部按写过处理。
+ */
+
+#define JIT_HOST_GP_REGS 12 // 放进局部变量的通用寄存器个数上限
+#define JIT_HOST_FP_REGS 12 // 浮点寄存器个数上限
+
+typedef struct {
+    uint32_t uses[NUM_REGS];
+    bool written[NUM_REGS];
+    bool live_in[NUM_REGS]; // 第一次访问是读, 入口需要从state读取
+    bool local[NUM_REGS];
+    bool dirty[NUM_REGS]; // 生成代码时, 到当前位置为止写过的寄存器
+} reg_alloc_t;
+
+// 不用的字段为0, 计到x0/f0上只会多读一次
+static void count_uses(reg_alloc_t *ra, inst_t *inst) {
+    inst_regs_t regs = inst_regs(inst);
+    for (int i = 0; i < ARRAY_SIZE(regs.rs); i++) {
+        int r = regs.rs[i];
+        if (r < 0)
+            continue;
+        ra->uses[r]++;
+        if (!ra->written[r])
+            ra->live_in[r] = true;
+    }
+
+    if (regs.rd >= 0) {
+        ra->uses[regs.rd]++;
+        ra->written[regs.rd] = true;
+    }
+}
+
+// 从first开始的n个寄存器中挑使用次数最多的max个
+static void pick(reg_alloc_t *ra, int first, int n, int max) {
+    for (int k = 0; k < max; k++) {
+        int best = -1;
+        for (int r = first; r < first + n; r++) {
+            if (!ra->local[r] && ra->uses[r] > 0 &&
+                (best == -1 || ra->uses[r] > ra->uses[best]))
+                best = r;
+        }
+        if (best == -1)
+            return;
+        ra->local[best] = true;
+    }
+}
+
+static void alloc_regs(reg_alloc_t *ra, block_t **trace, uint32_t n) {
+    memset(ra, 0, sizeof(*ra));
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < trace[i]->len; j++)
+            count_uses(ra, &trace[i]->insts[j]);
+    }
+    ra->uses[zero] = 0; // x0恒为0, 直接展开成常量
+    pick(ra, 0, num_gp_regs, JIT_HOST_GP_REGS);
+    pick(ra, num_gp_regs, num_fp_regs, JIT_HOST_FP_REGS);
+}
+
+static void reg_name(char *buf, int r) {
+    if (r < num_gp_regs)
+        sprintf(buf, "r%d", r);
+    else
+        sprintf(buf, "f%d", r - num_gp_regs);
+}
+
+// 生成GP_n/FP_n宏, 分到局部变量的寄存器对应变量名, 其余对应state中的槽位
+static void gen_regs(str_t *s, reg_alloc_t *ra) {
+    EMIT("#define GP_0 ((uint64_t)0)\n");
+    for (int r = 1; r < NUM_REGS; r++) {
+        const char *cls = r < num_gp_regs ? "GP" : "FP";
+        int n = r < num_gp_regs ? r : r - num_gp_regs;
+        char name[8];
+        reg_name(name, r);
+        if (ra->local[r])
+            EMIT("#define %s_%d %s\n", cls, n, name);
+        else
+            EMIT("#define %s_%d %s_MEM(%d)\n", cls, n, cls, n);
+    }
+}
+
+// 定义SYNC(): 把标记为写过的局部变量写回state
+static void gen_sync(str_t *s, reg_alloc_t *ra, bool *dirty) {
+    EMIT("#undef SYNC\n#define SYNC() do {");
+    for (int r = 0; r < NUM_REGS; r++) {
+        if (!ra->local[r] || !dirty[r])
+            continue;
+        char name[8];
+        reg_name(name, r);
+        if (r < num_gp_regs)
+            EMIT(" GP_MEM(%d) = %s;", r, name);
+        else
+            EMIT(" FP_MEM(%d) = %s;", r - num_gp_regs, name);
+    }
+    EMIT(" } while (0)\n");
+}
+
+static void gen_reg_decls(str_t *s, reg_alloc_t *ra, bool loop) {
+    for (int r = 0; r < NUM_REGS; r++) {
+        if (!ra->local[r])
+            continue;
+        char name[8];
+        reg_name(name, r);
+        bool gp = r < num_gp_regs;
+        EMIT("    %s %s", gp ? "uint64_t" : "fp_reg_t", name);
+        if (loop || ra->live_in[r])
+            EMIT(" = %s_MEM(%d)", gp ? "GP" : "FP", gp ? r : r - num_gp_regs);
+        EMIT(";\n");
+    }
+}
+
+/*
+ * 普通block只翻译它自己; 循环头则翻译成单入口多出口的superblock:
+ * 路径上各block的代码顺序相接, 条件分支偏离路径的一侧作为出口回到解释器,
+ * 回到循环头时直接goto到函数开头, 整个热循环都在本地代码里执行。
+ * 每段代码前重新定义BLOCK, 出口据此返回真正退出的那个block。
+ */
+bool machine_genblock(machine_t *m, block_t *block, jit_unit_t *unit) {
+    block_t **trace = unit->blocks;
+    enum trace_dir_t dirs[TRACE_MAX_BLOCKS] = { trace_end };
+    uint32_t n = 1;
+    bool loop = false;
+    trace[0] = block;
+    if (__atomic_load_n(&block->loop_header, __ATOMIC_RELAXED))
+        n = trace_select(block, trace, dirs, &loop);
+    unit->nblocks = n;
+    unit->gen = block->gen;
+    smc_cover(trace, n);
+
+    reg_alloc_t ra;
+    alloc_regs(&ra, trace, n);
+
+    str_t *s = &unit->source;
+    EMIT(
+        prelude,
+        offsetof(state_t, gp_regs),
+        offsetof(state_t, fp_regs),
+        offsetof(state_t, exit_reason),
+        offsetof(state_t, reenter_pc),
+        offsetof(state_t, reserved),
+        offsetof(state_t, reserve_addr),
+        offsetof(state_t, reserve_val),
+        offsetof(state_t, mem),
+        offsetof(state_t, icount),
+        offsetof(state_t, exiting),
+        n
+    );
+    gen_regs(s, &ra);
+    gen_sync(s, &ra, loop ? ra.written : ra.dirty);
+    EMIT("void *start(void *restrict state) {\n");
+    EMIT("    const uint64_t mem = MEM_BASE;\n");
+    EMIT("    uint64_t icount = 0;\n");
+    gen_reg_decls(s, &ra, loop);
+    if (loop)
+        EMIT("head:\n");
+
+    for (uint32_t i = 0; i < n; i++) {
+        block_t *b = trace[i];
+        EMIT("#undef BLOCK\n#define BLOCK (blocks[%u])\n", i);
+        EMIT("    icount += %u;\n", b->ninsts);
+
+        uint64_t pc = b->pc;
+        inst_t *inst = NULL;
+        for (uint32_t j = 0; j < b->len; j++) {
+            inst = &b->insts[j];
+            int rd = inst_regs(inst).rd;
+            if (!loop && rd >= 0 && ra.local[rd] && !ra.dirty[rd]) {
+                ra.dirty[rd] = true;
+                gen_sync(s, &ra, ra.dirty);
+            }
+            if (!gen_inst(s, inst, pc, dirs[i] == trace_taken))
+                return false;
+            pc += inst->size;
+        }
+
+        // 分支未跳转, 或block因长度上限被截断
+        if (dirs[i] == trace_end && !inst_is_jump(inst->type))
+            EMIT(
+                "    EXIT(%d, 0x%" PRIx64 "ULL);\n", direct_branch, b->end_pc
+            );
+    }
+    // 其它hart可能同时在改内存, 每一圈都要重新读, 自旋等待的循环才能退出;
+    // guest进程正在退出时回到machine_step, 见machine_stop
+    if (loop) {
+        EMIT("    if (__atomic_load_n(&EXITING, __ATOMIC_RELAXED))\n");
+        EMIT("        EXIT(%d, 0x%" PRIx64 "ULL);\n", direct_branch, block->pc);
+        EMIT("    __asm__ volatile(\"\" ::: \"memory\");\n    goto head;\n");
+    }
+    EMIT("}\n");
+    return true;
+}
+
+#undef EMIT
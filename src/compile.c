@@ -0,0 +1,361 @@
+#define _GNU_SOURCE // pipe2, mkostemp
+#include "rvemu.h"
+#include <limits.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/*
+ * 调用外部编译器把codegen.c生成的C代码编译成可重定位目标文件(.o),
+ * 再把其中需要加载的段拷贝进代码缓存, 处理重定位后得到可直接调用的函数。
+ *
+ * 编译器默认是clang, 可通过环境变量 RVEMU_JIT_CC 替换(如gcc)。
+ * C代码通过管道送进编译器的stdin, 目标文件先写到临时文件再读回来
+ * (gcc的汇编器不支持输出到管道)。
+ */
+
+#define JIT_CFLAGS                                                             \
+    "-O3", "-c", "-xc", "-fPIC", "-fno-strict-aliasing", "-fno-math-errno",    \
+        "-fno-stack-protector", "-fno-asynchronous-unwind-tables",             \
+        "-fno-unwind-tables", "-fno-common"
+
+// 运行编译器, 返回目标文件内容(调用方负责free), 失败返回NULL
+static uint8_t *run_compiler(str_t *source, size_t *size) {
+    const char *cc = getenv("RVEMU_JIT_CC");
+    if (cc == NULL)
+        cc = "clang";
+    const char *tmpdir = getenv("TMPDIR");
+    if (tmpdir == NULL)
+        tmpdir = "/tmp";
+
+    char objpath[PATH_MAX];
+    snprintf(objpath, sizeof(objpath), "%s/rvemu-jit-XXXXXX", tmpdir);
+    int objfd = mkostemp(objpath, O_CLOEXEC);
+    if (objfd == -1)
+        return NULL;
+
+    int in[2];
+    if (pipe2(in, O_CLOEXEC) != 0)
+        fatal("cannot make a pipe");
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, in[1]);
+
+    char *argv[] = { (char *)cc, JIT_CFLAGS, "-o", objpath, "-", NULL };
+    pid_t pid;
+    int err = posix_spawnp(&pid, cc, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(in[0]);
+
+    uint8_t *buf = NULL;
+    if (err != 0) {
+        close(in[1]);
+        goto out;
+    }
+
+    // 编译器没读完就退出时write返回EPIPE, 不能让SIGPIPE结束整个模拟器。
+    // 只在本线程屏蔽, guest自己写断开的管道时照常收到SIGPIPE
+    sigset_t sigpipe, old;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &old);
+    size_t written = 0;
+    while (written < source->len) {
+        ssize_t n =
+            write(in[1], source->data + written, source->len - written);
+        if (n == -1 && errno == EINTR)
+            continue; // machine_stop的信号
+        if (n <= 0)
+            break;
+        written += n;
+    }
+    // 丢掉这次write产生的SIGPIPE, 再恢复屏蔽字
+    struct timespec zero = { 0 };
+    if (written < source->len && !sigismember(&old, SIGPIPE))
+        while (sigtimedwait(&sigpipe, NULL, &zero) == -1 && errno == EINTR)
+            ;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    close(in[1]);
+
+    int status;
+    pid_t ret;
+    do // machine_stop的信号会打断等待
+        ret = waitpid(pid, &status, 0);
+    while (ret == -1 && errno == EINTR);
+    // 源码没有全部送进去时即使编译器成功退出, 结果也不完整
+    if (ret == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+        written < source->len)
+        goto out;
+
+    struct stat st;
+    if (fstat(objfd, &st) != 0 || st.st_size == 0)
+        goto out;
+    buf = malloc(st.st_size);
+    if (pread(objfd, buf, st.st_size, 0) != st.st_size) {
+        free(buf);
+        buf = NULL;
+        goto out;
+    }
+    *size = st.st_size;
+
+out:
+    close(objfd);
+    unlink(objpath);
+    return buf;
+}
+
+#if defined(__x86_64__)
+
+static bool apply_reloc(uint8_t *loc, uint32_t type, uint64_t sym, int64_t add) {
+    switch (type) {
+    case R_X86_64_64:
+        *(uint64_t *)loc = sym + add;
+        return true;
+    case R_X86_64_PC32:
+    case R_X86_64_PLT32: {
+        int64_t val = (int64_t)(sym + add - (uint64_t)loc);
+        if (val != (int32_t)val)
+            return false;
+        *(int32_t *)loc = (int32_t)val;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+#else
+
+// 新的宿主架构只需在这里补上对应的重定位类型
+static bool apply_reloc(uint8_t *loc, uint32_t type, uint64_t sym, int64_t add) {
+    return false;
+}
+
+#endif
+
+// 在已装载的目标文件中查找符号的地址, 找不到返回NULL
+static uint8_t *
+find_symbol(uint8_t *obj, elf64_shdr_t *shdrs, uint64_t *addrs, char *name) {
+    elf64_ehdr_t *ehdr = (elf64_ehdr_t *)obj;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        elf64_shdr_t *sh = &shdrs[i];
+        if (sh->sh_type != SHT_SYMTAB)
+            continue;
+        elf64_sym_t *syms = (elf64_sym_t *)(obj + sh->sh_offset);
+        char *strtab = (char *)(obj + shdrs[sh->sh_link].sh_offset);
+        for (uint64_t j = 0; j < sh->sh_size / sizeof(elf64_sym_t); j++) {
+            if (strcmp(strtab + syms[j].st_name, name) == 0 &&
+                syms[j].st_shndx < ehdr->e_shnum &&
+                addrs[syms[j].st_shndx] != 0)
+                return (uint8_t *)addrs[syms[j].st_shndx] + syms[j].st_value;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * 把目标文件中所有SHF_ALLOC的段(.text/.rodata/.bss等)依次放进代码缓存,
+ * 再按.rela.*修正段间引用。生成的代码不允许引用外部符号,
+ * 遇到未定义符号或不认识的重定位类型时放弃这个block。
+ * 最后把nblocks个block的指针填进生成代码里的blocks[]表。
+ */
+static uint8_t *link_object(
+    cache_t *cache, uint8_t *obj, size_t size, block_t **blocks,
+    uint32_t nblocks
+) {
+    elf64_ehdr_t *ehdr = (elf64_ehdr_t *)obj;
+    if (size < sizeof(elf64_ehdr_t) || *(uint32_t *)ehdr != *(uint32_t *)ELFMAG)
+        return NULL;
+
+    elf64_shdr_t *shdrs = (elf64_shdr_t *)(obj + ehdr->e_shoff);
+    uint64_t *addrs = calloc(ehdr->e_shnum, sizeof(uint64_t));
+
+    uint64_t total = 0;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        elf64_shdr_t *sh = &shdrs[i];
+        if (!(sh->sh_flags & SHF_ALLOC) || sh->sh_size == 0)
+            continue;
+        total = ROUNDUP(total, MAX(sh->sh_addralign, 1)) + sh->sh_size;
+    }
+
+    uint8_t *base = cache_alloc_code(cache, total);
+    uint8_t *entry = NULL;
+    if (base == NULL)
+        goto fail;
+
+    uint64_t offset = 0;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        elf64_shdr_t *sh = &shdrs[i];
+        if (!(sh->sh_flags & SHF_ALLOC) || sh->sh_size == 0)
+            continue;
+        offset = ROUNDUP(offset, MAX(sh->sh_addralign, 1));
+        addrs[i] = (uint64_t)base + offset;
+        if (sh->sh_type == SHT_NOBITS)
+            memset(base + offset, 0, sh->sh_size);
+        else
+            memcpy(base + offset, obj + sh->sh_offset, sh->sh_size);
+        offset += sh->sh_size;
+    }
+
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        elf64_shdr_t *sh = &shdrs[i];
+        if (sh->sh_type != SHT_RELA || addrs[sh->sh_info] == 0)
+            continue;
+
+        elf64_sym_t *syms = (elf64_sym_t *)(obj + shdrs[sh->sh_link].sh_offset);
+        elf64_rela_t *relas = (elf64_rela_t *)(obj + sh->sh_offset);
+        for (uint64_t j = 0; j < sh->sh_size / sizeof(elf64_rela_t); j++) {
+            elf64_rela_t *rela = &relas[j];
+            elf64_sym_t *sym = &syms[rela->r_sym];
+            if (sym->st_shndx == SHN_UNDEF || sym->st_shndx >= ehdr->e_shnum ||
+                addrs[sym->st_shndx] == 0)
+                goto fail;
+
+            uint8_t *loc = (uint8_t *)addrs[sh->sh_info] + rela->r_offset;
+            uint64_t sym_addr = addrs[sym->st_shndx] + sym->st_value;
+            if (!apply_reloc(loc, rela->r_type, sym_addr, rela->r_addend))
+                goto fail;
+        }
+    }
+
+    void **table = (void **)find_symbol(obj, shdrs, addrs, "blocks");
+    if (table == NULL)
+        goto fail;
+    memcpy(table, blocks, nblocks * sizeof(block_t *));
+    entry = find_symbol(obj, shdrs, addrs, "start");
+
+fail:
+    free(addrs);
+    return entry;
+}
+
+exec_block_func_t machine_load_object(
+    machine_t *m, uint8_t *obj, size_t size, block_t **blocks, uint32_t nblocks
+) {
+    return (exec_block_func_t)link_object(m->cache, obj, size, blocks, nblocks);
+}
+
+/*
+ * 进程内共享的目标文件
+ *
+ * 生成的C代码里没有宿主指针(见codegen.c), 一个进程里的几个machine
+ * 运行同一个程序时, 热代码的C代码往往一字不差。按源码查到编译过的目标文件
+ * 就直接装载, 只有第一个machine调用编译器; 同一段源码正在编译时,
+ * 其它machine等它编译完。
+ * 表按源码的散列分桶, 总大小到上限后不再加入。
+ */
+#define SHARED_BUCKETS 1024
+#define SHARED_MAX_BYTES (256ULL << 20)
+
+typedef struct shared_obj_t {
+    struct shared_obj_t *next;
+    uint64_t hash;
+    char *source;
+    size_t source_len;
+    uint8_t *obj; // 为NULL时正在编译
+    size_t size;
+} shared_obj_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t done; // 有项编译结束
+    shared_obj_t *buckets[SHARED_BUCKETS];
+    uint64_t bytes;
+} shared = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static uint64_t hash_source(str_t *source) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < source->len; i++)
+        h = (h ^ (uint8_t)source->data[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+// 调用方持有shared.lock
+static shared_obj_t *shared_find(str_t *source, uint64_t hash) {
+    for (shared_obj_t *e = shared.buckets[hash % SHARED_BUCKETS]; e;
+         e = e->next) {
+        if (e->hash == hash && e->source_len == source->len &&
+            memcmp(e->source, source->data, source->len) == 0)
+            return e;
+    }
+    return NULL;
+}
+
+// 查表, 没有时调用编译器并把结果放进表里; 返回目标文件(调用方负责free)
+static uint8_t *shared_compile(str_t *source, size_t *size) {
+    uint64_t hash = hash_source(source);
+    uint8_t *obj = NULL;
+    pthread_mutex_lock(&shared.lock);
+    shared_obj_t *e;
+    // 编译失败的项会被删掉, 醒来后重新查
+    while ((e = shared_find(source, hash)) && e->obj == NULL)
+        pthread_cond_wait(&shared.done, &shared.lock);
+    if (e) {
+        obj = malloc(e->size);
+        memcpy(obj, e->obj, e->size);
+        *size = e->size;
+        pthread_mutex_unlock(&shared.lock);
+        return obj;
+    }
+
+    // 先放一个正在编译的项, 编译时不持有锁
+    if (shared.bytes + source->len <= SHARED_MAX_BYTES) {
+        e = malloc(sizeof(shared_obj_t));
+        *e = (shared_obj_t){
+            .next = shared.buckets[hash % SHARED_BUCKETS],
+            .hash = hash,
+            .source = malloc(source->len),
+            .source_len = source->len,
+        };
+        memcpy(e->source, source->data, source->len);
+        shared.buckets[hash % SHARED_BUCKETS] = e;
+        shared.bytes += source->len;
+    }
+    pthread_mutex_unlock(&shared.lock);
+
+    obj = run_compiler(source, size);
+    if (e == NULL)
+        return obj;
+
+    pthread_mutex_lock(&shared.lock);
+    if (obj && shared.bytes + *size <= SHARED_MAX_BYTES) {
+        e->obj = malloc(*size);
+        memcpy(e->obj, obj, *size);
+        e->size = *size;
+        shared.bytes += *size;
+    } else {
+        // 编译失败(可能只是被信号打断)或放不下, 删掉让等待的machine自己编译
+        shared_obj_t **p = &shared.buckets[hash % SHARED_BUCKETS];
+        while (*p != e)
+            p = &(*p)->next;
+        *p = e->next;
+        shared.bytes -= e->source_len;
+        free(e->source);
+        free(e);
+    }
+    pthread_cond_broadcast(&shared.done);
+    pthread_mutex_unlock(&shared.lock);
+    return obj;
+}
+
+// 编译成功的目标文件同时存进磁盘缓存, 下次运行同一个程序时直接装载
+exec_block_func_t machine_compile(machine_t *m, jit_unit_t *unit) {
+    size_t size;
+    uint8_t *obj = shared_compile(&unit->source, &size);
+    if (obj == NULL)
+        return NULL;
+
+    exec_block_func_t code =
+        machine_load_object(m, obj, size, unit->blocks, unit->nblocks);
+    if (code && m->pcache && smc_immutable(m, unit->blocks, unit->nblocks))
+        pcache_save(m->pcache, unit->blocks, unit->nblocks, obj, size);
+    free(obj);
+    return code;
+}
@@ -1,37 +1,37 @@
 #include "rvemu.h"
 #include <stdio.h>
 
+// 编码中保留或非法的组合, 解码失败
+#define REQUIRE(cond)                                                          \
+    if (!(cond))                                                               \
+        return false;
+
 #define QUADRANT(data) (((data) >> 0) & 0x3)
 
 /**
  * normal types
  */
-#define OPCODE(data) (((data) >> 2) & 0x1f)
 #define RD(data) (((data) >> 7) & 0x1f)
 #define RS1(data) (((data) >> 15) & 0x1f)
 #define RS2(data) (((data) >> 20) & 0x1f)
 #define RS3(data) (((data) >> 27) & 0x1f)
-#define FUNCT2(data) (((data) >> 25) & 0x3)
-#define FUNCT3(data) (((data) >> 12) & 0x7)
-#define FUNCT7(data) (((data) >> 25) & 0x7f)
-#define IMM116(data) (((data) >> 26) & 0x3f)
 
-static FORCE_INLINE inst_t inst_utype_read(uint32_t data) {
-    return (inst_t){
-        .imm = (int32_t)data & 0xfffff000,
-        .rd = RD(data),
-    };
+// 32位指令各格式的操作数逐个字段写进inst, 其余字段由DECODE先清零。
+// 不在栈上构造整个inst_t再复制: 复制时的宽读要等前面的窄写, store forwarding会失败
+static FORCE_INLINE void inst_nonetype_read(inst_t *inst, uint32_t data) {}
+
+static FORCE_INLINE void inst_utype_read(inst_t *inst, uint32_t data) {
+    inst->imm = (int32_t)data & 0xfffff000;
+    inst->rd = RD(data);
 }
 
-static FORCE_INLINE inst_t inst_itype_read(uint32_t data) {
-    return (inst_t){
-        .imm = (int32_t)data >> 20,
-        .rs1 = RS1(data),
-        .rd = RD(data),
-    };
+static FORCE_INLINE void inst_itype_read(inst_t *inst, uint32_t data) {
+    inst->imm = (int32_t)data >> 20;
+    inst->rs1 = RS1(data);
+    inst->rd = RD(data);
 }
 
-static FORCE_INLINE inst_t inst_jtype_read(uint32_t data) {
+static FORCE_INLINE void inst_jtype_read(inst_t *inst, uint32_t data) {
     uint32_t imm20 = (data >> 31) & 0x1;
     uint32_t imm101 = (data >> 21) & 0x3ff;
     uint32_t imm11 = (data >> 20) & 0x1;
@@ -39,66 +39,49 @@ static FORCE_INLINE inst_t inst_jtype_read(uint32_t data) {
 
     int32_t imm =
         (imm20 << 20) | (imm1912 << 12) | (imm11 << 11) | (imm101 << 1);
-    imm = (imm << 11) >> 11;
-
-    return (inst_t){
-        .imm = imm,
-        .rd = RD(data),
-    };
+    inst->imm = (imm << 11) >> 11;
+    inst->rd = RD(data);
 }
 
-static FORCE_INLINE inst_t inst_btype_read(uint32_t data) {
+static FORCE_INLINE void inst_btype_read(inst_t *inst, uint32_t data) {
     uint32_t imm12 = (data >> 31) & 0x1;
     uint32_t imm105 = (data >> 25) & 0x3f;
     uint32_t imm41 = (data >> 8) & 0xf;
     uint32_t imm11 = (data >> 7) & 0x1;
 
     int32_t imm = (imm12 << 12) | (imm11 << 11) | (imm105 << 5) | (imm41 << 1);
-    imm = (imm << 19) >> 19;
-
-    return (inst_t){
-        .imm = imm,
-        .rs1 = RS1(data),
-        .rs2 = RS2(data),
-    };
+    inst->imm = (imm << 19) >> 19;
+    inst->rs1 = RS1(data);
+    inst->rs2 = RS2(data);
 }
 
-static FORCE_INLINE inst_t inst_rtype_read(uint32_t data) {
-    return (inst_t){
-        .rs1 = RS1(data),
-        .rs2 = RS2(data),
-        .rd = RD(data),
-    };
+static FORCE_INLINE void inst_rtype_read(inst_t *inst, uint32_t data) {
+    inst->rs1 = RS1(data);
+    inst->rs2 = RS2(data);
+    inst->rd = RD(data);
 }
 
-static FORCE_INLINE inst_t inst_stype_read(uint32_t data) {
+static FORCE_INLINE void inst_stype_read(inst_t *inst, uint32_t data) {
     uint32_t imm115 = (data >> 25) & 0x7f;
     uint32_t imm40 = (data >> 7) & 0x1f;
 
     int32_t imm = (imm115 << 5) | imm40;
-    imm = (imm << 20) >> 20;
-    return (inst_t){
-        .imm = imm,
-        .rs1 = RS1(data),
-        .rs2 = RS2(data),
-    };
+    inst->imm = (imm << 20) >> 20;
+    inst->rs1 = RS1(data);
+    inst->rs2 = RS2(data);
 }
 
-static FORCE_INLINE inst_t inst_csrtype_read(uint32_t data) {
-    return (inst_t){
-        .csr = data >> 20,
-        .rs1 = RS1(data),
-        .rd = RD(data),
-    };
+static FORCE_INLINE void inst_csrtype_read(inst_t *inst, uint32_t data) {
+    inst->csr = data >> 20;
+    inst->rs1 = RS1(data);
+    inst->rd = RD(data);
 }
 
-static FORCE_INLINE inst_t inst_fprtype_read(uint32_t data) {
-    return (inst_t){
-        .rs1 = RS1(data),
-        .rs2 = RS2(data),
-        .rs3 = RS3(data),
-        .rd = RD(data),
-    };
+static FORCE_INLINE void inst_r4type_read(inst_t *inst, uint32_t data) {
+    inst->rs1 = RS1(data);
+    inst->rs2 = RS2(data);
+    inst->rs3 = RS3(data);
+    inst->rd = RD(data);
 }
 
 /**
@@ -117,7 +100,6 @@ static FORCE_INLINE inst_t inst_catype_read(uint16_t data) {
     return (inst_t){
         .rd = RP1(data) + 8,
         .rs2 = RP2(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -125,7 +107,6 @@ static FORCE_INLINE inst_t inst_crtype_read(uint16_t data) {
     return (inst_t){
         .rs1 = RC1(data),
         .rs2 = RC2(data),
-        .rvc = true,
     };
 }
 
@@ -138,7 +119,6 @@ static FORCE_INLINE inst_t inst_citype_read(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RC1(data),
-        .rvc = true,
     };
 }
 
@@ -152,7 +132,6 @@ static FORCE_INLINE inst_t inst_citype_read2(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RC1(data),
-        .rvc = true,
     };
 }
 
@@ -170,7 +149,6 @@ static FORCE_INLINE inst_t inst_citype_read3(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RC1(data),
-        .rvc = true,
     };
 }
 
@@ -184,7 +162,6 @@ static FORCE_INLINE inst_t inst_citype_read4(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RC1(data),
-        .rvc = true,
     };
 }
 
@@ -197,7 +174,6 @@ static FORCE_INLINE inst_t inst_citype_read5(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RC1(data),
-        .rvc = true,
     };
 }
 
@@ -215,7 +191,6 @@ static FORCE_INLINE inst_t inst_cbtype_read(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rs1 = RP1(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -228,7 +203,6 @@ static FORCE_INLINE inst_t inst_cbtype_read2(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RP1(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -242,7 +216,6 @@ static FORCE_INLINE inst_t inst_cstype_read(uint16_t data) {
         .imm = imm,
         .rs1 = RP1(data) + 8,
         .rs2 = RP2(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -257,7 +230,6 @@ static FORCE_INLINE inst_t inst_cstype_read2(uint16_t data) {
         .imm = imm,
         .rs1 = RP1(data) + 8,
         .rs2 = RP2(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -277,7 +249,6 @@ static FORCE_INLINE inst_t inst_cjtype_read(uint16_t data) {
     imm = (imm << 20) >> 20;
     return (inst_t){
         .imm = imm,
-        .rvc = true,
     };
 }
 
@@ -292,7 +263,6 @@ static FORCE_INLINE inst_t inst_cltype_read(uint16_t data) {
         .imm = imm,
         .rs1 = RP1(data) + 8,
         .rd = RP2(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -306,7 +276,6 @@ static FORCE_INLINE inst_t inst_cltype_read2(uint16_t data) {
         .imm = imm,
         .rs1 = RP1(data) + 8,
         .rd = RP2(data) + 8,
-        .rvc = true,
     };
 }
 
@@ -319,7 +288,6 @@ static FORCE_INLINE inst_t inst_csstype_read(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rs2 = RC2(data),
-        .rvc = true,
     };
 }
 
@@ -332,7 +300,6 @@ static FORCE_INLINE inst_t inst_csstype_read2(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rs2 = RC2(data),
-        .rvc = true,
     };
 }
 
@@ -347,13 +314,35 @@ static FORCE_INLINE inst_t inst_ciwtype_read(uint16_t data) {
     return (inst_t){
         .imm = imm,
         .rd = RP2(data) + 8,
-        .rvc = true,
     };
 }
 
-void decode_inst(inst_t *inst, uint32_t data) {
-    uint32_t quadrant = QUADRANT(data);
-    switch (quadrant) {
+#define X(name, fmt, rd, rs1, rs2, rs3, fl, mk, mt)                            \
+    [inst_##name] = { mk, mt, isa_fmt_##fmt, isa_opnd_##rd, isa_opnd_##rs1,    \
+                      isa_opnd_##rs2, isa_opnd_##rs3, fl },
+const isa_info_t isa_info[num_insns] = { ISA_LIST(X) };
+#undef X
+
+// decodegen生成的decode_rv32的叶子
+#define DECODE(name, fmt, flags)                                               \
+    *inst = (inst_t){                                                          \
+        .type = inst_##name,                                                   \
+        .size = 4,                                                             \
+        .continue_exec = ((flags) & ISA_END) != 0,                             \
+    };                                                                         \
+    inst_##fmt##type_read(inst, data);                                         \
+    return true
+#include "decode_tree.h"
+
+/*
+ * 压缩指令的展开表, 下标是16位的指令字, 非法编码的size为0。
+ * 16位编码一共只有65536种, 启动时把四分之三(最低两位不是11的)全部展开一遍,
+ * 之后解码压缩指令只要查一次表。
+ */
+static inst_t rvc_table[1 << 16];
+
+static bool decode_rvc(inst_t *inst, uint16_t data) {
+    switch (QUADRANT(data)) {
     case 0x0: {
         uint32_t copcode = COPCODE(data);
 
@@ -362,38 +351,37 @@ void decode_inst(inst_t *inst, uint32_t data) {
             *inst = inst_ciwtype_read(data);
             inst->rs1 = sp;
             inst->type = inst_addi;
-            assert(inst->imm != 0);
-            return;
+            REQUIRE(inst->imm != 0);
+            return true;
         case 0x1: /* C.FLD */
             *inst = inst_cltype_read2(data);
             inst->type = inst_fld;
-            return;
+            return true;
         case 0x2: /* C.LW */
             *inst = inst_cltype_read(data);
             inst->type = inst_lw;
-            return;
+            return true;
         case 0x3: /* C.LD */
             *inst = inst_cltype_read2(data);
             inst->type = inst_ld;
-            return;
+            return true;
         case 0x5: /* C.FSD */
             *inst = inst_cstype_read(data);
             inst->type = inst_fsd;
-            return;
+            return true;
         case 0x6: /* C.SW */
             *inst = inst_cstype_read2(data);
             inst->type = inst_sw;
-            return;
+            return true;
         case 0x7: /* C.SD */
             *inst = inst_cstype_read(data);
             inst->type = inst_sd;
-            return;
+            return true;
         default:
-            printf("data: %x\n", data);
-            fatal("unimplemented");
+            return false;
         }
     }
-        unreachable();
+        return false;
     case 0x1: {
         uint32_t copcode = COPCODE(data);
 
@@ -402,34 +390,34 @@ void decode_inst(inst_t *inst, uint32_t data) {
             *inst = inst_citype_read(data);
             inst->rs1 = inst->rd;
             inst->type = inst_addi;
-            return;
+            return true;
         case 0x1: /* C.ADDIW */
             *inst = inst_citype_read(data);
-            assert(inst->rd != 0);
+            REQUIRE(inst->rd != 0);
             inst->rs1 = inst->rd;
             inst->type = inst_addiw;
-            return;
+            return true;
         case 0x2: /* C.LI */
             *inst = inst_citype_read(data);
             inst->rs1 = zero;
             inst->type = inst_addi;
-            return;
+            return true;
         case 0x3: {
             int32_t rd = RC1(data);
             if (rd == 2) { /* C.ADDI16SP */
                 *inst = inst_citype_read3(data);
-                assert(inst->imm != 0);
+                REQUIRE(inst->imm != 0);
                 inst->rs1 = inst->rd;
                 inst->type = inst_addi;
-                return;
+                return true;
             } else { /* C.LUI */
                 *inst = inst_citype_read5(data);
-                assert(inst->imm != 0);
+                REQUIRE(inst->imm != 0);
                 inst->type = inst_lui;
-                return;
+                return true;
             }
         }
-            unreachable();
+            return false;
         case 0x4: {
             uint32_t cfunct2high = CFUNCT2HIGH(data);
 
@@ -447,9 +435,9 @@ void decode_inst(inst_t *inst, uint32_t data) {
                 } else {
                     inst->type = inst_andi;
                 }
-                return;
+                return true;
             }
-                unreachable();
+                return false;
             case 0x3: {
                 uint32_t cfunct1 = CFUNCT1(data);
 
@@ -474,11 +462,11 @@ void decode_inst(inst_t *inst, uint32_t data) {
                         inst->type = inst_and;
                         break;
                     default:
-                        unreachable();
+                        return false;
                     }
-                    return;
+                    return true;
                 }
-                    unreachable();
+                    return false;
                 case 0x1: {
                     uint32_t cfunct2low = CFUNCT2LOW(data);
 
@@ -493,38 +481,39 @@ void decode_inst(inst_t *inst, uint32_t data) {
                         inst->type = inst_addw;
                         break;
                     default:
-                        unreachable();
+                        return false;
                     }
-                    return;
+                    return true;
                 }
-                    unreachable();
+                    return false;
                 default:
-                    unreachable();
+                    return false;
                 }
             }
-                unreachable();
+                return false;
             default:
-                unreachable();
+                return false;
             }
         }
-            unreachable();
+            return false;
         case 0x5: /* C.J */
             *inst = inst_cjtype_read(data);
             inst->rd = zero;
             inst->type = inst_jal;
             inst->continue_exec = true;
-            return;
+            return true;
         case 0x6: /* C.BEQZ */
         case 0x7: /* C.BNEZ */
             *inst = inst_cbtype_read(data);
             inst->rs2 = zero;
             inst->type = copcode == 0x6 ? inst_beq : inst_bne;
-            return;
+            inst->continue_exec = true;
+            return true;
         default:
-            fatal("unrecognized copcode");
+            return false;
         }
     }
-        unreachable();
+        return false;
     case 0x2: {
         uint32_t copcode = COPCODE(data);
         switch (copcode) {
@@ -532,24 +521,24 @@ void decode_inst(inst_t *inst, uint32_t data) {
             *inst = inst_citype_read(data);
             inst->rs1 = inst->rd;
             inst->type = inst_slli;
-            return;
+            return true;
         case 0x1: /* C.FLDSP */
             *inst = inst_citype_read2(data);
             inst->rs1 = sp;
             inst->type = inst_fld;
-            return;
+            return true;
         case 0x2: /* C.LWSP */
             *inst = inst_citype_read4(data);
-            assert(inst->rd != 0);
+            REQUIRE(inst->rd != 0);
             inst->rs1 = sp;
             inst->type = inst_lw;
-            return;
+            return true;
         case 0x3: /* C.LDSP */
             *inst = inst_citype_read2(data);
-            assert(inst->rd != 0);
+            REQUIRE(inst->rd != 0);
             inst->rs1 = sp;
             inst->type = inst_ld;
-            return;
+            return true;
         case 0x4: {
             uint32_t cfunct1 = CFUNCT1(data);
 
@@ -558,7 +547,7 @@ void decode_inst(inst_t *inst, uint32_t data) {
                 *inst = inst_crtype_read(data);
 
                 if (inst->rs2 == 0) { /* C.JR */
-                    assert(inst->rs1 != 0);
+                    REQUIRE(inst->rs1 != 0);
                     inst->rd = zero;
                     inst->type = inst_jalr;
                     inst->continue_exec = true;
@@ -567,13 +556,13 @@ void decode_inst(inst_t *inst, uint32_t data) {
                     inst->rs1 = zero;
                     inst->type = inst_add;
                 }
-                return;
+                return true;
             }
-                unreachable();
+                return false;
             case 0x1: {
                 *inst = inst_crtype_read(data);
                 if (inst->rs1 == 0 && inst->rs2 == 0) { /* C.EBREAK */
-                    fatal("unimplmented");
+                    return false;
                 } else if (inst->rs2 == 0) { /* C.JALR */
                     inst->rd = ra;
                     inst->type = inst_jalr;
@@ -583,801 +572,67 @@ void decode_inst(inst_t *inst, uint32_t data) {
                     inst->rd = inst->rs1;
                     inst->type = inst_add;
                 }
-                return;
+                return true;
             }
-                unreachable();
+                return false;
             default:
-                unreachable();
+                return false;
             }
         }
-            unreachable();
+            return false;
         case 0x5: /* C.FSDSP */
             *inst = inst_csstype_read(data);
             inst->rs1 = sp;
             inst->type = inst_fsd;
-            return;
+            return true;
         case 0x6: /* C.SWSP */
             *inst = inst_csstype_read2(data);
             inst->rs1 = sp;
             inst->type = inst_sw;
-            return;
+            return true;
         case 0x7: /* C.SDSP */
             *inst = inst_csstype_read(data);
             inst->rs1 = sp;
             inst->type = inst_sd;
-            return;
+            return true;
         default:
-            fatal("unrecognized copcode");
+            return false;
         }
     }
-        unreachable();
-    case 0x3: {
-        uint32_t opcode = OPCODE(data);
-        switch (opcode) {
-        case 0x0: {
-            uint32_t funct3 = FUNCT3(data);
-
-            *inst = inst_itype_read(data);
-            switch (funct3) {
-            case 0x0: /* LB */
-                inst->type = inst_lb;
-                return;
-            case 0x1: /* LH */
-                inst->type = inst_lh;
-                return;
-            case 0x2: /* LW */
-                inst->type = inst_lw;
-                return;
-            case 0x3: /* LD */
-                inst->type = inst_ld;
-                return;
-            case 0x4: /* LBU */
-                inst->type = inst_lbu;
-                return;
-            case 0x5: /* LHU */
-                inst->type = inst_lhu;
-                return;
-            case 0x6: /* LWU */
-                inst->type = inst_lwu;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x1: {
-            uint32_t funct3 = FUNCT3(data);
-
-            *inst = inst_itype_read(data);
-            switch (funct3) {
-            case 0x2: /* FLW */
-                inst->type = inst_flw;
-                return;
-            case 0x3: /* FLD */
-                inst->type = inst_fld;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x3: {
-            uint32_t funct3 = FUNCT3(data);
-
-            switch (funct3) {
-            case 0x0: { /* FENCE */
-                inst_t _inst = { 0 };
-                *inst = _inst;
-                inst->type = inst_fence;
-                return;
-            }
-            case 0x1: { /* FENCE.I */
-                inst_t _inst = { 0 };
-                *inst = _inst;
-                inst->type = inst_fence_i;
-                return;
-            }
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x4: {
-            uint32_t funct3 = FUNCT3(data);
-
-            *inst = inst_itype_read(data);
-            switch (funct3) {
-            case 0x0: /* ADDI */
-                inst->type = inst_addi;
-                return;
-            case 0x1: {
-                uint32_t imm116 = IMM116(data);
-                if (imm116 == 0) { /* SLLI */
-                    inst->type = inst_slli;
-                } else {
-                    unreachable();
-                }
-                return;
-            }
-                unreachable();
-            case 0x2: /* SLTI */
-                inst->type = inst_slti;
-                return;
-            case 0x3: /* SLTIU */
-                inst->type = inst_sltiu;
-                return;
-            case 0x4: /* XORI */
-                inst->type = inst_xori;
-                return;
-            case 0x5: {
-                uint32_t imm116 = IMM116(data);
-
-                if (imm116 == 0x0) { /* SRLI */
-                    inst->type = inst_srli;
-                } else if (imm116 == 0x10) { /* SRAI */
-                    inst->type = inst_srai;
-                } else {
-                    unreachable();
-                }
-                return;
-            }
-                unreachable();
-            case 0x6: /* ORI */
-                inst->type = inst_ori;
-                return;
-            case 0x7: /* ANDI */
-                inst->type = inst_andi;
-                return;
-            default:
-                fatal("unrecognized funct3");
-            }
-        }
-            unreachable();
-        case 0x5: /* AUIPC */
-            *inst = inst_utype_read(data);
-            inst->type = inst_auipc;
-            return;
-        case 0x6: {
-            uint32_t funct3 = FUNCT3(data);
-            uint32_t funct7 = FUNCT7(data);
-
-            *inst = inst_itype_read(data);
-
-            switch (funct3) {
-            case 0x0: /* ADDIW */
-                inst->type = inst_addiw;
-                return;
-            case 0x1: /* SLLIW */
-                assert(funct7 == 0);
-                inst->type = inst_slliw;
-                return;
-            case 0x5: {
-                switch (funct7) {
-                case 0x0: /* SRLIW */
-                    inst->type = inst_srliw;
-                    return;
-                case 0x20: /* SRAIW */
-                    inst->type = inst_sraiw;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            default:
-                fatal("unimplemented");
-            }
-        }
-            unreachable();
-        case 0x8: {
-            uint32_t funct3 = FUNCT3(data);
-
-            *inst = inst_stype_read(data);
-            switch (funct3) {
-            case 0x0: /* SB */
-                inst->type = inst_sb;
-                return;
-            case 0x1: /* SH */
-                inst->type = inst_sh;
-                return;
-            case 0x2: /* SW */
-                inst->type = inst_sw;
-                return;
-            case 0x3: /* SD */
-                inst->type = inst_sd;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x9: {
-            uint32_t funct3 = FUNCT3(data);
-
-            *inst = inst_stype_read(data);
-            switch (funct3) {
-            case 0x2: /* FSW */
-                inst->type = inst_fsw;
-                return;
-            case 0x3: /* FSD */
-                inst->type = inst_fsd;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0xc: {
-            *inst = inst_rtype_read(data);
-
-            uint32_t funct3 = FUNCT3(data);
-            uint32_t funct7 = FUNCT7(data);
-
-            switch (funct7) {
-            case 0x0: {
-                switch (funct3) {
-                case 0x0: /* ADD */
-                    inst->type = inst_add;
-                    return;
-                case 0x1: /* SLL */
-                    inst->type = inst_sll;
-                    return;
-                case 0x2: /* SLT */
-                    inst->type = inst_slt;
-                    return;
-                case 0x3: /* SLTU */
-                    inst->type = inst_sltu;
-                    return;
-                case 0x4: /* XOR */
-                    inst->type = inst_xor;
-                    return;
-                case 0x5: /* SRL */
-                    inst->type = inst_srl;
-                    return;
-                case 0x6: /* OR */
-                    inst->type = inst_or;
-                    return;
-                case 0x7: /* AND */
-                    inst->type = inst_and;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x1: {
-                switch (funct3) {
-                case 0x0: /* MUL */
-                    inst->type = inst_mul;
-                    return;
-                case 0x1: /* MULH */
-                    inst->type = inst_mulh;
-                    return;
-                case 0x2: /* MULHSU */
-                    inst->type = inst_mulhsu;
-                    return;
-                case 0x3: /* MULHU */
-                    inst->type = inst_mulhu;
-                    return;
-                case 0x4: /* DIV */
-                    inst->type = inst_div;
-                    return;
-                case 0x5: /* DIVU */
-                    inst->type = inst_divu;
-                    return;
-                case 0x6: /* REM */
-                    inst->type = inst_rem;
-                    return;
-                case 0x7: /* REMU */
-                    inst->type = inst_remu;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x20: {
-                switch (funct3) {
-                case 0x0: /* SUB */
-                    inst->type = inst_sub;
-                    return;
-                case 0x5: /* SRA */
-                    inst->type = inst_sra;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0xd: /* LUI */
-            *inst = inst_utype_read(data);
-            inst->type = inst_lui;
-            return;
-        case 0xe: {
-            *inst = inst_rtype_read(data);
-
-            uint32_t funct3 = FUNCT3(data);
-            uint32_t funct7 = FUNCT7(data);
-
-            switch (funct7) {
-            case 0x0: {
-                switch (funct3) {
-                case 0x0: /* ADDW */
-                    inst->type = inst_addw;
-                    return;
-                case 0x1: /* SLLW */
-                    inst->type = inst_sllw;
-                    return;
-                case 0x5: /* SRLW */
-                    inst->type = inst_srlw;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x1: {
-                switch (funct3) {
-                case 0x0: /* MULW */
-                    inst->type = inst_mulw;
-                    return;
-                case 0x4: /* DIVW */
-                    inst->type = inst_divw;
-                    return;
-                case 0x5: /* DIVUW */
-                    inst->type = inst_divuw;
-                    return;
-                case 0x6: /* REMW */
-                    inst->type = inst_remw;
-                    return;
-                case 0x7: /* REMUW */
-                    inst->type = inst_remuw;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x20: {
-                switch (funct3) {
-                case 0x0: /* SUBW */
-                    inst->type = inst_subw;
-                    return;
-                case 0x5: /* SRAW */
-                    inst->type = inst_sraw;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x10: {
-            uint32_t funct2 = FUNCT2(data);
-
-            *inst = inst_fprtype_read(data);
-            switch (funct2) {
-            case 0x0: /* FMADD.S */
-                inst->type = inst_fmadd_s;
-                return;
-            case 0x1: /* FMADD.D */
-                inst->type = inst_fmadd_d;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x11: {
-            uint32_t funct2 = FUNCT2(data);
-
-            *inst = inst_fprtype_read(data);
-            switch (funct2) {
-            case 0x0: /* FMSUB.S */
-                inst->type = inst_fmsub_s;
-                return;
-            case 0x1: /* FMSUB.D */
-                inst->type = inst_fmsub_d;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x12: {
-            uint32_t funct2 = FUNCT2(data);
-
-            *inst = inst_fprtype_read(data);
-            switch (funct2) {
-            case 0x0: /* FNMSUB.S */
-                inst->type = inst_fnmsub_s;
-                return;
-            case 0x1: /* FNMSUB.D */
-                inst->type = inst_fnmsub_d;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x13: {
-            uint32_t funct2 = FUNCT2(data);
-
-            *inst = inst_fprtype_read(data);
-            switch (funct2) {
-            case 0x0: /* FNMADD.S */
-                inst->type = inst_fnmadd_s;
-                return;
-            case 0x1: /* FNMADD.D */
-                inst->type = inst_fnmadd_d;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x14: {
-            uint32_t funct7 = FUNCT7(data);
-
-            *inst = inst_rtype_read(data);
-            switch (funct7) {
-            case 0x0: /* FADD.S */
-                inst->type = inst_fadd_s;
-                return;
-            case 0x1: /* FADD.D */
-                inst->type = inst_fadd_d;
-                return;
-            case 0x4: /* FSUB.S */
-                inst->type = inst_fsub_s;
-                return;
-            case 0x5: /* FSUB.D */
-                inst->type = inst_fsub_d;
-                return;
-            case 0x8: /* FMUL.S */
-                inst->type = inst_fmul_s;
-                return;
-            case 0x9: /* FMUL.D */
-                inst->type = inst_fmul_d;
-                return;
-            case 0xc: /* FDIV.S */
-                inst->type = inst_fdiv_s;
-                return;
-            case 0xd: /* FDIV.D */
-                inst->type = inst_fdiv_d;
-                return;
-            case 0x10: {
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FSGNJ.S */
-                    inst->type = inst_fsgnj_s;
-                    return;
-                case 0x1: /* FSGNJN.S */
-                    inst->type = inst_fsgnjn_s;
-                    return;
-                case 0x2: /* FSGNJX.S */
-                    inst->type = inst_fsgnjx_s;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x11: {
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FSGNJ.D */
-                    inst->type = inst_fsgnj_d;
-                    return;
-                case 0x1: /* FSGNJN.D */
-                    inst->type = inst_fsgnjn_d;
-                    return;
-                case 0x2: /* FSGNJX.D */
-                    inst->type = inst_fsgnjx_d;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x14: {
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FMIN.S */
-                    inst->type = inst_fmin_s;
-                    return;
-                case 0x1: /* FMAX.S */
-                    inst->type = inst_fmax_s;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x15: {
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FMIN.D */
-                    inst->type = inst_fmin_d;
-                    return;
-                case 0x1: /* FMAX.D */
-                    inst->type = inst_fmax_d;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x20: /* FCVT.S.D */
-                assert(RS2(data) == 1);
-                inst->type = inst_fcvt_s_d;
-                return;
-            case 0x21: /* FCVT.D.S */
-                assert(RS2(data) == 0);
-                inst->type = inst_fcvt_d_s;
-                return;
-            case 0x2c: /* FSQRT.S */
-                assert(inst->rs2 == 0);
-                inst->type = inst_fsqrt_s;
-                return;
-            case 0x2d: /* FSQRT.D */
-                assert(inst->rs2 == 0);
-                inst->type = inst_fsqrt_d;
-                return;
-            case 0x50: {
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FLE.S */
-                    inst->type = inst_fle_s;
-                    return;
-                case 0x1: /* FLT.S */
-                    inst->type = inst_flt_s;
-                    return;
-                case 0x2: /* FEQ.S */
-                    inst->type = inst_feq_s;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x51: {
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FLE.D */
-                    inst->type = inst_fle_d;
-                    return;
-                case 0x1: /* FLT.D */
-                    inst->type = inst_flt_d;
-                    return;
-                case 0x2: /* FEQ.D */
-                    inst->type = inst_feq_d;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x60: {
-                uint32_t rs2 = RS2(data);
-
-                switch (rs2) {
-                case 0x0: /* FCVT.W.S */
-                    inst->type = inst_fcvt_w_s;
-                    return;
-                case 0x1: /* FCVT.WU.S */
-                    inst->type = inst_fcvt_wu_s;
-                    return;
-                case 0x2: /* FCVT.L.S */
-                    inst->type = inst_fcvt_l_s;
-                    return;
-                case 0x3: /* FCVT.LU.S */
-                    inst->type = inst_fcvt_lu_s;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x61: {
-                uint32_t rs2 = RS2(data);
-
-                switch (rs2) {
-                case 0x0: /* FCVT.W.D */
-                    inst->type = inst_fcvt_w_d;
-                    return;
-                case 0x1: /* FCVT.WU.D */
-                    inst->type = inst_fcvt_wu_d;
-                    return;
-                case 0x2: /* FCVT.L.D */
-                    inst->type = inst_fcvt_l_d;
-                    return;
-                case 0x3: /* FCVT.LU.D */
-                    inst->type = inst_fcvt_lu_d;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x68: {
-                uint32_t rs2 = RS2(data);
-
-                switch (rs2) {
-                case 0x0: /* FCVT.S.W */
-                    inst->type = inst_fcvt_s_w;
-                    return;
-                case 0x1: /* FCVT.S.WU */
-                    inst->type = inst_fcvt_s_wu;
-                    return;
-                case 0x2: /* FCVT.S.L */
-                    inst->type = inst_fcvt_s_l;
-                    return;
-                case 0x3: /* FCVT.S.LU */
-                    inst->type = inst_fcvt_s_lu;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x69: {
-                uint32_t rs2 = RS2(data);
-
-                switch (rs2) {
-                case 0x0: /* FCVT.D.W */
-                    inst->type = inst_fcvt_d_w;
-                    return;
-                case 0x1: /* FCVT.D.WU */
-                    inst->type = inst_fcvt_d_wu;
-                    return;
-                case 0x2: /* FCVT.D.L */
-                    inst->type = inst_fcvt_d_l;
-                    return;
-                case 0x3: /* FCVT.D.LU */
-                    inst->type = inst_fcvt_d_lu;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x70: {
-                assert(RS2(data) == 0);
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FMV.X.W */
-                    inst->type = inst_fmv_x_w;
-                    return;
-                case 0x1: /* FCLASS.S */
-                    inst->type = inst_fclass_s;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x71: {
-                assert(RS2(data) == 0);
-                uint32_t funct3 = FUNCT3(data);
-
-                switch (funct3) {
-                case 0x0: /* FMV.X.D */
-                    inst->type = inst_fmv_x_d;
-                    return;
-                case 0x1: /* FCLASS.D */
-                    inst->type = inst_fclass_d;
-                    return;
-                default:
-                    unreachable();
-                }
-            }
-                unreachable();
-            case 0x78: /* FMV_W_X */
-                assert(RS2(data) == 0 && FUNCT3(data) == 0);
-                inst->type = inst_fmv_w_x;
-                return;
-            case 0x79: /* FMV_D_X */
-                assert(RS2(data) == 0 && FUNCT3(data) == 0);
-                inst->type = inst_fmv_d_x;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x18: {
-            *inst = inst_btype_read(data);
-
-            uint32_t funct3 = FUNCT3(data);
-            switch (funct3) {
-            case 0x0: /* BEQ */
-                inst->type = inst_beq;
-                return;
-            case 0x1: /* BNE */
-                inst->type = inst_bne;
-                return;
-            case 0x4: /* BLT */
-                inst->type = inst_blt;
-                return;
-            case 0x5: /* BGE */
-                inst->type = inst_bge;
-                return;
-            case 0x6: /* BLTU */
-                inst->type = inst_bltu;
-                return;
-            case 0x7: /* BGEU */
-                inst->type = inst_bgeu;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        case 0x19: /* JALR */
-            *inst = inst_itype_read(data);
-            inst->type = inst_jalr;
-            inst->continue_exec = true;
-            return;
-        case 0x1b: /* JAL */
-            *inst = inst_jtype_read(data);
-            inst->type = inst_jal;
-            inst->continue_exec = true;
-            return;
-        case 0x1c: {
-            if (data == 0x73) { /* ECALL */
-                inst->type = inst_ecall;
-                inst->continue_exec = true;
-                return;
-            }
+        return false;
+    default:
+        return false;
+    }
+}
 
-            uint32_t funct3 = FUNCT3(data);
-            *inst = inst_csrtype_read(data);
-            switch (funct3) {
-            case 0x1: /* CSRRW */
-                inst->type = inst_csrrw;
-                return;
-            case 0x2: /* CSRRS */
-                inst->type = inst_csrrs;
-                return;
-            case 0x3: /* CSRRC */
-                inst->type = inst_csrrc;
-                return;
-            case 0x5: /* CSRRWI */
-                inst->type = inst_csrrwi;
-                return;
-            case 0x6: /* CSRRSI */
-                inst->type = inst_csrrsi;
-                return;
-            case 0x7: /* CSRRCI */
-                inst->type = inst_csrrci;
-                return;
-            default:
-                unreachable();
-            }
-        }
-            unreachable();
-        default:
-            unreachable();
+__attribute__((constructor)) static void rvc_table_init(void) {
+    for (uint32_t data = 0; data < ARRAY_SIZE(rvc_table); data++) {
+        inst_t inst;
+        if (QUADRANT(data) != 0x3 && decode_rvc(&inst, data)) {
+            inst.size = 2;
+            rvc_table[data] = inst;
         }
     }
-        unreachable();
+}
+
+// 解码一条指令, 不认识的编码返回false, inst的内容此时没有意义
+bool decode_try(inst_t *inst, uint32_t data) {
+    uint32_t quadrant = QUADRANT(data);
+    switch (quadrant) {
+    case 0x0:
+    case 0x1:
+    case 0x2:
+        *inst = rvc_table[data & 0xffff];
+        return inst->size != 0;
+    case 0x3:
+        return decode_rv32(inst, data);
     default:
-        unreachable();
+        return false;
     }
-}
\ No newline at end of file
+}
+
+// 执行到的指令必须能解码
+void decode_inst(inst_t *inst, uint32_t data) {
+    if (!decode_try(inst, data))
+        fatalf("illegal instruction: %08x", data);
+}
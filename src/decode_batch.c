@@ -0,0 +1,262 @@
+#include "rvemu.h"
+
+/*
+ * 批量解码, 预解码整个代码段时使用(见predecode.c)
+ *
+ * 常见的32位整数指令(I/S/B/U/J/R格式)的类型只由opcode、funct3和funct7决定,
+ * 而且funct7只有0x00/0x01/0x20三种取值有意义。按(opcode, funct3, funct7的类别)
+ * 查一张1024项的表就能得到类型、用到的字段和立即数的格式。
+ * x86_64上用AVX2一次处理8条: 各字段、五种立即数、查表(gather)、按格式选立即数
+ * 和清空不用的字段全在向量寄存器里完成。inst_t只有8字节, 低4字节是imm,
+ * 高4字节是type/size/寄存器等位域, 拼好之后两次向量写入就是8条inst_t。
+ * 压缩指令、浮点、CSR、移位立即数等表里没有的编码交给decode_try,
+ * 结果与decode_try逐字段一致。
+ *
+ * 表项的格式:
+ *   bits 0-15  指令类型, BATCH_SCALAR表示交给decode_try
+ *   bit 16-18  是否用到rd/rs1/rs2
+ *   bit 19     continue_exec
+ *   bits 20-22 立即数格式(enum imm_kind_t)
+ */
+
+#define BATCH_SCALAR 0xffff
+#define BATCH_RD (1 << 16)
+#define BATCH_RS1 (1 << 17)
+#define BATCH_RS2 (1 << 18)
+#define BATCH_CONTINUE (1 << 19)
+#define BATCH_KIND_SHIFT 20
+
+enum imm_kind_t { imm_none, imm_i, imm_s, imm_b, imm_u, imm_j };
+
+static const uint32_t formats[32] = {
+    [0x00] = BATCH_RD | BATCH_RS1 | imm_i << BATCH_KIND_SHIFT,  // LOAD
+    [0x04] = BATCH_RD | BATCH_RS1 | imm_i << BATCH_KIND_SHIFT,  // OP-IMM
+    [0x05] = BATCH_RD | imm_u << BATCH_KIND_SHIFT,              // AUIPC
+    [0x06] = BATCH_RD | BATCH_RS1 | imm_i << BATCH_KIND_SHIFT,  // OP-IMM-32
+    [0x08] = BATCH_RS1 | BATCH_RS2 | imm_s << BATCH_KIND_SHIFT, // STORE
+    [0x0c] = BATCH_RD | BATCH_RS1 | BATCH_RS2,                  // OP
+    [0x0d] = BATCH_RD | imm_u << BATCH_KIND_SHIFT,              // LUI
+    [0x0e] = BATCH_RD | BATCH_RS1 | BATCH_RS2,                  // OP-32
+    [0x18] = BATCH_RS1 | BATCH_RS2 | imm_b << BATCH_KIND_SHIFT, // BRANCH
+    [0x19] = BATCH_RD | BATCH_RS1 | imm_i << BATCH_KIND_SHIFT,  // JALR
+    [0x1b] = BATCH_RD | imm_j << BATCH_KIND_SHIFT,              // JAL
+};
+
+static const uint32_t funct7s[3] = { 0x00, 0x01, 0x20 };
+
+static uint32_t table[32 * 8 * 4]; // 下标: opcode << 5 | funct3 << 2 | funct7类别
+static uint32_t packed[32 * 8 * 4]; // 同一下标, inst_t高4字节中type/size/continue_exec的位
+static pthread_once_t table_once = PTHREAD_ONCE_INIT;
+
+// inst_t高4字节中rd/rs1/rs2的位置, 位域的排列由编译器决定, 初始化时探测
+static uint32_t rd_shift, rs1_shift, rs2_shift;
+
+static uint32_t high_word(inst_t inst) {
+    uint32_t w;
+    memcpy(&w, (char *)&inst + 4, 4);
+    return w;
+}
+
+// 每一项用一条只有这几个字段的指令字交给decode_try, 类型表不用再写一遍
+static void table_init(void) {
+    for (uint32_t opcode = 0; opcode < 32; opcode++) {
+        for (uint32_t funct3 = 0; funct3 < 8; funct3++) {
+            for (uint32_t f7 = 0; f7 < 4; f7++) {
+                uint32_t idx = opcode << 5 | funct3 << 2 | f7;
+                table[idx] = BATCH_SCALAR;
+
+                bool rtype = opcode == 0x0c || opcode == 0x0e;
+                // 移位立即数的类型还取决于立即数的高位
+                bool shift = (opcode == 0x04 || opcode == 0x06) &&
+                             (funct3 == 0x1 || funct3 == 0x5);
+                if (formats[opcode] == 0 || shift || (rtype && f7 == 3))
+                    continue;
+
+                uint32_t data = 0x3 | opcode << 2 | funct3 << 12;
+                if (rtype)
+                    data |= funct7s[f7] << 25;
+                inst_t inst;
+                if (!decode_try(&inst, data))
+                    continue;
+                table[idx] = inst.type | formats[opcode] |
+                             (inst.continue_exec ? BATCH_CONTINUE : 0);
+                packed[idx] = high_word((inst_t){
+                    .type = inst.type,
+                    .size = inst.size,
+                    .continue_exec = inst.continue_exec,
+                });
+            }
+        }
+    }
+
+    rd_shift = __builtin_ctz(high_word((inst_t){ .rd = 1 }));
+    rs1_shift = __builtin_ctz(high_word((inst_t){ .rs1 = 1 }));
+    rs2_shift = __builtin_ctz(high_word((inst_t){ .rs2 = 1 }));
+}
+
+static uint32_t decode_scalar(
+    inst_t *insts, const uint32_t *words, uint32_t n, bool *ok
+) {
+    uint32_t decoded = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        ok[i] = decode_try(&insts[i], words[i]);
+        decoded += ok[i];
+    }
+    return decoded;
+}
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+static AVX2 inline __m256i bits(__m256i w, int shift, uint32_t mask) {
+    return _mm256_and_si256(
+        _mm256_srli_epi32(w, shift), _mm256_set1_epi32(mask)
+    );
+}
+
+static AVX2 inline __m256i select_imm(
+    __m256i imm, __m256i kind, enum imm_kind_t k, __m256i val
+) {
+    __m256i m = _mm256_cmpeq_epi32(kind, _mm256_set1_epi32(k));
+    return _mm256_blendv_epi8(imm, val, m);
+}
+
+static AVX2 inline __m256i keep(__m256i v, __m256i e, uint32_t flag) {
+    __m256i f = _mm256_set1_epi32(flag);
+    return _mm256_and_si256(v, _mm256_cmpeq_epi32(_mm256_and_si256(e, f), f));
+}
+
+static AVX2 uint32_t decode_avx2(
+    inst_t *insts, const uint32_t *words, uint32_t n, bool *ok
+) {
+    uint32_t decoded = 0;
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_loadu_si256((const __m256i *)(words + i));
+
+        __m256i opcode = bits(w, 2, 0x1f);
+        __m256i funct3 = bits(w, 12, 0x7);
+        __m256i funct7 = _mm256_srli_epi32(w, 25);
+        __m256i rd = bits(w, 7, 0x1f);
+        __m256i rs1 = bits(w, 15, 0x1f);
+        __m256i rs2 = bits(w, 20, 0x1f);
+
+        // funct7的类别: 0x00 -> 0, 0x01 -> 1, 0x20 -> 2, 其它 -> 3
+        __m256i is0 = _mm256_cmpeq_epi32(funct7, _mm256_setzero_si256());
+        __m256i is1 = _mm256_cmpeq_epi32(funct7, _mm256_set1_epi32(0x01));
+        __m256i is20 = _mm256_cmpeq_epi32(funct7, _mm256_set1_epi32(0x20));
+        __m256i f7 = _mm256_blendv_epi8(
+            _mm256_set1_epi32(3),
+            _mm256_or_si256(
+                _mm256_and_si256(is1, _mm256_set1_epi32(1)),
+                _mm256_and_si256(is20, _mm256_set1_epi32(2))
+            ),
+            _mm256_or_si256(_mm256_or_si256(is0, is1), is20)
+        );
+        __m256i idx = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_slli_epi32(opcode, 5), _mm256_slli_epi32(funct3, 2)
+            ),
+            f7
+        );
+        __m256i e = _mm256_i32gather_epi32((const int *)table, idx, 4);
+
+        // 五种立即数, 都按符号扩展到32位
+        __m256i sign = _mm256_srai_epi32(w, 31);
+        __m256i imm_i_v = _mm256_srai_epi32(w, 20);
+        __m256i imm_s_v = _mm256_or_si256(
+            _mm256_andnot_si256(_mm256_set1_epi32(0x1f), imm_i_v), rd
+        );
+        __m256i imm_b_v = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_slli_epi32(sign, 12), bits(w, 20, 0x7e0)
+            ),
+            _mm256_or_si256(
+                bits(w, 7, 0x1e),
+                _mm256_and_si256(
+                    _mm256_slli_epi32(w, 4), _mm256_set1_epi32(0x800)
+                )
+            )
+        );
+        __m256i imm_u_v = _mm256_and_si256(w, _mm256_set1_epi32(0xfffff000));
+        __m256i imm_j_v = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_slli_epi32(sign, 20),
+                _mm256_and_si256(w, _mm256_set1_epi32(0xff000))
+            ),
+            _mm256_or_si256(bits(w, 9, 0x800), bits(w, 20, 0x7fe))
+        );
+
+        __m256i kind = bits(e, BATCH_KIND_SHIFT, 0x7);
+        __m256i imm = _mm256_setzero_si256();
+        imm = select_imm(imm, kind, imm_i, imm_i_v);
+        imm = select_imm(imm, kind, imm_s, imm_s_v);
+        imm = select_imm(imm, kind, imm_b, imm_b_v);
+        imm = select_imm(imm, kind, imm_u, imm_u_v);
+        imm = select_imm(imm, kind, imm_j, imm_j_v);
+
+        rd = keep(rd, e, BATCH_RD);
+        rs1 = keep(rs1, e, BATCH_RS1);
+        rs2 = keep(rs2, e, BATCH_RS2);
+
+        // 压缩指令和表里没有的编码
+        __m256i quad = _mm256_and_si256(w, _mm256_set1_epi32(0x3));
+        __m256i slow = _mm256_or_si256(
+            _mm256_xor_si256(
+                _mm256_cmpeq_epi32(quad, _mm256_set1_epi32(0x3)),
+                _mm256_set1_epi32(-1)
+            ),
+            _mm256_cmpeq_epi32(
+                _mm256_and_si256(e, _mm256_set1_epi32(0xffff)),
+                _mm256_set1_epi32(BATCH_SCALAR)
+            )
+        );
+        uint32_t slow_mask = _mm256_movemask_ps(_mm256_castsi256_ps(slow));
+
+        // 高4字节: 表里的type/size/continue_exec加上三个寄存器
+        __m256i hi = _mm256_i32gather_epi32((const int *)packed, idx, 4);
+        hi = _mm256_or_si256(
+            hi, _mm256_sll_epi32(rd, _mm_cvtsi32_si128(rd_shift))
+        );
+        hi = _mm256_or_si256(
+            hi, _mm256_sll_epi32(rs1, _mm_cvtsi32_si128(rs1_shift))
+        );
+        hi = _mm256_or_si256(
+            hi, _mm256_sll_epi32(rs2, _mm_cvtsi32_si128(rs2_shift))
+        );
+        // 交错成(imm, 高4字节)对: a是第0、1、4、5条, b是第2、3、6、7条
+        __m256i a = _mm256_unpacklo_epi32(imm, hi);
+        __m256i b = _mm256_unpackhi_epi32(imm, hi);
+        __m256i *out = (__m256i *)(insts + i);
+        _mm256_storeu_si256(out, _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(a, b, 0x31));
+
+        // 只有慢速的几条逐条交给decode_try
+        memset(&ok[i], true, 8);
+        decoded += 8 - __builtin_popcount(slow_mask);
+        for (uint32_t m = slow_mask; m != 0; m &= m - 1) {
+            uint32_t k = i + __builtin_ctz(m);
+            ok[k] = decode_try(&insts[k], words[k]);
+            decoded += ok[k];
+        }
+    }
+    return decoded + decode_scalar(insts + i, words + i, n - i, ok + i);
+}
+
+#endif
+
+/*
+ * 解码words[0..n), ok[i]表示第i条是否解出了指令(同decode_try的返回值),
+ * 返回解出的条数。
+ */
+uint32_t
+decode_batch(inst_t *insts, const uint32_t *words, uint32_t n, bool *ok) {
+    pthread_once(&table_once, table_init);
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2"))
+        return decode_avx2(insts, words, n, ok);
+#endif
+    return decode_scalar(insts, words, n, ok);
+}
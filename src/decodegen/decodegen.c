@@ -0,0 +1,196 @@
+#include "../rvemu.h"
+
+/*
+ * 构建时工具: 按isa.h的编码表生成32位指令的解码函数, 输出供decode.c包含的C代码。
+ *
+ * 用法: decodegen > decode_tree.h
+ *
+ * 先建一棵解码树: 第一层固定按opcode和funct3分支, 之后每个节点在还没检查过、
+ * 且这组指令都固定的位中, 取包含最低的取值不全相同的位的一段(最多MAX_WIDTH位),
+ * 按取值把指令分到各个子节点, 直到只剩一条指令。只有R型、移位立即数和浮点指令
+ * 需要第二层(funct7、rs2等)。再把树输出成嵌套的switch, 叶子是DECODE(name, format,
+ * flags), 沿途没有检查到的固定位在叶子前用REQUIRE检查, 取操作数的代码在各分支内联。
+ * 两条指令的编码重叠(无法区分)时直接报错, 编码表的问题在构建时就能发现。
+ */
+
+#define MAX_WIDTH 8
+#define MAX_NODES 1024
+#define ROOT_BITS 0x707f // opcode和funct3, 最低两位是11才是32位指令
+
+typedef struct {
+    const char *name;
+    const char *format;
+    const char *flags;
+    uint32_t mask;
+    uint32_t match;
+} spec_t;
+
+static const spec_t specs[] = {
+#define X(name, fmt, rd, rs1, rs2, rs3, fl, mk, mt)                            \
+    { #name, #fmt, #fl, mk, mt },
+    ISA_LIST(X)
+#undef X
+};
+
+typedef struct {
+    int spec;       // 叶子对应的指令, 内部节点为-1
+    uint32_t known; // 到这里为止检查过的位
+    uint32_t shift;
+    uint32_t width;
+    int *children; // 1 << width项, -1表示非法编码
+} node_t;
+
+static node_t nodes[MAX_NODES];
+static int nnodes;
+static uint32_t depth;
+
+static int new_node(int spec, uint32_t known) {
+    if (nnodes == MAX_NODES)
+        fatal("decode tree too large");
+    nodes[nnodes] = (node_t){ .spec = spec, .known = known };
+    return nnodes++;
+}
+
+// idx[0..n)是还没区分开的指令, known是上层已经检查过的位
+static int build(const int *idx, int n, uint32_t known, uint32_t level) {
+    if (n == 0)
+        return -1;
+    depth = MAX(depth, level);
+    if (n == 1)
+        return new_node(idx[0], known);
+
+    uint32_t common = ~known;
+    for (int i = 0; i < n; i++)
+        common &= specs[idx[i]].mask;
+    uint32_t varying = 0;
+    for (int i = 1; i < n; i++)
+        varying |= (specs[idx[i]].match ^ specs[idx[0]].match) & common;
+    if (varying == 0)
+        fatalf(
+            "overlapping encodings: %s and %s", specs[idx[0]].name,
+            specs[idx[1]].name
+        );
+
+    // 从最低的取值不同的位开始, 向两边延伸到这组指令都固定的整段位(如funct7),
+    // 取值相同的位也一起分支, 叶子就不用再检查
+    uint32_t shift = __builtin_ctz(varying);
+    uint32_t width = 1;
+    while (shift + width < 32 && (common >> (shift + width) & 1) &&
+           width < MAX_WIDTH)
+        width++;
+    while (shift > 0 && (common >> (shift - 1) & 1) && width < MAX_WIDTH) {
+        shift--;
+        width++;
+    }
+
+    int id = new_node(-1, known);
+    uint32_t field = ((1U << width) - 1) << shift;
+    int *children = calloc(1 << width, sizeof(int));
+    int *sub = calloc(n, sizeof(int));
+    for (uint32_t v = 0; v < (1U << width); v++) {
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            if ((specs[idx[i]].match & field) >> shift == v)
+                sub[m++] = idx[i];
+        }
+        children[v] = build(sub, m, known | field, level + 1);
+    }
+    free(sub);
+    nodes[id].shift = shift;
+    nodes[id].width = width;
+    nodes[id].children = children;
+    return id;
+}
+
+// 两棵子树生成的代码相同时合并case
+static bool same_tree(int a, int b) {
+    if (a < 0 || b < 0)
+        return a == b;
+    node_t *x = &nodes[a], *y = &nodes[b];
+    if (x->spec >= 0 || y->spec >= 0)
+        return x->spec == y->spec &&
+               (specs[x->spec].mask & ~x->known) ==
+                   (specs[y->spec].mask & ~y->known);
+    if (x->shift != y->shift || x->width != y->width)
+        return false;
+    for (uint32_t v = 0; v < (1U << x->width); v++) {
+        if (!same_tree(x->children[v], y->children[v]))
+            return false;
+    }
+    return true;
+}
+
+static void emit(int id, int indent);
+
+static void emit_cases(const int *children, uint32_t n, int indent) {
+    bool *done = calloc(n, sizeof(bool));
+    for (uint32_t v = 0; v < n; v++) {
+        if (done[v] || children[v] < 0)
+            continue;
+        for (uint32_t w = v; w < n; w++) {
+            if (!done[w] && same_tree(children[v], children[w])) {
+                printf("%*scase 0x%x:\n", indent, "", w);
+                done[w] = true;
+            }
+        }
+        emit(children[v], indent + 4);
+    }
+    printf("%*sdefault:\n%*sreturn false;\n", indent, "", indent + 4, "");
+    free(done);
+}
+
+static void emit(int id, int indent) {
+    node_t *node = &nodes[id];
+    if (node->spec >= 0) {
+        const spec_t *s = &specs[node->spec];
+        if (s->mask & ~node->known)
+            printf(
+                "%*sREQUIRE((data & 0x%08x) == 0x%08x);\n", indent, "",
+                s->mask, s->match
+            );
+        printf(
+            "%*sDECODE(%s, %s, %s);\n", indent, "", s->name, s->format,
+            s->flags
+        );
+        return;
+    }
+
+    printf(
+        "%*sswitch ((data >> %u) & 0x%x) {\n", indent, "", node->shift,
+        (1U << node->width) - 1
+    );
+    emit_cases(node->children, 1U << node->width, indent);
+    printf("%*s}\n", indent, "");
+}
+
+int main(void) {
+    int n = ARRAY_SIZE(specs);
+    for (int i = 0; i < n; i++) {
+        if (specs[i].match & ~specs[i].mask)
+            fatalf("%s: match has bits outside mask", specs[i].name);
+    }
+
+    // 第一层的下标是opcode << 3 | funct3;
+    // 不看funct3的指令(lui、jal等)在8个分支里都出现, 输出时合并
+    int root[256];
+    int *idx = calloc(n, sizeof(int));
+    for (uint32_t key = 0; key < ARRAY_SIZE(root); key++) {
+        uint32_t data = 0x3 | (key >> 3) << 2 | (key & 0x7) << 12;
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            uint32_t mask = specs[i].mask & ROOT_BITS;
+            if ((data & mask) == (specs[i].match & mask))
+                idx[m++] = i;
+        }
+        root[key] = build(idx, m, ROOT_BITS, 1);
+    }
+    free(idx);
+
+    printf("// 由decodegen从src/isa.h生成, 不要手动修改\n");
+    printf("// %d条指令, %d个节点, 最多%u层switch\n\n", n, nnodes, depth);
+    printf("static bool decode_rv32(inst_t *inst, uint32_t data) {\n");
+    printf("    switch ((data >> 2 & 0x1f) << 3 | (data >> 12 & 0x7)) {\n");
+    emit_cases(root, ARRAY_SIZE(root), 4);
+    printf("    }\n}\n");
+    return 0;
+}
@@ -20,7 +20,19 @@
 #define PF_R 0x4
 
 
+#define SHT_SYMTAB 2
+#define SHT_RELA 4
+#define SHT_NOBITS 8
+
+#define SHF_ALLOC 0x2
+
+#define SHN_UNDEF 0
+
+#define R_X86_64_64 1
 #define R_X86_64_PC32 2
+#define R_X86_64_PLT32 4
+#define R_X86_64_32 10
+#define R_X86_64_32S 11
 
 typedef struct {
     uint8_t e_ident[EI_NIDENT];
@@ -53,7 +65,7 @@ typedef struct {
 typedef struct {
     uint32_t sh_name;
     uint32_t sh_type;
-    uint32_t sh_flags;
+    uint64_t sh_flags;
     uint64_t sh_addr;
     uint64_t sh_offset;
     uint64_t sh_size;
@@ -4,20 +4,25 @@
 #include <stdint.h>
 #include <stdio.h>
 
-static void func_empty(state_t *state, inst_t *inst) {}
+// 单个hart按程序顺序执行, 多个hart之间要用宿主的屏障保证顺序
+static void func_fence(state_t *state, inst_t *inst) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// fence.i结束block, 由machine_step决定是否丢弃缓存的代码(见smc.c)
+static void func_fence_i(state_t *state, inst_t *inst) {
+    state->exit_reason = fence_i;
+    state->reenter_pc = state->pc + 4;
+}
+static void func_nop(state_t *state, inst_t *inst) {}
 
-#define FUNC(ty)                                                               \
-    uint64_t addr = state->gp_regs[inst->rs1] + (int64_t)inst->imm;            \
-    uint64_t val = *(ty *)TO_HOST(addr);                                       \
+#define LOAD(ty, address)                                                      \
+    uint64_t addr = (address);                                                 \
+    uint64_t val = *(ty *)TO_HOST(state->mem, addr);                           \
     state->gp_regs[inst->rd] = val;                                            \
-    if (inst->rd == 1 && val == 0) {                                           \
-        fprintf(                                                               \
-            stderr,                                                            \
-            "DEBUG: ra loaded with 0 from addr %lx (pc=%lx)\n",                \
-            addr,                                                              \
-            state->pc                                                          \
-        );                                                                     \
-    }
+    TRACE_PROBE(trace_load, state->pc, inst->rd, addr, val);
+
+#define FUNC(ty) LOAD(ty, state->gp_regs[inst->rs1] + (int64_t)inst->imm)
 
 /*
  *  lb: load byte, 从内存地址(rs1+imm)加载8位有符号数到rd，符号扩展到XLEN
@@ -49,20 +54,43 @@ static void func_lhu(state_t *state, inst_t *inst) { FUNC(uint16_t); }
 // 加载32位无符号数到rd，零扩展到64位
 static void func_lwu(state_t *state, inst_t *inst) { FUNC(uint32_t); }
 
+// 操作数特化(见SPECIAL_LIST): 偏移为0, 或基址为x0
+#define X(name, ty)                                                            \
+    static void func_##name##_0(state_t *state, inst_t *inst) {                \
+        LOAD(ty, state->gp_regs[inst->rs1]);                                   \
+    }                                                                          \
+    static void func_##name##_abs(state_t *state, inst_t *inst) {              \
+        LOAD(ty, (int64_t)inst->imm);                                          \
+    }
+X(lb, int8_t)
+X(lh, int16_t)
+X(lw, int32_t)
+X(ld, int64_t)
+X(lbu, uint8_t)
+X(lhu, uint16_t)
+X(lwu, uint32_t)
+#undef X
+
 #undef FUNC
+#undef LOAD
 
-#define FUNC(expr)                                                             \
-    uint64_t rs1 = state->gp_regs[inst->rs1];                                  \
-    int64_t imm = (int64_t)inst->imm;                                          \
+#define ALUI(src, i, expr)                                                     \
+    uint64_t rs1 = (src);                                                      \
+    int64_t imm = (i);                                                         \
     uint64_t res = (expr);                                                     \
     state->gp_regs[inst->rd] = res;                                            \
-    if (inst->rd == 1 && res == 0) {                                           \
-        fprintf(stderr, "DEBUG: ra set to 0 by ALU at pc=%lx\n", state->pc);   \
-    }
+    TRACE_PROBE(trace_alu, state->pc, inst->rd, res, 0);
+
+#define FUNC(expr) ALUI(state->gp_regs[inst->rs1], (int64_t)inst->imm, expr)
 
 // 将寄存器 rs1 的值与立即数 imm 相加，结果写入 rd。
 static void func_addi(state_t *state, inst_t *inst) { FUNC(rs1 + imm); }
 
+// 操作数特化(见SPECIAL_LIST): addi rd, rs, 0
+static void func_mv(state_t *state, inst_t *inst) {
+    ALUI(state->gp_regs[inst->rs1], 0, rs1 + imm);
+}
+
 // 将 rs1 的值左移 imm 位（逻辑左移），结果写入 rd。
 static void func_slli(state_t *state, inst_t *inst) {
     // rs1在RV64中只有64位, 因此imm只取最低6位,就能表示0-63
@@ -128,6 +156,7 @@ static void func_sraiw(state_t *state, inst_t *inst) {
 }
 
 #undef FUNC
+#undef ALUI
 
 // 将当前 PC（程序计数器）与立即数相加，结果写入 rd 寄存器。
 static void func_auipc(state_t *state, inst_t *inst) {
@@ -139,16 +168,7 @@ static void func_auipc(state_t *state, inst_t *inst) {
     uint64_t rs1 = state->gp_regs[inst->rs1];                                  \
     uint64_t rs2 = state->gp_regs[inst->rs2];                                  \
     uint64_t addr = rs1 + inst->imm;                                           \
-    *(typ *)TO_HOST(addr) = (typ)rs2;                                          \
-    if (addr == 0x201bc30) {                                                   \
-        fprintf(                                                               \
-            stderr,                                                            \
-            "DEBUG: store to %lx val=%lx at pc=%lx\n",                         \
-            addr,                                                              \
-            rs2,                                                               \
-            state->pc                                                          \
-        );                                                                     \
-    }
+    *(typ *)TO_HOST(state->mem, addr) = (typ)rs2;
 
 // 将 rs2 寄存器的最低 8 位（1 字节）存储到内存地址 rs1 + imm 处。
 static void func_sb(state_t *state, inst_t *inst) { FUNC(uint8_t); }
@@ -164,10 +184,97 @@ static void func_sd(state_t *state, inst_t *inst) { FUNC(uint64_t); }
 
 #undef FUNC
 
+/*
+ * A扩展: 直接用宿主的原子操作, aq/rl一律按顺序一致处理。
+ * .w的结果符号扩展到64位。这些指令有副作用, block优化不会因为rd是x0
+ * 就删掉它们(见opt.c), 处理函数自己跳过对x0的写回。
+ */
+#define RD_WRITE(val)                                                          \
+    if (inst->rd != zero)                                                      \
+        state->gp_regs[inst->rd] = (val);
+
+// min/max没有对应的宿主原子操作, 用比较交换循环
+#define X(name, ty, pick)                                                      \
+    static inline ty name(ty *p, ty val) {                                     \
+        ty old = __atomic_load_n(p, __ATOMIC_RELAXED);                         \
+        while (!__atomic_compare_exchange_n(                                   \
+            p, &old, (pick), true, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED          \
+        ))                                                                     \
+            ;                                                                  \
+        return old;                                                            \
+    }
+X(atomic_min_w, int32_t, MIN(old, val))
+X(atomic_max_w, int32_t, MAX(old, val))
+X(atomic_minu_w, uint32_t, MIN(old, val))
+X(atomic_maxu_w, uint32_t, MAX(old, val))
+X(atomic_min_d, int64_t, MIN(old, val))
+X(atomic_max_d, int64_t, MAX(old, val))
+X(atomic_minu_d, uint64_t, MIN(old, val))
+X(atomic_maxu_d, uint64_t, MAX(old, val))
+#undef X
+
+// rd = mem[rs1]; mem[rs1] = op(mem[rs1], rs2), st是写回rd时扩展用的有符号类型
+#define AMO(name, ty, st, expr)                                                \
+    static void func_##name(state_t *state, inst_t *inst) {                    \
+        ty *p = (ty *)TO_HOST(state->mem, state->gp_regs[inst->rs1]);          \
+        ty val = (ty)state->gp_regs[inst->rs2];                                \
+        ty old = (expr);                                                       \
+        RD_WRITE((int64_t)(st)old);                                            \
+    }
+#define X(w, ty, st)                                                           \
+    AMO(amoswap_##w, ty, st, __atomic_exchange_n(p, val, __ATOMIC_SEQ_CST))    \
+    AMO(amoadd_##w, ty, st, __atomic_fetch_add(p, val, __ATOMIC_SEQ_CST))      \
+    AMO(amoxor_##w, ty, st, __atomic_fetch_xor(p, val, __ATOMIC_SEQ_CST))      \
+    AMO(amoand_##w, ty, st, __atomic_fetch_and(p, val, __ATOMIC_SEQ_CST))      \
+    AMO(amoor_##w, ty, st, __atomic_fetch_or(p, val, __ATOMIC_SEQ_CST))        \
+    AMO(amomin_##w, ty, st, atomic_min_##w((st *)p, val))                      \
+    AMO(amomax_##w, ty, st, atomic_max_##w((st *)p, val))                      \
+    AMO(amominu_##w, ty, st, atomic_minu_##w(p, val))                          \
+    AMO(amomaxu_##w, ty, st, atomic_maxu_##w(p, val))
+X(w, uint32_t, int32_t)
+X(d, uint64_t, int64_t)
+#undef X
+#undef AMO
+
+/*
+ * lr记下地址和读到的值, sc在地址相同、内存仍是这个值时用比较交换写入。
+ * 真正的保留在其它hart写这个地址时就失效, 这里只看值: 中间被改掉又改回来
+ * (ABA)时sc仍会成功。guest用lr/sc实现的锁和原子读改写只关心值有没有变,
+ * 结果与硬件一致。sc无论成败都清除保留。
+ */
+#define X(w, ty, st)                                                           \
+    static void func_lr_##w(state_t *state, inst_t *inst) {                    \
+        uint64_t addr = state->gp_regs[inst->rs1];                             \
+        ty *p = (ty *)TO_HOST(state->mem, addr);                               \
+        ty val = __atomic_load_n(p, __ATOMIC_SEQ_CST);                         \
+        state->reserved = true;                                                \
+        state->reserve_addr = addr;                                            \
+        state->reserve_val = val;                                              \
+        RD_WRITE((int64_t)(st)val);                                            \
+    }                                                                          \
+    static void func_sc_##w(state_t *state, inst_t *inst) {                    \
+        uint64_t addr = state->gp_regs[inst->rs1];                             \
+        ty expected = (ty)state->reserve_val;                                  \
+        bool ok = state->reserved && state->reserve_addr == addr &&            \
+                  __atomic_compare_exchange_n(                                 \
+                      (ty *)TO_HOST(state->mem, addr), &expected,              \
+                      (ty)state->gp_regs[inst->rs2], false, __ATOMIC_SEQ_CST,  \
+                      __ATOMIC_SEQ_CST                                         \
+                  );                                                           \
+        state->reserved = false;                                               \
+        RD_WRITE(!ok);                                                         \
+    }
+X(w, uint32_t, int32_t)
+X(d, uint64_t, int64_t)
+#undef X
+#undef RD_WRITE
+
 #define FUNC(expr)                                                             \
     uint64_t rs1 = state->gp_regs[inst->rs1];                                  \
     uint64_t rs2 = state->gp_regs[inst->rs2];                                  \
-    state->gp_regs[inst->rd] = (expr);
+    uint64_t res = (expr);                                                     \
+    state->gp_regs[inst->rd] = res;                                            \
+    TRACE_PROBE(trace_alu, state->pc, inst->rd, res, 0);
 
 // 将 rs1 和 rs2 相加，结果写入 rd。
 static void func_add(state_t *state, inst_t *inst) { FUNC(rs1 + rs2); }
@@ -354,16 +461,19 @@ static void func_lui(state_t *state, inst_t *inst) {
     state->gp_regs[inst->rd] = (int64_t)inst->imm;
 }
 
-#define FUNC(expr)                                                             \
-    uint64_t rs1 = state->gp_regs[inst->rs1];                                  \
-    uint64_t rs2 = state->gp_regs[inst->rs2];                                  \
+#define BRANCH(a, b, expr)                                                     \
+    uint64_t rs1 = (a);                                                        \
+    uint64_t rs2 = (b);                                                        \
     uint64_t target_addr = state->pc + (int64_t)inst->imm;                     \
     if (expr) {                                                                \
         state->reenter_pc = state->pc = target_addr;                           \
         state->exit_reason = direct_branch;                                    \
-        inst->continue_exec = true;                                            \
     }
 
+#define RS1 state->gp_regs[inst->rs1]
+#define RS2 state->gp_regs[inst->rs2]
+#define FUNC(expr) BRANCH(RS1, RS2, expr)
+
 // 如果 rs1 等于 rs2，则跳转到目标地址（ pc + imm ）。
 // 用于条件跳转，判断两个寄存器是否相等。
 static void func_beq(state_t *state, inst_t *inst) {
@@ -400,39 +510,61 @@ static void func_bgeu(state_t *state, inst_t *inst) {
     FUNC((uint64_t)rs1 >= (uint64_t)rs2);
 }
 
+// 操作数特化(见SPECIAL_LIST): x0一边直接取0
+#define X(name, a, b, expr)                                                    \
+    static void func_##name(state_t *state, inst_t *inst) {                    \
+        BRANCH(a, b, expr);                                                    \
+    }
+X(beqz, RS1, 0, rs1 == rs2)
+X(bnez, RS1, 0, rs1 != rs2)
+X(bltz, RS1, 0, (int64_t)rs1 < (int64_t)rs2)
+X(bgez, RS1, 0, (int64_t)rs1 >= (int64_t)rs2)
+X(bgtz, 0, RS2, (int64_t)rs1 < (int64_t)rs2)
+X(blez, 0, RS2, (int64_t)rs1 >= (int64_t)rs2)
+#undef X
+
 #undef FUNC
+#undef RS1
+#undef RS2
+#undef BRANCH
 
 // 将下一条指令的地址（，取决于是否压缩指令）写入 rd寄存器（用于返回）。
 // 跳转到 rs1 + imm的地址，并将最低位清零（保证跳转地址是偶数）。
 // 用于实现函数调用、间接跳转等。
 static void func_jalr(state_t *state, inst_t *inst) {
     uint64_t rs1 = state->gp_regs[inst->rs1];
-    state->gp_regs[inst->rd] = state->pc + (inst->rvc ? 2 : 4);
+    state->gp_regs[inst->rd] = state->pc + inst->size;
     state->exit_reason = indirect_branch;
     state->reenter_pc = (rs1 + (int64_t)inst->imm) & ~(uint64_t)1;
-    if (state->reenter_pc == 0) {
-        uint8_t *p = (uint8_t *)TO_HOST(state->pc);
-        fprintf(
-            stderr,
-            "DEBUG: jalr to 0 at pc=%lx. rs1_reg=%d rs1_val=%lx, imm=%d, "
-            "sp=%lx\n",
-            state->pc,
-            inst->rs1,
-            rs1,
-            (int32_t)inst->imm,
-            state->gp_regs[2]
-        );
-        fprintf(
-            stderr, "Inst bytes: %02x %02x %02x %02x\n", p[0], p[1], p[2], p[3]
-        );
-    }
+    TRACE_PROBE(trace_jump, state->pc, inst->rs1, rs1, state->reenter_pc);
+}
+
+// rd为x0的jal/jalr由opt.c改写成j/jr, 不写rd, x0因此始终为0
+static void func_j(state_t *state, inst_t *inst) {
+    state->reenter_pc = state->pc = state->pc + (int64_t)inst->imm;
+    state->exit_reason = direct_branch;
 }
 
+#define FUNC(reg, off)                                                         \
+    uint64_t rs1 = state->gp_regs[reg];                                        \
+    state->exit_reason = indirect_branch;                                      \
+    state->reenter_pc = (rs1 + (off)) & ~(uint64_t)1;                          \
+    TRACE_PROBE(trace_jump, state->pc, reg, rs1, state->reenter_pc);
+
+static void func_jr(state_t *state, inst_t *inst) {
+    FUNC(inst->rs1, (int64_t)inst->imm);
+}
+
+// 操作数特化(见SPECIAL_LIST): jalr x0, 0(ra)
+static void func_ret(state_t *state, inst_t *inst) { FUNC(ra, 0); }
+
+#undef FUNC
+
 // 将下一条指令的地址（ pc + 4 或 pc + 2 ）写入 rd 寄存器（用于返回）。
 // 跳转到 pc + imm 的目标地址。
 // 用于实现直接跳转和函数调用。
 static void func_jal(state_t *state, inst_t *inst) {
-    state->gp_regs[inst->rd] = state->pc + (inst->rvc ? 2 : 4);
+    state->gp_regs[inst->rd] = state->pc + inst->size;
     state->reenter_pc = state->pc = state->pc + (int64_t)inst->imm;
     state->exit_reason = direct_branch;
 }
@@ -490,19 +622,19 @@ static void func_flw(state_t *state, inst_t *inst) {
 
     // ((uint64_t)-1 << 32): 这是一个 64 位数，高 32 位全为 1，低 32 位为 0。
     state->fp_regs[inst->rd].v =
-        *(uint32_t *)TO_HOST(addr) | ((uint64_t)-1 << 32);
+        *(uint32_t *)TO_HOST(state->mem, addr) | ((uint64_t)-1 << 32);
 }
 
 // 从内存地址 rs1 + imm 处读取 64 位（双精度 double）数据，写入浮点寄存器rd
 static void func_fld(state_t *state, inst_t *inst) {
     uint64_t addr = state->gp_regs[inst->rs1] + (int64_t)inst->imm;
-    state->fp_regs[inst->rd].v = *(uint64_t *)TO_HOST(addr);
+    state->fp_regs[inst->rd].v = *(uint64_t *)TO_HOST(state->mem, addr);
 }
 
 #define FUNC(typ)                                                              \
     uint64_t rs1 = state->gp_regs[inst->rs1];                                  \
     uint64_t rs2 = state->fp_regs[inst->rs2].v;                                \
-    *(typ *)TO_HOST(rs1 + inst->imm) = (typ)rs2;
+    *(typ *)TO_HOST(state->mem, rs1 + inst->imm) = (typ)rs2;
 
 // 将浮点寄存器 rs2 的 32 位（单精度 float）数据，存储到内存地址 rs1 + imm 处。
 static void func_fsw(state_t *state, inst_t *inst) { FUNC(uint32_t); }
@@ -820,317 +952,55 @@ static void func_fcvt_d_s(state_t *state, inst_t *inst) {
     state->fp_regs[inst->rd].d = (f64)state->fp_regs[inst->rs1].f;
 }
 
-typedef void(func_t)(state_t *, inst_t *);
-
-static func_t *funcs[] = {
-    func_lb,       func_lh,        func_lw,        func_ld,
-    func_lbu,      func_lhu,       func_lwu,
-    func_empty, // fence
-    func_empty, // fence_i
-    func_addi,     func_slli,      func_slti,      func_sltiu,
-    func_xori,     func_srli,      func_srai,      func_ori,
-    func_andi,     func_auipc,     func_addiw,     func_slliw,
-    func_srliw,    func_sraiw,     func_sb,        func_sh,
-    func_sw,       func_sd,        func_add,       func_sll,
-    func_slt,      func_sltu,      func_xor,       func_srl,
-    func_or,       func_and,       func_mul,       func_mulh,
-    func_mulhsu,   func_mulhu,     func_div,       func_divu,
-    func_rem,      func_remu,      func_sub,       func_sra,
-    func_lui,      func_addw,      func_sllw,      func_srlw,
-    func_mulw,     func_divw,      func_divuw,     func_remw,
-    func_remuw,    func_subw,      func_sraw,      func_beq,
-    func_bne,      func_blt,       func_bge,       func_bltu,
-    func_bgeu,     func_jalr,      func_jal,       func_ecall,
-    func_csrrw,    func_csrrs,     func_csrrc,     func_csrrwi,
-    func_csrrsi,   func_csrrci,    func_flw,       func_fsw,
-    func_fmadd_s,  func_fmsub_s,   func_fnmsub_s,  func_fnmadd_s,
-    func_fadd_s,   func_fsub_s,    func_fmul_s,    func_fdiv_s,
-    func_fsqrt_s,  func_fsgnj_s,   func_fsgnjn_s,  func_fsgnjx_s,
-    func_fmin_s,   func_fmax_s,    func_fcvt_w_s,  func_fcvt_wu_s,
-    func_fmv_x_w,  func_feq_s,     func_flt_s,     func_fle_s,
-    func_fclass_s, func_fcvt_s_w,  func_fcvt_s_wu, func_fmv_w_x,
-    func_fcvt_l_s, func_fcvt_lu_s, func_fcvt_s_l,  func_fcvt_s_lu,
-    func_fld,      func_fsd,       func_fmadd_d,   func_fmsub_d,
-    func_fnmsub_d, func_fnmadd_d,  func_fadd_d,    func_fsub_d,
-    func_fmul_d,   func_fdiv_d,    func_fsqrt_d,   func_fsgnj_d,
-    func_fsgnjn_d, func_fsgnjx_d,  func_fmin_d,    func_fmax_d,
-    func_fcvt_s_d, func_fcvt_d_s,  func_feq_d,     func_flt_d,
-    func_fle_d,    func_fclass_d,  func_fcvt_w_d,  func_fcvt_wu_d,
-    func_fcvt_d_w, func_fcvt_d_wu, func_fcvt_l_d,  func_fcvt_lu_d,
-    func_fmv_x_d,  func_fcvt_d_l,  func_fcvt_d_lu, func_fmv_d_x,
-};
+/*
+ * 融合指令, 由opt.c把相邻的两条指令合并而成, 语义等于依次执行这两条。
+ * 两条的立即数分别在imm1/imm2, 跳转偏移相对于第一条指令的pc。
+ */
+static void func_slli_srli(state_t *state, inst_t *inst) {
+    uint64_t rs1 = state->gp_regs[inst->rs1] << (inst->imm1 & 0x3f);
+    state->gp_regs[inst->rd] = rs1 >> (inst->imm2 & 0x3f);
+}
 
-const char *inst_type_name(enum inst_type_t type) {
-    switch (type) {
-    case inst_lb:
-        return "lb";
-    case inst_lh:
-        return "lh";
-    case inst_lw:
-        return "lw";
-    case inst_ld:
-        return "ld";
-    case inst_lbu:
-        return "lbu";
-    case inst_lhu:
-        return "lhu";
-    case inst_lwu:
-        return "lwu";
-    case inst_fence:
-        return "fence";
-    case inst_fence_i:
-        return "fence_i";
-    case inst_addi:
-        return "addi";
-    case inst_slli:
-        return "slli";
-    case inst_slti:
-        return "slti";
-    case inst_sltiu:
-        return "sltiu";
-    case inst_xori:
-        return "xori";
-    case inst_srli:
-        return "srli";
-    case inst_srai:
-        return "srai";
-    case inst_ori:
-        return "ori";
-    case inst_andi:
-        return "andi";
-    case inst_auipc:
-        return "auipc";
-    case inst_addiw:
-        return "addiw";
-    case inst_slliw:
-        return "slliw";
-    case inst_srliw:
-        return "srliw";
-    case inst_sraiw:
-        return "sraiw";
-    case inst_sb:
-        return "sb";
-    case inst_sh:
-        return "sh";
-    case inst_sw:
-        return "sw";
-    case inst_sd:
-        return "sd";
-    case inst_add:
-        return "add";
-    case inst_sll:
-        return "sll";
-    case inst_slt:
-        return "slt";
-    case inst_sltu:
-        return "sltu";
-    case inst_xor:
-        return "xor";
-    case inst_srl:
-        return "srl";
-    case inst_or:
-        return "or";
-    case inst_and:
-        return "and";
-    case inst_mul:
-        return "mul";
-    case inst_mulh:
-        return "mulh";
-    case inst_mulhsu:
-        return "mulhsu";
-    case inst_mulhu:
-        return "mulhu";
-    case inst_div:
-        return "div";
-    case inst_divu:
-        return "divu";
-    case inst_rem:
-        return "rem";
-    case inst_remu:
-        return "remu";
-    case inst_sub:
-        return "sub";
-    case inst_sra:
-        return "sra";
-    case inst_lui:
-        return "lui";
-    case inst_addw:
-        return "addw";
-    case inst_sllw:
-        return "sllw";
-    case inst_srlw:
-        return "srlw";
-    case inst_mulw:
-        return "mulw";
-    case inst_divw:
-        return "divw";
-    case inst_divuw:
-        return "divuw";
-    case inst_remw:
-        return "remw";
-    case inst_remuw:
-        return "remuw";
-    case inst_subw:
-        return "subw";
-    case inst_sraw:
-        return "sraw";
-    case inst_beq:
-        return "beq";
-    case inst_bne:
-        return "bne";
-    case inst_blt:
-        return "blt";
-    case inst_bge:
-        return "bge";
-    case inst_bltu:
-        return "bltu";
-    case inst_bgeu:
-        return "bgeu";
-    case inst_jalr:
-        return "jalr";
-    case inst_jal:
-        return "jal";
-    case inst_ecall:
-        return "ecall";
-    case inst_csrrc:
-        return "csrrc";
-    case inst_csrrci:
-        return "csrrci";
-    case inst_csrrs:
-        return "csrrs";
-    case inst_csrrsi:
-        return "csrrsi";
-    case inst_csrrw:
-        return "csrrw";
-    case inst_csrrwi:
-        return "csrrwi";
-    case inst_flw:
-        return "flw";
-    case inst_fsw:
-        return "fsw";
-    case inst_fmadd_s:
-        return "fmadd_s";
-    case inst_fmsub_s:
-        return "fmsub_s";
-    case inst_fnmsub_s:
-        return "fnmsub_s";
-    case inst_fnmadd_s:
-        return "fnmadd_s";
-    case inst_fadd_s:
-        return "fadd_s";
-    case inst_fsub_s:
-        return "fsub_s";
-    case inst_fmul_s:
-        return "fmul_s";
-    case inst_fdiv_s:
-        return "fdiv_s";
-    case inst_fsqrt_s:
-        return "fsqrt_s";
-    case inst_fsgnj_s:
-        return "fsgnj_s";
-    case inst_fsgnjn_s:
-        return "fsgnjn_s";
-    case inst_fsgnjx_s:
-        return "fsgnjx_s";
-    case inst_fmin_s:
-        return "fmin_s";
-    case inst_fmax_s:
-        return "fmax_s";
-    case inst_fcvt_w_s:
-        return "fcvt_w_s";
-    case inst_fcvt_wu_s:
-        return "fcvt_wu_s";
-    case inst_fmv_x_w:
-        return "fmv_x_w";
-    case inst_feq_s:
-        return "feq_s";
-    case inst_flt_s:
-        return "flt_s";
-    case inst_fle_s:
-        return "fle_s";
-    case inst_fclass_s:
-        return "fclass_s";
-    case inst_fcvt_s_w:
-        return "fcvt_s_w";
-    case inst_fcvt_s_wu:
-        return "fcvt_s_wu";
-    case inst_fmv_w_x:
-        return "fmv_w_x";
-    case inst_fcvt_l_s:
-        return "fcvt_l_s";
-    case inst_fcvt_lu_s:
-        return "fcvt_lu_s";
-    case inst_fcvt_s_l:
-        return "fcvt_s_l";
-    case inst_fcvt_s_lu:
-        return "fcvt_s_lu";
-    case inst_fld:
-        return "fld";
-    case inst_fsd:
-        return "fsd";
-    case inst_fmadd_d:
-        return "fmadd_d";
-    case inst_fmsub_d:
-        return "fmsub_d";
-    case inst_fnmsub_d:
-        return "fnmsub_d";
-    case inst_fnmadd_d:
-        return "fnmadd_d";
-    case inst_fadd_d:
-        return "fadd_d";
-    case inst_fsub_d:
-        return "fsub_d";
-    case inst_fmul_d:
-        return "fmul_d";
-    case inst_fdiv_d:
-        return "fdiv_d";
-    case inst_fsqrt_d:
-        return "fsqrt_d";
-    case inst_fsgnj_d:
-        return "fsgnj_d";
-    case inst_fsgnjn_d:
-        return "fsgnjn_d";
-    case inst_fsgnjx_d:
-        return "fsgnjx_d";
-    case inst_fmin_d:
-        return "fmin_d";
-    case inst_fmax_d:
-        return "fmax_d";
-    case inst_fcvt_s_d:
-        return "fcvt_s_d";
-    case inst_fcvt_d_s:
-        return "fcvt_d_s";
-    case inst_feq_d:
-        return "feq_d";
-    case inst_flt_d:
-        return "flt_d";
-    case inst_fle_d:
-        return "fle_d";
-    case inst_fclass_d:
-        return "fclass_d";
-    case inst_fcvt_w_d:
-        return "fcvt_w_d";
-    case inst_fcvt_wu_d:
-        return "fcvt_wu_d";
-    case inst_fcvt_d_w:
-        return "fcvt_d_w";
-    case inst_fcvt_d_wu:
-        return "fcvt_d_wu";
-    case inst_fcvt_l_d:
-        return "fcvt_l_d";
-    case inst_fcvt_lu_d:
-        return "fcvt_lu_d";
-    case inst_fmv_x_d:
-        return "fmv_x_d";
-    case inst_fcvt_d_l:
-        return "fcvt_d_l";
-    case inst_fcvt_d_lu:
-        return "fcvt_d_lu";
-    case inst_fmv_d_x:
-        return "fmv_d_x";
-    default:
-        return "unknown";
+static void func_slli_add(state_t *state, inst_t *inst) {
+    uint64_t rs1 = state->gp_regs[inst->rs1];
+    uint64_t rs2 = state->gp_regs[inst->rs2];
+    state->gp_regs[inst->rd] = rs2 + (rs1 << (inst->imm1 & 0x3f));
+}
+
+// rs2与rd不同, 先写rd再比较
+#define FUNC(expr)                                                             \
+    uint64_t rs1 = state->gp_regs[inst->rs1] + (int64_t)inst->imm1;            \
+    uint64_t rs2 = state->gp_regs[inst->rs2];                                  \
+    state->gp_regs[inst->rd] = rs1;                                            \
+    if (expr) {                                                                \
+        state->reenter_pc = state->pc = state->pc + (int64_t)inst->imm2;       \
+        state->exit_reason = direct_branch;                                    \
     }
+
+static void func_addi_bne(state_t *state, inst_t *inst) { FUNC(rs1 != rs2); }
+
+static void func_addi_blt(state_t *state, inst_t *inst) {
+    FUNC((int64_t)rs1 < (int64_t)rs2);
+}
+
+static void func_addi_bltu(state_t *state, inst_t *inst) { FUNC(rs1 < rs2); }
+
+#undef FUNC
+
+#define X(name, ...) [inst_##name] = func_##name,
+#define S(name, base) X(name)
+func_t *const funcs[num_insns] = { INST_LIST(X) SPECIAL_LIST(S) };
+#undef S
+#undef X
+
+#define X(name, ...) [inst_##name] = #name,
+#define S(name, base) X(name)
+static const char *const names[num_insns] = { INST_LIST(X) SPECIAL_LIST(S) };
+#undef S
+#undef X
+
+const char *inst_type_name(enum inst_type_t type) {
+    return (unsigned)type < num_insns ? names[type] : "unknown";
 }
 
 void inst_print(inst_t *inst) {
@@ -1139,26 +1009,215 @@ void inst_print(inst_t *inst) {
     printf("  rd: %d\n", inst->rd);
     printf("  rs1: %d\n", inst->rs1);
     printf("  rs2: %d\n", inst->rs2);
-    printf("  rs3: %d\n", inst->rs3);
     printf("  imm: %d\n", inst->imm);
-    printf("  csr: %d\n", inst->csr);
-    printf("  rvc: %s\n", inst->rvc ? "true" : "false");
+    printf("  size: %d\n", inst->size);
     printf("  continue_exec: %s\n", inst->continue_exec ? "true" : "false");
     printf("}\n");
 }
 
-void exec_block_interp(state_t *state) {
-    static inst_t inst = { 0 };
+block_t *block_build(machine_t *m, uint64_t pc) {
+    inst_t insts[BLOCK_MAX_INSTS];
+    uint32_t len = 0;
+    uint64_t end_pc = pc;
+    while (len < BLOCK_MAX_INSTS) {
+        inst_t *inst = &insts[len++];
+        inst_t *pre = predecode_inst(m, end_pc);
+        if (pre)
+            *inst = *pre;
+        else
+            decode_inst(inst, *(uint32_t *)TO_HOST(m->mmu.mem, end_pc));
+        end_pc += inst->size;
+        if (inst->continue_exec)
+            break; // 分支/跳转/syscall结束当前block
+    }
+
+    uint32_t ninsts = len;
+    len = block_optimize(pc, insts, len);
+
+    // 指令数组紧跟在头部之后, 与头部一起按cache line对齐, 末尾是哨兵项
+    size_t size = sizeof(block_t) + (len + 1) * sizeof(inst_t);
+    block_t *block = aligned_alloc(BLOCK_ALIGN, ROUNDUP(size, BLOCK_ALIGN));
+    if (block == NULL)
+        fatal("cannot allocate a block");
+    memset(block, 0, size);
+    block->pc = pc;
+    block->end_pc = end_pc;
+    block->jit_lo = pc;
+    block->jit_hi = end_pc;
+    block->len = len;
+    block->ninsts = ninsts;
+    memcpy(block->insts, insts, len * sizeof(inst_t));
+    block->insts[len].type = num_insns;
+    return block;
+}
+
+// 末尾是否为函数调用(jal/jalr写ra), 或函数返回(ret, 即jalr x0, 0(ra))
+static inline bool block_is_call(inst_t *last) {
+    return (last->type == inst_jal || last->type == inst_jalr) &&
+           last->rd == ra;
+}
+
+static inline bool block_is_ret(inst_t *last) {
+    return inst_generic(last->type) == inst_jr && last->rs1 == ra;
+}
+
+static block_t **ibtc_slot(block_t *block, uint64_t target) {
+    for (int i = 0; i < BLOCK_IBTC_SIZE; i++) {
+        if (__atomic_load_n(&block->ibtc[i].pc, __ATOMIC_RELAXED) == target)
+            return &block->ibtc[i].block;
+    }
+
+    // 未命中: 轮换替换一项, 由machine_step查表后填入block
+    uint32_t next = __atomic_load_n(&block->ibtc_next, __ATOMIC_RELAXED);
+    __atomic_store_n(
+        &block->ibtc_next, (next + 1) % BLOCK_IBTC_SIZE, __ATOMIC_RELAXED
+    );
+    ibtc_entry_t *entry = &block->ibtc[next];
+    __atomic_store_n(&entry->block, NULL, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->pc, target, __ATOMIC_RELAXED);
+    return &entry->block;
+}
+
+/*
+ * 根据block的出口(state->exit_reason/reenter_pc)找到存放后继block指针的槽位,
+ * *slot不为NULL且从reenter_pc开始时就是要执行的下一个block,
+ * 否则由machine_step查表后填入。槽位由所有hart共享, 没有加锁, 一律原子读写
+ * (写release, 读acquire); 两个hart同时替换同一个ibtc项时,
+ * 项里的pc和block可能来自不同的跳转目标, 所以使用前要核对block的pc。
+ * ecall返回NULL。每次离开block只能调用一次, 调用和返回会修改返回地址栈。
+ *
+ * - 直接跳转: 链接到block->succ[]
+ * - ret: 弹出返回地址栈, 命中时复用调用者block的succ[1](即返回点)
+ * - 其它jalr: 查该block的目标缓存ibtc
+ */
+block_t **block_exit_slot(state_t *state, block_t *block) {
+    uint64_t target = state->reenter_pc;
+    inst_t *last = &block->insts[block->len - 1];
+
+    switch (state->exit_reason) {
+    case direct_branch: {
+        if (block_is_call(last))
+            state->ras[state->ras_top++ % RAS_SIZE] = block;
+        if (target == block->end_pc)
+            return &block->succ[1];
+
+        block_count(&block->taken);
+        block_t **slot = &block->succ[0];
+        block_t *next = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (target <= block->pc && next)
+            __atomic_store_n(&next->loop_header, true, __ATOMIC_RELAXED);
+        return slot;
+    }
+    case indirect_branch:
+        if (block_is_call(last)) {
+            state->ras[state->ras_top++ % RAS_SIZE] = block;
+        } else if (block_is_ret(last)) {
+            // 失效的block不在哈希表里, 它的succ[1]不会被smc.c清理
+            block_t *caller = state->ras[--state->ras_top % RAS_SIZE];
+            if (caller && !__atomic_load_n(&caller->stale, __ATOMIC_RELAXED) &&
+                caller->end_pc == target)
+                return &caller->succ[1];
+        }
+        return ibtc_slot(block, target);
+    default:
+        return NULL;
+    }
+}
+
+/*
+ * 离开block时, 后继已知就在解释器内接着执行, 不必回到machine_step查哈希表。
+ * 后继未知、已编译或刚达到编译阈值时返回false, 后继槽位留在*slot交给machine_step。
+ * guest进程正在退出时也返回false, 由machine_step停下, 见machine_stop。
+ */
+static inline bool block_chain(state_t *state, block_t **block, block_t ***slot) {
+    *slot = block_exit_slot(state, *block);
+    block_t *next = *slot ? __atomic_load_n(*slot, __ATOMIC_ACQUIRE) : NULL;
+    if (next == NULL || __atomic_load_n(state->exiting, __ATOMIC_RELAXED) ||
+        next->pc != state->reenter_pc ||
+        __atomic_load_n(&next->jit, __ATOMIC_ACQUIRE) ||
+        block_count(&next->hot) >=
+            __atomic_load_n(&next->next_tier, __ATOMIC_RELAXED))
+        return false;
+
+    state->pc = state->reenter_pc;
+    state->exit_reason = none;
+    *block = next;
+    return true;
+}
+
+#ifdef THREADED_INTERP
+
+/*
+ * 直接线索化(direct-threaded)分发:
+ * 每条指令的处理代码是本函数内的一个标签, 按指令的type查labels[]得到标签地址,
+ * 每段处理代码执行完直接 goto 下一条指令的标签,
+ * 没有公共的间接调用点, 宿主机的分支预测器可以按处理代码分别学习跳转模式。
+ * block末尾的哨兵项对应出口, 因此也不再需要逐条检查continue_exec。
+ */
+block_t **exec_block_interp(state_t *state, block_t *block) {
+#define X(name, ...) [inst_##name] = &&L_##name,
+#define S(name, base) X(name)
+    static const void *const labels[num_insns + 1] = {
+        INST_LIST(X) SPECIAL_LIST(S)
+        [num_insns] = &&L_exit, // 哨兵项
+    };
+#undef X
+
+    inst_t *inst;
+    block_t **slot;
+L_enter:
+    state->icount += block->ninsts;
+    inst = block->insts;
+    goto *labels[inst->type];
+
+#define X(name, ...)                                                           \
+    L_##name : func_##name(state, inst);                                       \
+    state->pc += inst->size;                                                   \
+    inst++;                                                                    \
+    goto *labels[inst->type];
+    INST_LIST(X)
+    SPECIAL_LIST(S)
+#undef S
+#undef X
+
+L_exit:
+    // 分支未跳转, 或block因长度上限被截断: 顺序执行下一个block
+    if (state->exit_reason == none) {
+        state->reenter_pc = block->end_pc;
+        state->exit_reason = direct_branch;
+    }
+    if (block_chain(state, &block, &slot))
+        goto L_enter;
+    return slot;
+}
+
+#else
+
+// 返回最后一个block出口对应的后继槽位, 见block_exit_slot
+block_t **exec_block_interp(state_t *state, block_t *block) {
+    block_t **slot;
     while (true) {
-        uint32_t raw_data = *(uint32_t *)TO_HOST(state->pc);
-        decode_inst(&inst, raw_data);
-        // printf("PC: %lx\n", state->pc);
-        // inst_print(&inst);
-        funcs[inst.type](state, &inst);
-        state->gp_regs[zero] = 0;
-
-        if (inst.continue_exec)
-            break; // 处理syscall
-        state->pc += inst.rvc ? 2 : 4;
+        state->icount += block->ninsts;
+        for (uint32_t i = 0; i < block->len; i++) {
+            inst_t *inst = &block->insts[i];
+            // printf("PC: %lx\n", state->pc);
+            // inst_print(inst);
+            funcs[inst->type](state, inst);
+
+            if (inst->continue_exec)
+                break; // 处理跳转或syscall
+            state->pc += inst->size;
+        }
+
+        // 分支未跳转, 或block因长度上限被截断: 顺序执行下一个block
+        if (state->exit_reason == none) {
+            state->reenter_pc = block->end_pc;
+            state->exit_reason = direct_branch;
+        }
+
+        if (!block_chain(state, &block, &slot))
+            return slot;
     }
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef RVEMU_ISA_H
+#define RVEMU_ISA_H
+
+/*
+ * 指令集的编码表, 32位指令的解码只以这张表为准
+ *
+ * 每行X(name, format, rd, rs1, rs2, rs3, flags, mask, match):
+ * - (data & mask) == match 的指令字是这条指令, 各行的编码不能重叠
+ * - format: 从指令字中取操作数的方式, 见enum isa_format_t
+ * - rd/rs1/rs2/rs3: 各字段是通用寄存器(x)、浮点寄存器(f)还是不用(_)
+ * - flags: ISA_END表示这条指令结束block(inst_t的continue_exec)
+ *
+ * 由这张表得到的有: inst_type_t的前半部分、interp.c的funcs[]和名字表、
+ * decode.c的isa_info[](opt.c据此分析读写的寄存器), 以及构建时decodegen
+ * 生成的解码函数(obj/decode_tree.h)。增加一条指令只需在这里加一行,
+ * 再在interp.c里写处理函数func_<name>; 没有模板的指令基线JIT调用处理函数,
+ * codegen.c不认识的指令所在的block留在解释器里, 两者都可以之后再补。
+ * 压缩指令展开成这里的指令, 解码见decode.c的decode_rvc。
+ */
+
+enum isa_format_t {
+    isa_fmt_none, // 不取任何字段
+    isa_fmt_r,    // rd, rs1, rs2
+    isa_fmt_r4,   // rd, rs1, rs2, rs3
+    isa_fmt_i,    // rd, rs1, imm[11:0]
+    isa_fmt_s,    // rs1, rs2, imm[11:0]
+    isa_fmt_b,    // rs1, rs2, imm[12:1]
+    isa_fmt_u,    // rd, imm[31:12]
+    isa_fmt_j,    // rd, imm[20:1]
+    isa_fmt_csr,  // rd, rs1(或zimm), csr
+};
+
+enum isa_operand_t {
+    isa_opnd__, // 不用
+    isa_opnd_x, // 通用寄存器
+    isa_opnd_f, // 浮点寄存器
+};
+
+#define ISA_END (1 << 0)
+
+// clang-format off
+#define ISA_LIST(X)                                                            \
+    /* RV64I: load, fence */                                                   \
+    X(lb,        i,    x, x, _, _, 0,       0x0000707f, 0x00000003)            \
+    X(lh,        i,    x, x, _, _, 0,       0x0000707f, 0x00001003)            \
+    X(lw,        i,    x, x, _, _, 0,       0x0000707f, 0x00002003)            \
+    X(ld,        i,    x, x, _, _, 0,       0x0000707f, 0x00003003)            \
+    X(lbu,       i,    x, x, _, _, 0,       0x0000707f, 0x00004003)            \
+    X(lhu,       i,    x, x, _, _, 0,       0x0000707f, 0x00005003)            \
+    X(lwu,       i,    x, x, _, _, 0,       0x0000707f, 0x00006003)            \
+    X(fence,     none, _, _, _, _, 0,       0x0000707f, 0x0000000f)            \
+    X(fence_i,   none, _, _, _, _, ISA_END, 0x0000707f, 0x0000100f)            \
+    /* 整数立即数运算 */                                                       \
+    X(addi,      i,    x, x, _, _, 0,       0x0000707f, 0x00000013)            \
+    X(slli,      i,    x, x, _, _, 0,       0xfc00707f, 0x00001013)            \
+    X(slti,      i,    x, x, _, _, 0,       0x0000707f, 0x00002013)            \
+    X(sltiu,     i,    x, x, _, _, 0,       0x0000707f, 0x00003013)            \
+    X(xori,      i,    x, x, _, _, 0,       0x0000707f, 0x00004013)            \
+    X(srli,      i,    x, x, _, _, 0,       0xfc00707f, 0x00005013)            \
+    X(srai,      i,    x, x, _, _, 0,       0xfc00707f, 0x40005013)            \
+    X(ori,       i,    x, x, _, _, 0,       0x0000707f, 0x00006013)            \
+    X(andi,      i,    x, x, _, _, 0,       0x0000707f, 0x00007013)            \
+    X(auipc,     u,    x, _, _, _, 0,       0x0000007f, 0x00000017)            \
+    X(addiw,     i,    x, x, _, _, 0,       0x0000707f, 0x0000001b)            \
+    X(slliw,     i,    x, x, _, _, 0,       0xfe00707f, 0x0000101b)            \
+    X(srliw,     i,    x, x, _, _, 0,       0xfe00707f, 0x0000501b)            \
+    X(sraiw,     i,    x, x, _, _, 0,       0xfe00707f, 0x4000501b)            \
+    /* store */                                                                \
+    X(sb,        s,    _, x, x, _, 0,       0x0000707f, 0x00000023)            \
+    X(sh,        s,    _, x, x, _, 0,       0x0000707f, 0x00001023)            \
+    X(sw,        s,    _, x, x, _, 0,       0x0000707f, 0x00002023)            \
+    X(sd,        s,    _, x, x, _, 0,       0x0000707f, 0x00003023)            \
+    /* 整数寄存器运算, 含M扩展 */                                              \
+    X(add,       r,    x, x, x, _, 0,       0xfe00707f, 0x00000033)            \
+    X(sll,       r,    x, x, x, _, 0,       0xfe00707f, 0x00001033)            \
+    X(slt,       r,    x, x, x, _, 0,       0xfe00707f, 0x00002033)            \
+    X(sltu,      r,    x, x, x, _, 0,       0xfe00707f, 0x00003033)            \
+    X(xor,       r,    x, x, x, _, 0,       0xfe00707f, 0x00004033)            \
+    X(srl,       r,    x, x, x, _, 0,       0xfe00707f, 0x00005033)            \
+    X(or,        r,    x, x, x, _, 0,       0xfe00707f, 0x00006033)            \
+    X(and,       r,    x, x, x, _, 0,       0xfe00707f, 0x00007033)            \
+    X(mul,       r,    x, x, x, _, 0,       0xfe00707f, 0x02000033)            \
+    X(mulh,      r,    x, x, x, _, 0,       0xfe00707f, 0x02001033)            \
+    X(mulhsu,    r,    x, x, x, _, 0,       0xfe00707f, 0x02002033)            \
+    X(mulhu,     r,    x, x, x, _, 0,       0xfe00707f, 0x02003033)            \
+    X(div,       r,    x, x, x, _, 0,       0xfe00707f, 0x02004033)            \
+    X(divu,      r,    x, x, x, _, 0,       0xfe00707f, 0x02005033)            \
+    X(rem,       r,    x, x, x, _, 0,       0xfe00707f, 0x02006033)            \
+    X(remu,      r,    x, x, x, _, 0,       0xfe00707f, 0x02007033)            \
+    X(sub,       r,    x, x, x, _, 0,       0xfe00707f, 0x40000033)            \
+    X(sra,       r,    x, x, x, _, 0,       0xfe00707f, 0x40005033)            \
+    X(lui,       u,    x, _, _, _, 0,       0x0000007f, 0x00000037)            \
+    X(addw,      r,    x, x, x, _, 0,       0xfe00707f, 0x0000003b)            \
+    X(sllw,      r,    x, x, x, _, 0,       0xfe00707f, 0x0000103b)            \
+    X(srlw,      r,    x, x, x, _, 0,       0xfe00707f, 0x0000503b)            \
+    X(mulw,      r,    x, x, x, _, 0,       0xfe00707f, 0x0200003b)            \
+    X(divw,      r,    x, x, x, _, 0,       0xfe00707f, 0x0200403b)            \
+    X(divuw,     r,    x, x, x, _, 0,       0xfe00707f, 0x0200503b)            \
+    X(remw,      r,    x, x, x, _, 0,       0xfe00707f, 0x0200603b)            \
+    X(remuw,     r,    x, x, x, _, 0,       0xfe00707f, 0x0200703b)            \
+    X(subw,      r,    x, x, x, _, 0,       0xfe00707f, 0x4000003b)            \
+    X(sraw,      r,    x, x, x, _, 0,       0xfe00707f, 0x4000503b)            \
+    /* 分支和跳转 */                                                           \
+    X(beq,       b,    _, x, x, _, ISA_END, 0x0000707f, 0x00000063)            \
+    X(bne,       b,    _, x, x, _, ISA_END, 0x0000707f, 0x00001063)            \
+    X(blt,       b,    _, x, x, _, ISA_END, 0x0000707f, 0x00004063)            \
+    X(bge,       b,    _, x, x, _, ISA_END, 0x0000707f, 0x00005063)            \
+    X(bltu,      b,    _, x, x, _, ISA_END, 0x0000707f, 0x00006063)            \
+    X(bgeu,      b,    _, x, x, _, ISA_END, 0x0000707f, 0x00007063)            \
+    X(jalr,      i,    x, x, _, _, ISA_END, 0x0000007f, 0x00000067)            \
+    X(jal,       j,    x, _, _, _, ISA_END, 0x0000007f, 0x0000006f)            \
+    /* 系统调用和CSR */                                                        \
+    X(ecall,     none, _, _, _, _, ISA_END, 0xffffffff, 0x00000073)            \
+    X(csrrc,     csr,  x, x, _, _, 0,       0x0000707f, 0x00003073)            \
+    X(csrrci,    csr,  x, _, _, _, 0,       0x0000707f, 0x00007073)            \
+    X(csrrs,     csr,  x, x, _, _, 0,       0x0000707f, 0x00002073)            \
+    X(csrrsi,    csr,  x, _, _, _, 0,       0x0000707f, 0x00006073)            \
+    X(csrrw,     csr,  x, x, _, _, 0,       0x0000707f, 0x00001073)            \
+    X(csrrwi,    csr,  x, _, _, _, 0,       0x0000707f, 0x00005073)            \
+    /* F扩展(单精度) */                                                        \
+    X(flw,       i,    f, x, _, _, 0,       0x0000707f, 0x00002007)            \
+    X(fsw,       s,    _, x, f, _, 0,       0x0000707f, 0x00002027)            \
+    X(fmadd_s,   r4,   f, f, f, f, 0,       0x0600007f, 0x00000043)            \
+    X(fmsub_s,   r4,   f, f, f, f, 0,       0x0600007f, 0x00000047)            \
+    X(fnmsub_s,  r4,   f, f, f, f, 0,       0x0600007f, 0x0000004b)            \
+    X(fnmadd_s,  r4,   f, f, f, f, 0,       0x0600007f, 0x0000004f)            \
+    X(fadd_s,    r,    f, f, f, _, 0,       0xfe00007f, 0x00000053)            \
+    X(fsub_s,    r,    f, f, f, _, 0,       0xfe00007f, 0x08000053)            \
+    X(fmul_s,    r,    f, f, f, _, 0,       0xfe00007f, 0x10000053)            \
+    X(fdiv_s,    r,    f, f, f, _, 0,       0xfe00007f, 0x18000053)            \
+    X(fsqrt_s,   r,    f, f, _, _, 0,       0xfff0007f, 0x58000053)            \
+    X(fsgnj_s,   r,    f, f, f, _, 0,       0xfe00707f, 0x20000053)            \
+    X(fsgnjn_s,  r,    f, f, f, _, 0,       0xfe00707f, 0x20001053)            \
+    X(fsgnjx_s,  r,    f, f, f, _, 0,       0xfe00707f, 0x20002053)            \
+    X(fmin_s,    r,    f, f, f, _, 0,       0xfe00707f, 0x28000053)            \
+    X(fmax_s,    r,    f, f, f, _, 0,       0xfe00707f, 0x28001053)            \
+    X(fcvt_w_s,  r,    x, f, _, _, 0,       0xfff0007f, 0xc0000053)            \
+    X(fcvt_wu_s, r,    x, f, _, _, 0,       0xfff0007f, 0xc0100053)            \
+    X(fmv_x_w,   r,    x, f, _, _, 0,       0xfff0707f, 0xe0000053)            \
+    X(feq_s,     r,    x, f, f, _, 0,       0xfe00707f, 0xa0002053)            \
+    X(flt_s,     r,    x, f, f, _, 0,       0xfe00707f, 0xa0001053)            \
+    X(fle_s,     r,    x, f, f, _, 0,       0xfe00707f, 0xa0000053)            \
+    X(fclass_s,  r,    x, f, _, _, 0,       0xfff0707f, 0xe0001053)            \
+    X(fcvt_s_w,  r,    f, x, _, _, 0,       0xfff0007f, 0xd0000053)            \
+    X(fcvt_s_wu, r,    f, x, _, _, 0,       0xfff0007f, 0xd0100053)            \
+    X(fmv_w_x,   r,    f, x, _, _, 0,       0xfff0707f, 0xf0000053)            \
+    X(fcvt_l_s,  r,    x, f, _, _, 0,       0xfff0007f, 0xc0200053)            \
+    X(fcvt_lu_s, r,    x, f, _, _, 0,       0xfff0007f, 0xc0300053)            \
+    X(fcvt_s_l,  r,    f, x, _, _, 0,       0xfff0007f, 0xd0200053)            \
+    X(fcvt_s_lu, r,    f, x, _, _, 0,       0xfff0007f, 0xd0300053)            \
+    /* D扩展(双精度) */                                                        \
+    X(fld,       i,    f, x, _, _, 0,       0x0000707f, 0x00003007)            \
+    X(fsd,       s,    _, x, f, _, 0,       0x0000707f, 0x00003027)            \
+    X(fmadd_d,   r4,   f, f, f, f, 0,       0x0600007f, 0x02000043)            \
+    X(fmsub_d,   r4,   f, f, f, f, 0,       0x0600007f, 0x02000047)            \
+    X(fnmsub_d,  r4,   f, f, f, f, 0,       0x0600007f, 0x0200004b)            \
+    X(fnmadd_d,  r4,   f, f, f, f, 0,       0x0600007f, 0x0200004f)            \
+    X(fadd_d,    r,    f, f, f, _, 0,       0xfe00007f, 0x02000053)            \
+    X(fsub_d,    r,    f, f, f, _, 0,       0xfe00007f, 0x0a000053)            \
+    X(fmul_d,    r,    f, f, f, _, 0,       0xfe00007f, 0x12000053)            \
+    X(fdiv_d,    r,    f, f, f, _, 0,       0xfe00007f, 0x1a000053)            \
+    X(fsqrt_d,   r,    f, f, _, _, 0,       0xfff0007f, 0x5a000053)            \
+    X(fsgnj_d,   r,    f, f, f, _, 0,       0xfe00707f, 0x22000053)            \
+    X(fsgnjn_d,  r,    f, f, f, _, 0,       0xfe00707f, 0x22001053)            \
+    X(fsgnjx_d,  r,    f, f, f, _, 0,       0xfe00707f, 0x22002053)            \
+    X(fmin_d,    r,    f, f, f, _, 0,       0xfe00707f, 0x2a000053)            \
+    X(fmax_d,    r,    f, f, f, _, 0,       0xfe00707f, 0x2a001053)            \
+    X(fcvt_s_d,  r,    f, f, _, _, 0,       0xfff0007f, 0x40100053)            \
+    X(fcvt_d_s,  r,    f, f, _, _, 0,       0xfff0007f, 0x42000053)            \
+    X(feq_d,     r,    x, f, f, _, 0,       0xfe00707f, 0xa2002053)            \
+    X(flt_d,     r,    x, f, f, _, 0,       0xfe00707f, 0xa2001053)            \
+    X(fle_d,     r,    x, f, f, _, 0,       0xfe00707f, 0xa2000053)            \
+    X(fclass_d,  r,    x, f, _, _, 0,       0xfff0707f, 0xe2001053)            \
+    X(fcvt_w_d,  r,    x, f, _, _, 0,       0xfff0007f, 0xc2000053)            \
+    X(fcvt_wu_d, r,    x, f, _, _, 0,       0xfff0007f, 0xc2100053)            \
+    X(fcvt_d_w,  r,    f, x, _, _, 0,       0xfff0007f, 0xd2000053)            \
+    X(fcvt_d_wu, r,    f, x, _, _, 0,       0xfff0007f, 0xd2100053)            \
+    X(fcvt_l_d,  r,    x, f, _, _, 0,       0xfff0007f, 0xc2200053)            \
+    X(fcvt_lu_d, r,    x, f, _, _, 0,       0xfff0007f, 0xc2300053)            \
+    X(fmv_x_d,   r,    x, f, _, _, 0,       0xfff0707f, 0xe2000053)            \
+    X(fcvt_d_l,  r,    f, x, _, _, 0,       0xfff0007f, 0xd2200053)            \
+    X(fcvt_d_lu, r,    f, x, _, _, 0,       0xfff0007f, 0xd2300053)            \
+    X(fmv_d_x,   r,    f, x, _, _, 0,       0xfff0707f, 0xf2000053)            \
+    /* A扩展(原子指令), aq/rl位不参与解码 */                                   \
+    X(lr_w,      r,    x, x, _, _, 0,       0xf9f0707f, 0x1000202f)            \
+    X(sc_w,      r,    x, x, x, _, 0,       0xf800707f, 0x1800202f)            \
+    X(amoswap_w, r,    x, x, x, _, 0,       0xf800707f, 0x0800202f)            \
+    X(amoadd_w,  r,    x, x, x, _, 0,       0xf800707f, 0x0000202f)            \
+    X(amoxor_w,  r,    x, x, x, _, 0,       0xf800707f, 0x2000202f)            \
+    X(amoand_w,  r,    x, x, x, _, 0,       0xf800707f, 0x6000202f)            \
+    X(amoor_w,   r,    x, x, x, _, 0,       0xf800707f, 0x4000202f)            \
+    X(amomin_w,  r,    x, x, x, _, 0,       0xf800707f, 0x8000202f)            \
+    X(amomax_w,  r,    x, x, x, _, 0,       0xf800707f, 0xa000202f)            \
+    X(amominu_w, r,    x, x, x, _, 0,       0xf800707f, 0xc000202f)            \
+    X(amomaxu_w, r,    x, x, x, _, 0,       0xf800707f, 0xe000202f)            \
+    X(lr_d,      r,    x, x, _, _, 0,       0xf9f0707f, 0x1000302f)            \
+    X(sc_d,      r,    x, x, x, _, 0,       0xf800707f, 0x1800302f)            \
+    X(amoswap_d, r,    x, x, x, _, 0,       0xf800707f, 0x0800302f)            \
+    X(amoadd_d,  r,    x, x, x, _, 0,       0xf800707f, 0x0000302f)            \
+    X(amoxor_d,  r,    x, x, x, _, 0,       0xf800707f, 0x2000302f)            \
+    X(amoand_d,  r,    x, x, x, _, 0,       0xf800707f, 0x6000302f)            \
+    X(amoor_d,   r,    x, x, x, _, 0,       0xf800707f, 0x4000302f)            \
+    X(amomin_d,  r,    x, x, x, _, 0,       0xf800707f, 0x8000302f)            \
+    X(amomax_d,  r,    x, x, x, _, 0,       0xf800707f, 0xa000302f)            \
+    X(amominu_d, r,    x, x, x, _, 0,       0xf800707f, 0xc000302f)            \
+    X(amomaxu_d, r,    x, x, x, _, 0,       0xf800707f, 0xe000302f)
+// clang-format on
+
+#endif
@@ -1,40 +1,318 @@
 #include "rvemu.h"
 #include <assert.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
-enum exit_reason_t machine_step(machine_t *machine) {
+// exit_group时用来打断其它hart阻塞中的系统调用, 处理函数什么也不做
+#define HART_STOP_SIGNAL SIGRTMIN
+#define HART_STOP_RETRY_NS 10000000 // 信号可能在hart进入阻塞前送到, 隔一会再发
+
+block_t *machine_block(machine_t *machine, uint64_t pc) {
+    pthread_mutex_lock(&machine->lock);
+    // 预解码过的段按下标查, 其余查哈希表; 所有block都同时在哈希表里
+    block_t **slot = predecode_block(machine, pc);
+    block_t *block = slot ? *slot : cache_lookup(machine->cache, pc);
+    // RVEMU_SMC=0时fence.i清空缓存, 下标数组里会留下失效的block
+    if (block == NULL || block->stale) {
+        block = block_build(machine, pc);
+        block->next_tier =
+            MIN(machine->baseline_threshold, machine->opt_threshold);
+        smc_protect(machine, block);
+        cache_add(machine->cache, block);
+        if (slot)
+            *slot = block;
+    }
+    pthread_mutex_unlock(&machine->lock);
+    return block;
+}
+
+/*
+ * 按执行次数把block提升一层: 解释器 -> 基线JIT -> clang -O3。
+ * 基线JIT只要几微秒, 温热的代码很快就能脱离解释器;
+ * clang一次要几十毫秒, 只留给最热的block(循环头会带上整条superblock)。
+ * 某一层翻译失败时继续留在当前层, 到阈值后再试下一层。
+ * clang层在后台编译, 编译好之前block继续在当前层执行。
+ * 几个hart可能同时数到阈值, 加锁后再检查一次, 只有一个去提升。
+ */
+static void machine_promote(machine_t *machine, block_t *block) {
+    pthread_mutex_lock(&machine->lock);
+    uint64_t hot = __atomic_load_n(&block->hot, __ATOMIC_RELAXED);
+    if (hot < block->next_tier) {
+        pthread_mutex_unlock(&machine->lock);
+        return;
+    }
+
+    // 计数和next_tier在锁外被其它hart读写, 都用原子操作
+    if (block->tier == tier_interp && hot < machine->opt_threshold) {
+        block->tier = tier_baseline;
+        __atomic_store_n(
+            &block->next_tier, machine->opt_threshold, __ATOMIC_RELAXED
+        );
+        exec_block_func_t code = machine_baseline(machine, block);
+        if (code)
+            __atomic_store_n(&block->jit, code, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&machine->lock);
+        return;
+    }
+
+    // C代码在guest线程上生成(要读block的执行计数和链接), 编译交给后台线程
+    block->tier = tier_opt;
+    __atomic_store_n(&block->next_tier, UINT64_MAX, __ATOMIC_RELAXED);
+    jit_unit_t unit = { .source = str_new() };
+    bool ok = machine_genblock(machine, block, &unit);
+    pthread_mutex_unlock(&machine->lock);
+    if (ok)
+        pool_submit(machine->pool, &unit);
+    str_free(&unit.source);
+}
+
+/*
+ * 每个block出口的后继第一次走到时查哈希表, 之后把后继block的指针记在
+ * 出口对应的槽位里(直接跳转的succ[], 返回地址栈, jalr的ibtc, 见block_exit_slot),
+ * 解释器沿着槽位在block间连续执行, 只有ecall和还没填好的槽位才回到这里。
+ * guest进程正在退出时(见machine_stop)在block之间停下, 返回none。
+ */
+enum exit_reason_t machine_step(machine_t *machine, state_t *state) {
+    block_t *block = machine_block(machine, state->pc);
     while (true) {
-        machine->state.exit_reason = none;
-        exec_block_interp(&machine->state);
-        assert(machine->state.exit_reason != none);
-        if (machine->state.exit_reason == direct_branch ||
-            machine->state.exit_reason == indirect_branch) {
-
-            machine->state.pc = machine->state.reenter_pc;
-            continue; // for JIT
+        if (__atomic_load_n(&machine->exiting, __ATOMIC_RELAXED))
+            return none;
+        state->exit_reason = none;
+
+        if (block_count(&block->hot) >=
+            __atomic_load_n(&block->next_tier, __ATOMIC_RELAXED))
+            machine_promote(machine, block);
+
+        block_t **slot;
+        exec_block_func_t jit = __atomic_load_n(&block->jit, __ATOMIC_ACQUIRE);
+        if (jit) {
+            slot = block_exit_slot(state, jit(state));
+        } else {
+            slot = exec_block_interp(state, block);
+        }
+        assert(state->exit_reason != none);
+
+        state->pc = state->reenter_pc;
+        // 写保护触发过的页在找下一个block之前失效, 见smc_drain
+        if (__atomic_load_n(&machine->smc.pending, __ATOMIC_RELAXED))
+            smc_drain(machine);
+        if (state->exit_reason == ecall)
+            break;
+
+        // fence.i的出口不链接, 缓存可能刚被清空, 每次都重新查表
+        if (state->exit_reason == fence_i) {
+            smc_fence_i(machine);
+            block = machine_block(machine, state->pc);
+            continue;
+        }
+
+        // 槽位可能被别的hart填成了另一个目标, 见block_exit_slot
+        block = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (block == NULL || block->pc != state->pc) {
+            block = machine_block(machine, state->pc);
+            __atomic_store_n(slot, block, __ATOMIC_RELEASE);
         }
-        break;
     }
 
-    machine->state.pc = machine->state.reenter_pc;
-    assert(machine->state.exit_reason == ecall);
     return ecall;
 }
 
-void machine_load_program(machine_t *m, char *prog) {
-    int fd = open(prog, O_RDONLY);
-    if (fd == -1) {
-        fatal(strerror(errno));
+// 在当前线程上运行一个hart, 直到它调用exit或整个guest进程退出
+void machine_run_hart(machine_t *machine, state_t *state) {
+    smc_attach(machine);
+    pthread_mutex_lock(&machine->lock);
+    state->thread = pthread_self();
+    state->next = machine->hart_list;
+    machine->hart_list = state;
+    pthread_mutex_unlock(&machine->lock);
+
+    while (machine_step(machine, state) == ecall) {
+        // RISCV syscall发生时, a7寄存器记录syscall编号
+        // a0 - a6寄存器记录syscall所需参数
+        uint64_t syscall_id = state->gp_regs[a7];
+        state->gp_regs[a0] = do_syscall(machine, state, syscall_id);
+        if (state->halted)
+            break;
+    }
+
+    pthread_mutex_lock(&machine->lock);
+    for (state_t **p = &machine->hart_list; *p; p = &(*p)->next) {
+        if (*p == state) {
+            *p = state->next;
+            break;
+        }
     }
+    machine->icount += state->icount;
+    // 没有exit_group时, 最后一个调用exit的hart决定退出码
+    if (--machine->harts == 0 && !machine->exiting)
+        machine->exit_code = (int)state->gp_regs[a0];
+    pthread_cond_broadcast(&machine->halted);
+    pthread_mutex_unlock(&machine->lock);
+    smc_attach(NULL); // 之后这个线程可能去运行别的machine, machine也可能被释放
+}
 
-    mmu_load_elf(&(m->mmu), fd);
-    close(fd);
+static void hart_stop_handler(int sig) {}
+
+static void install_stop_handler(void) {
+    struct sigaction sa = { .sa_handler = hart_stop_handler };
+    sigemptyset(&sa.sa_mask);
+    // 不带SA_RESTART, 被打断的系统调用返回EINTR
+    if (sigaction(HART_STOP_SIGNAL, &sa, NULL) != 0)
+        fatal("cannot install the hart stop handler");
+}
+
+/*
+ * exit_group: 让其它hart都停下。它们在下一次回到machine_step或系统调用返回时
+ * 看到exiting后退出; 阻塞在系统调用里的hart(比如在futex上等待)用信号打断。
+ * 解释器在block之间链接执行时(block_chain)、superblock每转一圈时也检查exiting,
+ * 任何hart都不会一直执行下去而不经过检查。
+ * 只有第一个调用者等待, 同时调用exit_group的其它hart直接返回。
+ */
+void machine_stop(machine_t *machine, state_t *self, int code) {
+    pthread_mutex_lock(&machine->lock);
+    if (machine->exiting) {
+        pthread_mutex_unlock(&machine->lock);
+        return;
+    }
+    __atomic_store_n(&machine->exiting, true, __ATOMIC_RELAXED);
+    machine->exit_code = code;
+    while (machine->harts > 1) {
+        for (state_t *s = machine->hart_list; s; s = s->next) {
+            if (s != self)
+                pthread_kill(s->thread, HART_STOP_SIGNAL);
+        }
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += HART_STOP_RETRY_NS;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&machine->halted, &machine->lock, &ts);
+    }
+    pthread_mutex_unlock(&machine->lock);
+}
+
+// 读取分层阈值, 设为0表示关闭这一层
+static uint64_t env_threshold(const char *name, uint64_t def) {
+    const char *val = getenv(name);
+    if (val == NULL)
+        return def;
+    uint64_t n = strtoull(val, NULL, 0);
+    return n == 0 ? UINT64_MAX : n;
+}
+
+program_t *program_open(const char *path) {
+    program_t *prog = calloc(1, sizeof(program_t));
+    elf_image_open(&prog->elf, path);
+    prog->pcache = pcache_open(path);
+    return prog;
+}
+
+void program_close(program_t *prog) {
+    if (prog->pcache)
+        pcache_close(prog->pcache);
+    elf_image_close(&prog->elf);
+    free(prog);
+}
+
+void machine_load_program(machine_t *m, program_t *prog) {
+    static pthread_once_t stop_handler_once = PTHREAD_ONCE_INIT;
+    pthread_once(&stop_handler_once, install_stop_handler);
+
+    mmu_load_elf(&(m->mmu), &prog->elf);
 
     m->state.pc = (uint64_t)m->mmu.entry;
+    m->state.mem = m->mmu.mem;
+    m->state.exiting = &m->exiting;
+    m->state.tid = getpid(); // 主线程的线程号就是进程号
+    m->next_tid = m->state.tid + 1;
+    m->harts = 1;
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_cond_init(&m->halted, NULL);
+    for (int i = 0; i < MACHINE_MAX_FDS; i++)
+        m->fds[i] = i <= STDERR_FILENO ? fcntl(i, F_DUPFD_CLOEXEC, 0) : -1;
+    m->cache = new_cache();
+    m->baseline_threshold =
+        env_threshold("RVEMU_BASELINE_THRESHOLD", TIER_BASELINE_COUNT);
+    m->opt_threshold = env_threshold("RVEMU_OPT_THRESHOLD", TIER_OPT_COUNT);
+    smc_init(m);
+    predecode_init(m);
+
+#ifdef TRACE
+    // 探针只在解释器里, 跟踪时全程解释执行
+    trace_init();
+    if (trace_mask)
+        m->baseline_threshold = m->opt_threshold = UINT64_MAX;
+#endif
+
+    // 默认留一个核给guest线程, 其余都用来编译
+    long workers = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    const char *val = getenv("RVEMU_JIT_WORKERS");
+    if (val)
+        workers = strtol(val, NULL, 0);
+    m->pool = new_pool(m, MAX(workers, 0));
+
+    m->pcache = prog->pcache;
+    if (m->pcache)
+        pcache_load(m->pcache, m);
+}
+
+// guest退出前停止后台编译, 设置RVEMU_JIT_STATS时打印编译统计
+static void machine_exit(machine_t *m) {
+    pool_shutdown(m->pool);
+    if (getenv("RVEMU_JIT_STATS")) {
+        pool_print_stats(m->pool, stderr);
+        fprintf(
+            stderr,
+            "smc: %" PRIu64 " faults, %" PRIu64 " blocks invalidated\n",
+            m->smc.faults,
+            m->smc.invalidated
+        );
+    }
+}
+
+/*
+ * 在当前线程上运行guest的主线程, 所有hart都停下后返回guest进程的退出码。
+ * 之后可以用machine_free释放这个machine。
+ */
+int machine_run(machine_t *m) {
+    machine_run_hart(m, &m->state);
+    pthread_mutex_lock(&m->lock);
+    while (m->harts > 0)
+        pthread_cond_wait(&m->halted, &m->lock);
+    pthread_mutex_unlock(&m->lock);
+    machine_exit(m);
+    return m->exit_code;
+}
+
+// 把guest的fd换成宿主fd的一个副本, 宿主之后可以关掉自己的
+void machine_set_fd(machine_t *m, int fd, int host) {
+    int dup_fd = fcntl(host, F_DUPFD_CLOEXEC, 0);
+    if (dup_fd == -1)
+        fatal(strerror(errno));
+    if (m->fds[fd] != -1)
+        close(m->fds[fd]);
+    m->fds[fd] = dup_fd;
+}
+
+void machine_free(machine_t *m) {
+    for (int i = 0; i < MACHINE_MAX_FDS; i++) {
+        if (m->fds[i] != -1)
+            close(m->fds[i]);
+    }
+    pool_free(m->pool);
+    predecode_free(m);
+    cache_free(m->cache);
+    smc_free(m);
+    mmu_free(&m->mmu);
+    pthread_mutex_destroy(&m->lock);
+    pthread_cond_destroy(&m->halted);
 }
 
 void machine_setup(machine_t *machine, int argc, char *argv[]) {
@@ -59,13 +337,21 @@ void machine_setup(machine_t *machine, int argc, char *argv[]) {
         addr = mmu_alloc(&machine->mmu, len + 1);
         // printf("setup alloc addr 2 %lu-%lu\n", addr,
         // machine->mmu.guest_alloc); 将字符串指针写入栈底之后
-        mmu_write(addr, (uint8_t *)argv[i], len);
+        mmu_write(&machine->mmu, addr, (uint8_t *)argv[i], len);
         machine->state.gp_regs[sp] -= 8; // 字符串指针在被模拟程序的栈空间位置
         mmu_write(
-            machine->state.gp_regs[sp], (uint8_t *)&addr, sizeof(uint64_t)
+            &machine->mmu,
+            machine->state.gp_regs[sp],
+            (uint8_t *)&addr,
+            sizeof(uint64_t)
         );
     }
 
     machine->state.gp_regs[sp] -= 8; // argc
-    mmu_write(machine->state.gp_regs[sp], (uint8_t *)&argc, sizeof(uint64_t));
+    mmu_write(
+        &machine->mmu,
+        machine->state.gp_regs[sp],
+        (uint8_t *)&argc,
+        sizeof(uint64_t)
+    );
 }
\ No newline at end of file
@@ -6,17 +6,6 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
-static void
-load_phdr(elf64_phdr_t *phdr, elf64_ehdr_t *ehdr, int64_t i, FILE *file) {
-    if (fseek(file, ehdr->e_phoff + ehdr->e_phentsize * i, SEEK_SET) != 0) {
-        fatal("file too small");
-    }
-
-    if (fread((void *)phdr, 1, ehdr->e_phentsize, file) != ehdr->e_phentsize) {
-        fatal("file too small");
-    }
-}
-
 static int flags_to_mmap_prot(uint32_t flags) {
     return (flags & PF_R ? PROT_READ : 0) | (flags & PF_W ? PROT_WRITE : 0) |
            (flags & PF_X ? PROT_EXEC : 0);
@@ -60,7 +49,7 @@ static int flags_to_mmap_prot(uint32_t flags) {
  *   - 否则映射区会漏掉段的开头部分
  *
  * 对应代码：
- *   uint64_t guest_in_host_vaddr = TO_HOST(phdr->p_vaddr);
+ *   uint64_t guest_in_host_vaddr = TO_HOST(mmu->mem, phdr->p_vaddr);
  *   uint64_t aligned_vaddr = ROUNDDOWN(guest_in_host_vaddr, page_size);
  *   uint64_t filesz = phdr->p_filesz + (guest_in_host_vaddr - aligned_vaddr);
  *   uint64_t memsz  = phdr->p_memsz  + (guest_in_host_vaddr - aligned_vaddr);
@@ -69,7 +58,10 @@ static int flags_to_mmap_prot(uint32_t flags) {
 static void mmu_load_segment(mmu_t *mmu, elf64_phdr_t *phdr, int fd) {
     int page_size = getpagesize();
     uint64_t p_offset = phdr->p_offset;
-    uint64_t guest_in_host_vaddr = TO_HOST(phdr->p_vaddr);
+    if (phdr->p_vaddr + phdr->p_memsz > MMU_GUEST_SPACE ||
+        phdr->p_vaddr + phdr->p_memsz < phdr->p_vaddr)
+        fatal("segment outside the guest address space");
+    uint64_t guest_in_host_vaddr = TO_HOST(mmu->mem, phdr->p_vaddr);
     uint64_t aligned_vaddr = ROUNDDOWN(guest_in_host_vaddr, page_size);
     uint64_t filesz = phdr->p_filesz + (guest_in_host_vaddr - aligned_vaddr);
     uint64_t memsz = phdr->p_memsz + (guest_in_host_vaddr - aligned_vaddr);
@@ -98,41 +90,96 @@ static void mmu_load_segment(mmu_t *mmu, elf64_phdr_t *phdr, int fd) {
         );
         assert(addr == aligned_vaddr + ROUNDUP(filesz, page_size));
     }
+    mmu->segs[mmu->nsegs++] = (mmu_seg_t){
+        .start = TO_GUEST(mmu->mem, aligned_vaddr),
+        .end = TO_GUEST(mmu->mem, aligned_vaddr + ROUNDUP(memsz, page_size)),
+        .prot = prot,
+    };
     mmu->host_alloc =
         MAX(mmu->host_alloc, aligned_vaddr + ROUNDUP(memsz, page_size));
-    mmu->base = mmu->guest_alloc = TO_GUEST(mmu->host_alloc);
+    mmu->base = mmu->guest_alloc = TO_GUEST(mmu->mem, mmu->host_alloc);
     // printf("seg %lu-%lu\n", mmu->host_alloc, mmu->guest_alloc);
 }
 
-void mmu_load_elf(mmu_t *mmu, int fd) {
-    uint8_t buf[sizeof(elf64_ehdr_t)];
+static void
+load_phdr(elf64_phdr_t *phdr, elf64_ehdr_t *ehdr, int64_t i, int fd) {
+    off_t off = ehdr->e_phoff + ehdr->e_phentsize * i;
+    if (pread(fd, phdr, sizeof(*phdr), off) != sizeof(*phdr)) {
+        fatal("file too small");
+    }
+}
 
-    FILE *file = fdopen(fd, "rb");
+/*
+ * 读ELF头和PT_LOAD段的program header, 文件保持打开,
+ * 之后每个machine按这里记下的段从fd映射, 不再重新解析文件
+ */
+void elf_image_open(elf_image_t *elf, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC); // 一直开着, 不能漏给编译器
+    if (fd == -1) {
+        fatalf("%s: %s", path, strerror(errno));
+    }
 
-    if (fread(buf, 1, sizeof(elf64_ehdr_t), file) != sizeof(elf64_ehdr_t)) {
+    elf64_ehdr_t ehdr;
+    if (pread(fd, &ehdr, sizeof(ehdr), 0) != sizeof(ehdr)) {
         fatal("file too small");
     }
 
-    elf64_ehdr_t *ehdr = (elf64_ehdr_t *)buf;
-
-    if (*(uint32_t *)ehdr != *(uint32_t *)ELFMAG) {
+    if (*(uint32_t *)&ehdr != *(uint32_t *)ELFMAG) {
         fatal("bad elfmag");
     }
 
-    if (ehdr->e_machine != EM_RISCV || ehdr->e_ident[EI_CLASS] != ELFCLASS64) {
+    if (ehdr.e_machine != EM_RISCV || ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
         fatal("only RISCV64 elf support");
     }
 
-    mmu->entry = ehdr->e_entry;
+    elf->fd = fd;
+    elf->entry = ehdr.e_entry;
+    elf->nphdrs = 0;
+    for (int64_t i = 0; i < ehdr.e_phnum; i++) {
+        elf64_phdr_t phdr;
+        load_phdr(&phdr, &ehdr, i, fd);
+        if (phdr.p_type != PT_LOAD)
+            continue;
+        if (elf->nphdrs == MMU_MAX_SEGS)
+            fatal("too many segments");
+        elf->phdrs[elf->nphdrs++] = phdr;
+    }
+}
+
+void elf_image_close(elf_image_t *elf) {
+    close(elf->fd);
+    elf->fd = -1;
+}
 
-    elf64_phdr_t phdr;
-    for (int64_t i = 0; i < ehdr->e_phnum; i++) {
-        load_phdr(&phdr, ehdr, i, file);
+void mmu_load_elf(mmu_t *mmu, elf_image_t *elf) {
+    mmu->entry = elf->entry;
+
+    // 先占住整段guest地址空间, 段和堆都用MAP_FIXED映射在里面,
+    // 不会与宿主或其它machine的映射重叠
+    void *mem = mmap(
+        NULL,
+        MMU_GUEST_SPACE,
+        PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+        -1,
+        0
+    );
+    if (mem == MAP_FAILED)
+        fatal("cannot reserve the guest address space");
+    mmu->mem = (uint64_t)mem;
+
+    for (int i = 0; i < elf->nphdrs; i++)
+        mmu_load_segment(mmu, &elf->phdrs[i], elf->fd);
+}
 
-        if (phdr.p_type == PT_LOAD) {
-            mmu_load_segment(mmu, &phdr, fd);
-        }
+// guest地址所在页映射时的权限, 堆和栈都是可读写的
+int mmu_prot(mmu_t *mmu, uint64_t addr) {
+    // 相邻的段可能共用一页, 后加载的段覆盖了前面的映射
+    for (int i = mmu->nsegs - 1; i >= 0; i--) {
+        if (addr >= mmu->segs[i].start && addr < mmu->segs[i].end)
+            return mmu->segs[i].prot;
     }
+    return addr >= mmu->base ? PROT_READ | PROT_WRITE : PROT_NONE;
 }
 
 uint64_t mmu_alloc(mmu_t *mmu, int64_t size) {
@@ -142,30 +189,42 @@ uint64_t mmu_alloc(mmu_t *mmu, int64_t size) {
     mmu->guest_alloc += size; // 可能会释放内存
     assert(mmu->guest_alloc >= mmu->base);
 
-    if (size > 0 && mmu->guest_alloc > TO_GUEST(mmu->host_alloc)) {
-        uint64_t alloc_size = ROUNDUP(size, page_size);
-        if (mmap(
+    uint64_t host_end = TO_GUEST(mmu->mem, mmu->host_alloc);
+    if (size > 0 && mmu->guest_alloc > host_end) {
+        uint64_t alloc_size = ROUNDUP(mmu->guest_alloc - host_end, page_size);
+        if (host_end + alloc_size > MMU_GUEST_SPACE ||
+            mmap(
                 (void *)mmu->host_alloc,
                 alloc_size,
                 PROT_READ | PROT_WRITE,
-                MAP_ANONYMOUS | MAP_PRIVATE,
+                MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED,
                 -1,
                 0
             ) == MAP_FAILED)
             fatal("mmap failed in mmu alloc");
 
         mmu->host_alloc += alloc_size;
-    } else if (size < 0 && ROUNDUP(mmu->guest_alloc, page_size) <
-                               TO_GUEST(mmu->host_alloc)) {
-        uint64_t munmap_size =
-            TO_GUEST(mmu->host_alloc) - ROUNDUP(mmu->guest_alloc, page_size);
-        if (munmap((void *)mmu->host_alloc, munmap_size) == -1)
-            fatal(strerror(errno)); // ??? 似乎有问题
-        // if (munmap((void *)(mmu->host_alloc - munmap_size), munmap_size) ==
-        // -1)
-        //     fatal(strerror(errno));
-        mmu->host_alloc -= munmap_size;
+    } else if (size < 0 && ROUNDUP(mmu->guest_alloc, page_size) < host_end) {
+        // 释放的页换回不可访问的预留映射, 不能munmap, 否则这段地址会被别人占去
+        uint64_t free_size = host_end - ROUNDUP(mmu->guest_alloc, page_size);
+        mmu->host_alloc -= free_size;
+        if (mmap(
+                (void *)mmu->host_alloc,
+                free_size,
+                PROT_NONE,
+                MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE,
+                -1,
+                0
+            ) == MAP_FAILED)
+            fatal(strerror(errno));
     }
 
     return base; // 返回堆内存的初始地址, 该值在加载完elf后恒定
-}
\ No newline at end of file
+}
+
+// 释放整段guest地址空间
+void mmu_free(mmu_t *mmu) {
+    if (mmu->mem)
+        munmap((void *)mmu->mem, MMU_GUEST_SPACE);
+    mmu->mem = 0;
+}
@@ -0,0 +1,410 @@
+#include "rvemu.h"
+
+/*
+ * block级优化
+ *
+ * block里预解码好的inst_t序列本身就是一份线性的三地址IR, 解释器、基线JIT和
+ * clang后端都直接执行它, 所以在block_build时改写一次, 三个执行引擎同时受益。
+ * block是单入口的直线代码, 每个位置上每个寄存器只有一个到达定义,
+ * 逐条跟踪寄存器的当前值就等价于在SSA上做分析, 不必真的构造SSA。
+ *
+ * - 常量传播与折叠: 源操作数都已知的纯运算改写成lui rd, imm
+ *   (lui的imm本来就是完整的32位有符号立即数), 如lui+addi、auipc+addi
+ * - 地址折叠: 基址已知的访存改成以x0为基址的绝对地址, 如auipc+ld;
+ *   目标已知的jalr改成jal, 如auipc+jalr调用, 出口也随之变成可链接的直接跳转
+ * - 复制传播: mv之后读rd的指令改为直接读源寄存器, 已知为0的源寄存器换成x0
+ * - 死写消除: 没有副作用的指令(纯运算、load、浮点运算), 结果在block内被覆盖
+ *   之前没有被读过, 或者写的是x0, 就删掉这条指令
+ * - 写x0的jal/jalr改成不写rd的j/jr。加上上一条, 除了csr指令写的0,
+ *   任何指令都不会写x0, 执行引擎不必在每条指令后把x0清零
+ * - 操作数特化: 最后按操作数选用SPECIAL_LIST中的变体, 见specialize()
+ *
+ * - 指令融合: 把常见的相邻指令对合成一条融合指令, 减少一次分发,
+ *   见fuse(); lui+addi、auipc+ld、auipc+jalr在前面已经折叠成一条指令
+ *
+ * 删掉的指令并入前一条指令的size, pc照常前进; 出现在block开头的改成nop。
+ * 常量折叠直接调用解释器的处理函数求值, 指令语义只有一份。
+ */
+
+// 用到浮点寄存器的指令
+static inline bool is_fp(enum inst_type_t type) {
+    const isa_info_t *isa = &isa_info[type];
+    return isa->rd == isa_opnd_f || isa->rs1 == isa_opnd_f ||
+           isa->rs2 == isa_opnd_f || isa->rs3 == isa_opnd_f;
+}
+
+static inline bool is_load(enum inst_type_t type) {
+    return (type >= inst_lb && type <= inst_lwu) || type == inst_flw ||
+           type == inst_fld;
+}
+
+static inline bool is_store(enum inst_type_t type) {
+    return (type >= inst_sb && type <= inst_sd) || type == inst_fsw ||
+           type == inst_fsd;
+}
+
+// 只读写通用寄存器、没有其它副作用的整数运算
+bool inst_is_pure(enum inst_type_t type) {
+    switch (type) {
+    case inst_addi:
+    case inst_slli:
+    case inst_slti:
+    case inst_sltiu:
+    case inst_xori:
+    case inst_srli:
+    case inst_srai:
+    case inst_ori:
+    case inst_andi:
+    case inst_auipc:
+    case inst_addiw:
+    case inst_slliw:
+    case inst_srliw:
+    case inst_sraiw:
+    case inst_add:
+    case inst_sll:
+    case inst_slt:
+    case inst_sltu:
+    case inst_xor:
+    case inst_srl:
+    case inst_or:
+    case inst_and:
+    case inst_mul:
+    case inst_mulh:
+    case inst_mulhsu:
+    case inst_mulhu:
+    case inst_div:
+    case inst_divu:
+    case inst_rem:
+    case inst_remu:
+    case inst_sub:
+    case inst_sra:
+    case inst_lui:
+    case inst_addw:
+    case inst_sllw:
+    case inst_srlw:
+    case inst_mulw:
+    case inst_divw:
+    case inst_divuw:
+    case inst_remw:
+    case inst_remuw:
+    case inst_subw:
+    case inst_sraw:
+    case inst_slli_srli:
+    case inst_slli_add:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 按isa.h中的操作数类型换成统一编号, 不用的字段为-1
+static int operand(uint8_t kind, int reg) {
+    switch (kind) {
+    case isa_opnd_x:
+        return reg;
+    case isa_opnd_f:
+        return reg + num_gp_regs;
+    default:
+        return -1;
+    }
+}
+
+/*
+ * 对应编码的指令按isa.h的操作数; 其它指令(j/jr和融合指令)只用通用寄存器,
+ * 不用的字段为0, 会被当成读x0, 只会让分析更保守。
+ * ecall隐式读写的a0-a7不在其中, 它总是block的最后一条指令。
+ */
+inst_regs_t inst_regs(inst_t *inst) {
+    enum inst_type_t type = inst_generic(inst->type);
+    const isa_info_t *isa = &isa_info[type];
+    inst_regs_t regs = { .rd = -1, .rs = { -1, -1, -1 } };
+    if (isa->mask != 0) {
+        regs.rd = operand(isa->rd, inst->rd);
+        regs.rs[0] = operand(isa->rs1, inst->rs1);
+        regs.rs[1] = operand(isa->rs2, inst->rs2);
+        regs.rs[2] = operand(isa->rs3, inst->rs3);
+    } else if (type != inst_nop) {
+        regs.rs[0] = inst->rs1;
+        regs.rs[1] = inst->rs2;
+        if (type != inst_j && type != inst_jr)
+            regs.rd = inst->rd;
+    }
+    if (regs.rd == zero)
+        regs.rd = -1;
+    return regs;
+}
+
+typedef struct {
+    bool known[num_gp_regs]; // 寄存器的值是否已知
+    uint64_t val[num_gp_regs];
+    int8_t copy[num_gp_regs]; // 寄存器当前与哪个寄存器相等, -1表示没有
+} values_t;
+
+static int8_t substitute(values_t *v, int8_t r) {
+    if (v->known[r] && v->val[r] == 0)
+        return zero;
+    return v->copy[r] >= 0 ? v->copy[r] : r;
+}
+
+// mv及其等价写法(c.mv即add rd, x0, rs)的源寄存器, 不是复制时返回-1
+static int copy_source(inst_t *inst) {
+    switch (inst->type) {
+    case inst_addi:
+    case inst_ori:
+    case inst_xori:
+        return inst->imm == 0 ? inst->rs1 : -1;
+    case inst_add:
+    case inst_or:
+    case inst_xor:
+        if (inst->rs1 == zero)
+            return inst->rs2;
+        return inst->rs2 == zero ? inst->rs1 : -1;
+    default:
+        return -1;
+    }
+}
+
+// 源操作数都已知时求值: 在临时state上执行解释器的处理函数
+static uint64_t eval(values_t *v, inst_t *inst, uint64_t pc) {
+    state_t state = { .pc = pc };
+    state.gp_regs[inst->rs1] = v->val[inst->rs1];
+    state.gp_regs[inst->rs2] = v->val[inst->rs2];
+    inst_t tmp = *inst;
+    tmp.rd = t6; // 处理函数先读源操作数再写rd, 与源寄存器重叠也没关系
+#ifdef TRACE
+    // 这不是guest真正执行的指令, 不产生跟踪记录; 只关掉本线程的探针,
+    // 其它hart(和别的machine)同时还在执行
+    trace_suppress = true;
+    funcs[inst->type](&state, &tmp);
+    trace_suppress = false;
+#else
+    funcs[inst->type](&state, &tmp);
+#endif
+    return state.gp_regs[t6];
+}
+
+static void fold_address(values_t *v, inst_t *inst, uint64_t pc) {
+    if (inst->rs1 == zero || !v->known[inst->rs1])
+        return;
+    int64_t addr = v->val[inst->rs1] + (int64_t)inst->imm;
+
+    if (is_load(inst->type) || is_store(inst->type)) {
+        if (addr == (int32_t)addr) {
+            inst->rs1 = zero;
+            inst->imm = addr;
+        }
+    } else if (inst->type == inst_jalr) {
+        int64_t off = (int64_t)((addr & ~1ULL) - pc);
+        if (off == (int32_t)off) {
+            inst->type = inst_jal;
+            inst->rs1 = zero;
+            inst->imm = off;
+        }
+    }
+}
+
+static void define(values_t *v, int rd, bool known, uint64_t val, int src) {
+    v->known[rd] = known;
+    v->val[rd] = val;
+    v->copy[rd] = src >= 0 && src != rd ? src : -1;
+    for (int r = 0; r < num_gp_regs; r++) {
+        if (v->copy[r] == rd)
+            v->copy[r] = -1;
+    }
+}
+
+static void propagate(uint64_t pc, inst_t *insts, uint32_t len) {
+    values_t v = { .known[zero] = true };
+    memset(v.copy, -1, sizeof(v.copy));
+
+    for (uint32_t i = 0; i < len; i++) {
+        inst_t *inst = &insts[i];
+        inst_regs_t regs = inst_regs(inst);
+        if (regs.rs[0] >= 0 && regs.rs[0] < num_gp_regs)
+            inst->rs1 = substitute(&v, inst->rs1);
+        if (regs.rs[1] >= 0 && regs.rs[1] < num_gp_regs)
+            inst->rs2 = substitute(&v, inst->rs2);
+        fold_address(&v, inst, pc);
+
+        bool known = false;
+        uint64_t val = 0;
+        if (inst_is_pure(inst->type) && v.known[inst->rs1] &&
+            v.known[inst->rs2]) {
+            known = true;
+            val = eval(&v, inst, pc);
+            if ((int64_t)val == (int32_t)val) {
+                inst->type = inst_lui;
+                inst->rs1 = inst->rs2 = zero;
+                inst->imm = (int32_t)val;
+            }
+        }
+
+        if (regs.rd >= 0 && regs.rd < num_gp_regs)
+            define(&v, regs.rd, known, val, copy_source(inst));
+        pc += inst->size;
+    }
+}
+
+// 从后往前扫描, block结束时所有寄存器都视为活跃
+static void eliminate_dead(inst_t *insts, uint32_t len) {
+    bool live[NUM_REGS];
+    memset(live, true, sizeof(live));
+
+    for (int i = len - 1; i >= 0; i--) {
+        inst_t *inst = &insts[i];
+        inst_regs_t regs = inst_regs(inst);
+        bool removable = inst_is_pure(inst->type) || is_load(inst->type) ||
+                         (is_fp(inst->type) && !is_store(inst->type));
+        if (removable && (regs.rd < 0 || !live[regs.rd])) {
+            inst->type = inst_nop;
+            continue;
+        }
+        if (regs.rd >= 0)
+            live[regs.rd] = false;
+        for (int k = 0; k < ARRAY_SIZE(regs.rs); k++) {
+            if (regs.rs[k] >= 0)
+                live[regs.rs[k]] = true;
+        }
+    }
+}
+
+// block只有最后一条是跳转
+static void drop_zero_link(inst_t *last) {
+    if (last->rd != zero)
+        return;
+    if (last->type == inst_jal)
+        last->type = inst_j;
+    else if (last->type == inst_jalr)
+        last->type = inst_jr;
+}
+
+/*
+ * 前一条的结果只被后一条使用(写同一个rd)时才融合, 中间值不必保留:
+ * - slli rd, rs, a; srli rd, rd, b   => slli_srli
+ * - slli rd, rs, a; add rd, rd, rs2  => slli_add
+ * - addi rd, rs, a; bne/blt/bltu rd, rs2, off => addi_bne/blt/bltu
+ * 融合结果放在第一条的位置, 第二条改成size为0的nop。两条的立即数分别放进
+ * imm1/imm2, 只有16位: 移位量和addi的立即数都放得下, 分支偏移加上第一条的size
+ * 最多4095 + UINT8_MAX。
+ */
+static bool fuse_pair(inst_t *a, inst_t *b) {
+    if (a->rd == zero || a->type == inst_nop || a->size + b->size > UINT8_MAX)
+        return false;
+
+    inst_t fused = *a;
+    fused.size = a->size + b->size;
+    if (a->type == inst_slli && b->type == inst_srli && b->rs1 == a->rd &&
+        b->rd == a->rd) {
+        fused.type = inst_slli_srli;
+        fused.imm1 = a->imm;
+        fused.imm2 = b->imm;
+    } else if (a->type == inst_slli && b->type == inst_add && b->rd == a->rd &&
+               (b->rs1 == a->rd) != (b->rs2 == a->rd)) {
+        fused.type = inst_slli_add;
+        fused.imm1 = a->imm;
+        fused.rs2 = b->rs1 == a->rd ? b->rs2 : b->rs1;
+    } else if (a->type == inst_addi &&
+               (b->type == inst_bne || b->type == inst_blt ||
+                b->type == inst_bltu)) {
+        // bne两边对称, rd在右边时交换
+        int8_t rs2 = b->rs1 == a->rd ? b->rs2 : b->rs1;
+        if (rs2 == a->rd || (b->rs1 != a->rd &&
+                             (b->type != inst_bne || b->rs2 != a->rd)))
+            return false;
+        fused.type = b->type == inst_bne   ? inst_addi_bne
+                     : b->type == inst_blt ? inst_addi_blt
+                                           : inst_addi_bltu;
+        fused.rs2 = rs2;
+        fused.imm1 = a->imm;
+        fused.imm2 = a->size + b->imm;
+        fused.continue_exec = b->continue_exec;
+    } else {
+        return false;
+    }
+
+    *a = fused;
+    *b = (inst_t){ .type = inst_nop };
+    return true;
+}
+
+static void fuse(inst_t *insts, uint32_t len) {
+    for (uint32_t i = 0; i + 1 < len; i++) {
+        if (fuse_pair(&insts[i], &insts[i + 1]))
+            i++;
+    }
+}
+
+// 操作数退化时换成SPECIAL_LIST中对应的变体, 其它字段不变
+static void specialize(inst_t *inst) {
+    switch (inst->type) {
+    case inst_addi:
+        if (inst->imm == 0)
+            inst->type = inst_mv;
+        return;
+    case inst_jr:
+        if (inst->rs1 == ra && inst->imm == 0)
+            inst->type = inst_ret;
+        return;
+#define X(name)                                                                \
+    case inst_##name:                                                          \
+        if (inst->rs1 == zero)                                                 \
+            inst->type = inst_##name##_abs;                                    \
+        else if (inst->imm == 0)                                               \
+            inst->type = inst_##name##_0;                                      \
+        return;
+        X(lb) X(lh) X(lw) X(ld) X(lbu) X(lhu) X(lwu)
+#undef X
+    case inst_beq:
+    case inst_bne:
+        // 两边对称, x0统一放到rs2
+        if (inst->rs1 == zero) {
+            inst->rs1 = inst->rs2;
+            inst->rs2 = zero;
+        }
+        if (inst->rs2 == zero)
+            inst->type = inst->type == inst_beq ? inst_beqz : inst_bnez;
+        return;
+    case inst_blt:
+        if (inst->rs2 == zero)
+            inst->type = inst_bltz;
+        else if (inst->rs1 == zero)
+            inst->type = inst_bgtz;
+        return;
+    case inst_bge:
+        if (inst->rs2 == zero)
+            inst->type = inst_bgez;
+        else if (inst->rs1 == zero)
+            inst->type = inst_blez;
+        return;
+    default:
+        return;
+    }
+}
+
+// nop并入前一条指令, size放不下时保留
+static uint32_t compact(inst_t *insts, uint32_t len) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        inst_t *inst = &insts[i];
+        if (inst->type == inst_nop && n > 0 &&
+            insts[n - 1].size + inst->size <= UINT8_MAX) {
+            insts[n - 1].size += inst->size;
+            continue;
+        }
+        insts[n++] = insts[i];
+    }
+    return n;
+}
+
+// 优化从pc开始的len条指令, 返回优化后的指令数
+uint32_t block_optimize(uint64_t pc, inst_t *insts, uint32_t len) {
+    propagate(pc, insts, len);
+    eliminate_dead(insts, len);
+    len = compact(insts, len);
+    drop_zero_link(&insts[len - 1]);
+    fuse(insts, len);
+    len = compact(insts, len);
+    for (uint32_t i = 0; i < len; i++)
+        specialize(&insts[i]);
+    return len;
+}
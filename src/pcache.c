@@ -0,0 +1,348 @@
+#define _GNU_SOURCE // mkostemp
+#include "rvemu.h"
+#include <dirent.h>
+#include <limits.h>
+
+/*
+ * 磁盘上的翻译缓存
+ *
+ * clang编译出的目标文件连同blocks[]表对应的guest pc一起存进缓存目录,
+ * 下次运行同一个程序时在启动阶段就全部装载, 省掉预热和clang的开销。
+ *
+ * 目录结构: <根目录>/v<版本>/<程序key>/<入口pc>.blk
+ * - 根目录: $RVEMU_CACHE_DIR, 默认$XDG_CACHE_HOME/rvemu或~/.cache/rvemu,
+ *   RVEMU_CACHE_DIR设为空字符串时关闭
+ * - 程序key: ELF所有PT_LOAD段(地址、大小、内容)和rvemu自身可执行文件的散列,
+ *   guest程序或rvemu任一改变都会换一个目录
+ * - 写入先写临时文件再rename, 多个rvemu进程共用目录时读到的总是完整的文件
+ * - 总大小超过$RVEMU_CACHE_SIZE(MB, 默认256)时, 退出前按修改时间淘汰最旧的文件,
+ *   每次装载会更新文件的修改时间
+ */
+
+#define PCACHE_VERSION 1
+#define PCACHE_MAGIC "RVEMUJIT"
+#define PCACHE_DEFAULT_SIZE_MB 256
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t nblocks;
+    uint64_t build_id;
+    uint64_t obj_size;
+    // 之后是uint64_t pcs[nblocks], 然后是目标文件
+} pcache_hdr_t;
+
+struct pcache_t {
+    char root[PATH_MAX];
+    char dir[PATH_MAX];
+    uint64_t build_id;
+    uint64_t size_cap;
+    uint64_t loaded; // 同一个程序的多个machine并发装载, 原子更新
+    uint64_t saved;  // 工作线程并发写入, 原子更新
+};
+
+static uint64_t hash_bytes(uint64_t h, const uint8_t *p, size_t n) {
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h = (h ^ v) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+    }
+    for (; n > 0; p++, n--)
+        h = (h ^ *p) * 0x100000001b3ULL;
+    return h;
+}
+
+static uint8_t *map_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+    struct stat st;
+    uint8_t *p = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            p = NULL;
+        *size = st.st_size;
+    }
+    close(fd);
+    return p;
+}
+
+// 散列ELF的所有PT_LOAD段, 文件不完整时返回0
+static uint64_t hash_program(const char *prog) {
+    size_t size;
+    uint8_t *p = map_file(prog, &size);
+    if (p == NULL)
+        return 0;
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    elf64_ehdr_t *ehdr = (elf64_ehdr_t *)p;
+    if (size < sizeof(elf64_ehdr_t) ||
+        ehdr->e_phoff + ehdr->e_phnum * sizeof(elf64_phdr_t) > size) {
+        h = 0;
+        goto out;
+    }
+    for (int i = 0; i < ehdr->e_phnum; i++) {
+        elf64_phdr_t *phdr = (elf64_phdr_t *)(p + ehdr->e_phoff) + i;
+        if (phdr->p_type != PT_LOAD)
+            continue;
+        if (phdr->p_offset + phdr->p_filesz > size) {
+            h = 0;
+            goto out;
+        }
+        h = hash_bytes(h, (uint8_t *)&phdr->p_vaddr, sizeof(phdr->p_vaddr));
+        h = hash_bytes(h, (uint8_t *)&phdr->p_memsz, sizeof(phdr->p_memsz));
+        h = hash_bytes(h, p + phdr->p_offset, phdr->p_filesz);
+    }
+
+out:
+    munmap(p, size);
+    return h;
+}
+
+static bool mkdirs(char *path) {
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/')
+            continue;
+        *p = '\0';
+        int err = mkdir(path, 0755);
+        *p = '/';
+        if (err != 0 && errno != EEXIST)
+            return false;
+    }
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+pcache_t *pcache_open(const char *prog) {
+    const char *root = getenv("RVEMU_CACHE_DIR");
+    char buf[PATH_MAX];
+    if (root == NULL) {
+        const char *xdg = getenv("XDG_CACHE_HOME");
+        const char *home = getenv("HOME");
+        if (xdg && *xdg)
+            snprintf(buf, sizeof(buf), "%s/rvemu", xdg);
+        else if (home && *home)
+            snprintf(buf, sizeof(buf), "%s/.cache/rvemu", home);
+        else
+            return NULL;
+        root = buf;
+    }
+    if (*root == '\0')
+        return NULL;
+
+    // rvemu自身的任何改动(生成代码的格式、state_t布局等)都会让旧的缓存失效
+    size_t size;
+    uint8_t *self = map_file("/proc/self/exe", &size);
+    if (self == NULL)
+        return NULL;
+    uint64_t build_id = hash_bytes(PCACHE_VERSION, self, size);
+    munmap(self, size);
+
+    uint64_t prog_key = hash_program(prog);
+    if (prog_key == 0)
+        return NULL;
+
+    pcache_t *pc = calloc(1, sizeof(pcache_t));
+    pc->build_id = build_id;
+    snprintf(pc->root, sizeof(pc->root), "%s", root);
+    int n = snprintf(
+        pc->dir,
+        sizeof(pc->dir),
+        "%s/v%d/%016" PRIx64,
+        root,
+        PCACHE_VERSION,
+        prog_key ^ build_id
+    );
+    if (n >= (int)sizeof(pc->dir) || !mkdirs(pc->dir)) {
+        free(pc);
+        return NULL;
+    }
+
+    const char *cap = getenv("RVEMU_CACHE_SIZE");
+    pc->size_cap =
+        (cap ? strtoull(cap, NULL, 0) : PCACHE_DEFAULT_SIZE_MB) << 20;
+    return pc;
+}
+
+// 校验并装载一个缓存文件, 成功后入口block直接进入最高层
+static bool load_entry(pcache_t *pc, machine_t *m, uint8_t *p, size_t size) {
+    pcache_hdr_t *hdr = (pcache_hdr_t *)p;
+    if (size < sizeof(pcache_hdr_t) ||
+        memcmp(hdr->magic, PCACHE_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != PCACHE_VERSION || hdr->build_id != pc->build_id ||
+        hdr->nblocks == 0 || hdr->nblocks > TRACE_MAX_BLOCKS ||
+        sizeof(pcache_hdr_t) + hdr->nblocks * sizeof(uint64_t) +
+                hdr->obj_size !=
+            size)
+        return false;
+
+    uint64_t *pcs = (uint64_t *)(hdr + 1);
+    block_t *blocks[TRACE_MAX_BLOCKS];
+    for (uint32_t i = 0; i < hdr->nblocks; i++)
+        blocks[i] = machine_block(m, pcs[i]);
+    if (blocks[0]->jit)
+        return false;
+
+    uint8_t *obj = (uint8_t *)(pcs + hdr->nblocks);
+    exec_block_func_t code =
+        machine_load_object(m, obj, hdr->obj_size, blocks, hdr->nblocks);
+    if (code == NULL)
+        return false;
+    smc_cover(blocks, hdr->nblocks);
+    blocks[0]->jit = code;
+    blocks[0]->tier = tier_opt;
+    blocks[0]->next_tier = UINT64_MAX;
+    return true;
+}
+
+void pcache_load(pcache_t *pc, machine_t *m) {
+    DIR *dir = opendir(pc->dir);
+    if (dir == NULL)
+        return;
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        if (len < 4 || strcmp(ent->d_name + len - 4, ".blk") != 0)
+            continue;
+
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", pc->dir, ent->d_name) >=
+            (int)sizeof(path))
+            continue;
+        size_t size;
+        uint8_t *p = map_file(path, &size);
+        if (p == NULL)
+            continue;
+        if (load_entry(pc, m, p, size)) {
+            __atomic_fetch_add(&pc->loaded, 1, __ATOMIC_RELAXED);
+            utimensat(AT_FDCWD, path, NULL, 0); // 刷新修改时间, 淘汰时保留
+        }
+        munmap(p, size);
+    }
+    closedir(dir);
+}
+
+// 工作线程调用: 写临时文件后rename成<入口pc>.blk, 失败时静默放弃
+void pcache_save(
+    pcache_t *pc, block_t **blocks, uint32_t nblocks, uint8_t *obj, size_t size
+) {
+    char tmp[PATH_MAX], path[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s/.tmp-XXXXXX", pc->dir) >=
+            (int)sizeof(tmp) ||
+        snprintf(path, sizeof(path), "%s/%" PRIx64 ".blk", pc->dir,
+                 blocks[0]->pc) >= (int)sizeof(path))
+        return;
+    int fd = mkostemp(tmp, O_CLOEXEC); // 别的工作线程正在启动编译器
+    if (fd == -1)
+        return;
+
+    pcache_hdr_t hdr = {
+        .version = PCACHE_VERSION,
+        .nblocks = nblocks,
+        .build_id = pc->build_id,
+        .obj_size = size,
+    };
+    memcpy(hdr.magic, PCACHE_MAGIC, sizeof(hdr.magic));
+    uint64_t pcs[TRACE_MAX_BLOCKS];
+    for (uint32_t i = 0; i < nblocks; i++)
+        pcs[i] = blocks[i]->pc;
+
+    bool ok = write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+              write(fd, pcs, nblocks * sizeof(uint64_t)) ==
+                  (ssize_t)(nblocks * sizeof(uint64_t)) &&
+              write(fd, obj, size) == (ssize_t)size;
+    close(fd);
+    if (ok && rename(tmp, path) == 0)
+        __atomic_fetch_add(&pc->saved, 1, __ATOMIC_RELAXED);
+    else
+        unlink(tmp);
+}
+
+typedef struct {
+    char *path;
+    uint64_t size;
+    struct timespec mtime;
+} pcache_file_t;
+
+typedef struct {
+    pcache_file_t *files;
+    uint64_t nfiles;
+    uint64_t cap;
+    uint64_t total;
+} file_list_t;
+
+static void collect_files(const char *path, file_list_t *list) {
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return;
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+        char child[PATH_MAX];
+        struct stat st;
+        if (snprintf(child, sizeof(child), "%s/%s", path, ent->d_name) >=
+                (int)sizeof(child) ||
+            lstat(child, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode)) {
+            collect_files(child, list);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode))
+            continue;
+
+        if (list->nfiles == list->cap) {
+            list->cap = list->cap ? list->cap * 2 : 64;
+            list->files =
+                realloc(list->files, list->cap * sizeof(pcache_file_t));
+        }
+        list->files[list->nfiles++] = (pcache_file_t){
+            .path = strdup(child),
+            .size = st.st_size,
+            .mtime = st.st_mtim,
+        };
+        list->total += st.st_size;
+    }
+    closedir(dir);
+}
+
+static int cmp_mtime(const void *a, const void *b) {
+    const struct timespec *x = &((pcache_file_t *)a)->mtime;
+    const struct timespec *y = &((pcache_file_t *)b)->mtime;
+    if (x->tv_sec != y->tv_sec)
+        return x->tv_sec < y->tv_sec ? -1 : 1;
+    return x->tv_nsec < y->tv_nsec ? -1 : x->tv_nsec > y->tv_nsec;
+}
+
+// 整个根目录(包括旧版本)超过上限时, 从最久没用过的文件开始删除
+static void pcache_trim(pcache_t *pc) {
+    file_list_t list = { 0 };
+    collect_files(pc->root, &list);
+
+    qsort(list.files, list.nfiles, sizeof(pcache_file_t), cmp_mtime);
+    for (uint64_t i = 0; i < list.nfiles; i++) {
+        if (list.total > pc->size_cap && unlink(list.files[i].path) == 0)
+            list.total -= list.files[i].size;
+        free(list.files[i].path);
+    }
+    free(list.files);
+}
+
+// 本次运行写入过新文件时才检查大小上限
+void pcache_close(pcache_t *pc) {
+    if (pc->saved)
+        pcache_trim(pc);
+    if (getenv("RVEMU_JIT_STATS"))
+        fprintf(
+            stderr,
+            "pcache: %s, loaded %" PRIu64 ", saved %" PRIu64 "\n",
+            pc->dir,
+            pc->loaded,
+            pc->saved
+        );
+    free(pc);
+}
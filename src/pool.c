@@ -0,0 +1,205 @@
+#include "rvemu.h"
+#include <time.h>
+
+/*
+ * 后台编译线程池
+ *
+ * clang一次编译要几十毫秒, 放在guest线程上会让模拟程序卡住。
+ * machine_promote在guest线程上生成好C代码后交给这里排队,
+ * 由工作线程调用clang并装载进代码缓存, 完成后原子地替换block->jit;
+ * 在此之前guest线程照常解释执行(或跑基线JIT的代码)。
+ *
+ * 工作线程在第一次提交任务时才启动, 短时间运行的程序不会创建线程。
+ */
+
+typedef struct job_t {
+    struct job_t *next;
+    jit_unit_t unit;
+    uint64_t submit_ns;
+} job_t;
+
+struct pool_t {
+    machine_t *machine;
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // 有新任务或要求退出
+    job_t *head;
+    job_t *tail;
+    pthread_t *threads;
+    int nworkers;
+    bool started;
+    bool stop;
+    pool_stats_t stats;
+};
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 编译并装载一个任务, 成功后原子地替换block->jit, 返回是否成功及耗时
+static bool run_job(pool_t *pool, job_t *job, uint64_t *latency) {
+    exec_block_func_t code = machine_compile(pool->machine, &job->unit);
+    if (code)
+        smc_install(pool->machine, &job->unit, code);
+    *latency = now_ns() - job->submit_ns;
+    str_free(&job->unit.source);
+    free(job);
+    return code != NULL;
+}
+
+// 调用方持有pool->lock
+static void record(pool_t *pool, bool ok, uint64_t latency) {
+    if (ok) {
+        pool->stats.compiled++;
+        pool->stats.latency_total_ns += latency;
+        pool->stats.latency_max_ns = MAX(pool->stats.latency_max_ns, latency);
+    } else {
+        pool->stats.failed++;
+    }
+}
+
+static void *worker(void *arg) {
+    pool_t *pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (pool->head == NULL && !pool->stop)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (pool->stop)
+            break;
+
+        job_t *job = pool->head;
+        pool->head = job->next;
+        if (pool->head == NULL)
+            pool->tail = NULL;
+        pool->stats.depth--;
+        pool->stats.busy++;
+        pthread_mutex_unlock(&pool->lock);
+
+        uint64_t latency;
+        bool ok = run_job(pool, job, &latency);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->stats.busy--;
+        record(pool, ok, latency);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+pool_t *new_pool(machine_t *m, int nworkers) {
+    pool_t *pool = calloc(1, sizeof(pool_t));
+    pool->machine = m;
+    pool->nworkers = nworkers;
+    pool->stats.workers = nworkers;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+    return pool;
+}
+
+/*
+ * 提交一个编译任务, unit(包括其中的source)的所有权转交给线程池。
+ * 没有工作线程(RVEMU_JIT_WORKERS=0或单核)时直接在调用线程上编译。
+ */
+void pool_submit(pool_t *pool, jit_unit_t *unit) {
+    job_t *job = calloc(1, sizeof(job_t));
+    job->unit = *unit;
+    job->submit_ns = now_ns();
+    unit->source = (str_t){ 0 };
+
+    pthread_mutex_lock(&pool->lock);
+    // 别的hart正在结束整个guest进程
+    if (pool->stop) {
+        pthread_mutex_unlock(&pool->lock);
+        str_free(&job->unit.source);
+        free(job);
+        return;
+    }
+    pool->stats.submitted++;
+    if (pool->nworkers == 0) {
+        pthread_mutex_unlock(&pool->lock);
+        uint64_t latency;
+        bool ok = run_job(pool, job, &latency);
+        pthread_mutex_lock(&pool->lock);
+        record(pool, ok, latency);
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+
+    if (!pool->started) {
+        pool->threads = calloc(pool->nworkers, sizeof(pthread_t));
+        for (int i = 0; i < pool->nworkers; i++) {
+            if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0)
+                fatal("cannot create jit worker thread");
+        }
+        pool->started = true;
+    }
+
+    if (pool->tail)
+        pool->tail->next = job;
+    else
+        pool->head = job;
+    pool->tail = job;
+    pool->stats.depth++;
+    pool->stats.max_depth = MAX(pool->stats.max_depth, pool->stats.depth);
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+pool_stats_t pool_stats(pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool_stats_t stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+    return stats;
+}
+
+/*
+ * 丢弃还在排队的任务, 等正在编译的任务结束后停止工作线程。
+ * 不等的话进程退出时clang子进程和临时文件会被遗留下来。
+ */
+void pool_shutdown(pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->head) {
+        job_t *job = pool->head;
+        pool->head = job->next;
+        str_free(&job->unit.source);
+        free(job);
+    }
+    pool->tail = NULL;
+    pool->stats.depth = 0;
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pool->started) {
+        for (int i = 0; i < pool->nworkers; i++)
+            pthread_join(pool->threads[i], NULL);
+        free(pool->threads);
+        pool->started = false;
+    }
+}
+
+// 先pool_shutdown
+void pool_free(pool_t *pool) {
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->cond);
+    free(pool);
+}
+
+void pool_print_stats(pool_t *pool, FILE *fp) {
+    pool_stats_t s = pool_stats(pool);
+    fprintf(
+        fp,
+        "jit: workers %d, submitted %" PRIu64 ", compiled %" PRIu64
+        ", failed %" PRIu64 ", queue depth %" PRIu64 " (max %" PRIu64
+        "), latency avg %.1fms max %.1fms\n",
+        s.workers,
+        s.submitted,
+        s.compiled,
+        s.failed,
+        s.depth,
+        s.max_depth,
+        s.compiled ? s.latency_total_ns / 1e6 / s.compiled : 0.0,
+        s.latency_max_ns / 1e6
+    );
+}
@@ -0,0 +1,172 @@
+#include "rvemu.h"
+#include <time.h>
+
+/*
+ * 可执行段的整段预解码
+ *
+ * RVEMU_PREDECODE=1时, 加载ELF之后把只读可执行段里每个2字节对齐的位置都解码一次,
+ * 存进按(pc - base) >> 1索引的inst_t数组, 解不出指令的位置(数据、4字节指令的后半)
+ * 的size为0, 解码用decode_batch(见decode_batch.c)。之后block_build按下标取指令,
+ * 不再逐条解码;
+ * machine_block也先查同样按下标索引的block指针数组, 不在这些段里的pc才查哈希表。
+ * 大的静态链接程序代码段有几MB, 按PREDECODE_CHUNK切开分给多个线程并行解码,
+ * 线程数默认是在线的核数, 可以用RVEMU_PREDECODE_THREADS指定。
+ *
+ * 可写的段内容会变(见smc.c), 不预解码。
+ */
+
+#define PREDECODE_CHUNK (64 * 1024) // 每个线程至少分到的位置数
+#define PREDECODE_BATCH 256         // 每次交给decode_batch的位置数
+
+typedef struct {
+    predecode_seg_t *seg;
+    uint64_t mem; // mmu.mem
+    uint64_t first;
+    uint64_t last;
+    uint64_t decoded;
+} predecode_job_t;
+
+// 成批交给decode_batch, 解不出指令的位置清零
+static void *decode_range(void *arg) {
+    predecode_job_t *job = arg;
+    predecode_seg_t *seg = job->seg;
+    uint64_t mem = job->mem;
+    uint64_t n = (seg->end - seg->base) >> 1;
+    uint32_t words[PREDECODE_BATCH];
+    bool ok[PREDECODE_BATCH];
+
+    // 段的最后一个位置之后只有2字节, 单独处理
+    uint64_t last = MIN(job->last, n - 1);
+    for (uint64_t i = job->first; i < last; i += PREDECODE_BATCH) {
+        uint32_t cnt = MIN(last - i, PREDECODE_BATCH);
+        for (uint32_t k = 0; k < cnt; k++)
+            words[k] = *(uint32_t *)TO_HOST(mem, seg->base + ((i + k) << 1));
+        inst_t *insts = &seg->insts[i];
+        job->decoded += decode_batch(insts, words, cnt, ok);
+        for (uint32_t k = 0; k < cnt; k++) {
+            if (!ok[k])
+                insts[k] = (inst_t){ 0 };
+        }
+    }
+
+    if (job->last == n) {
+        inst_t *inst = &seg->insts[n - 1];
+        uint16_t data = *(uint16_t *)TO_HOST(mem, seg->end - 2);
+        if (decode_try(inst, data) && inst->size == 2) {
+            job->decoded++;
+        } else {
+            *inst = (inst_t){ 0 };
+        }
+    }
+    return NULL;
+}
+
+// 第0块在调用线程上解码, 其余各起一个线程, 返回用了几个线程
+static int decode_segment(predecode_seg_t *seg, uint64_t mem, int nthreads) {
+    uint64_t n = (seg->end - seg->base) >> 1;
+    int njobs = MAX(MIN((uint64_t)nthreads, n / PREDECODE_CHUNK), 1);
+    predecode_job_t *jobs = calloc(njobs, sizeof(predecode_job_t));
+    pthread_t *threads = calloc(njobs, sizeof(pthread_t));
+
+    for (int i = 0; i < njobs; i++) {
+        jobs[i] = (predecode_job_t){
+            .seg = seg,
+            .mem = mem,
+            .first = n * i / njobs,
+            .last = n * (i + 1) / njobs,
+        };
+        if (i > 0 &&
+            pthread_create(&threads[i], NULL, decode_range, &jobs[i]) != 0)
+            fatal("cannot create predecode thread");
+    }
+    decode_range(&jobs[0]);
+
+    for (int i = 1; i < njobs; i++)
+        pthread_join(threads[i], NULL);
+    for (int i = 0; i < njobs; i++)
+        seg->decoded += jobs[i].decoded;
+    free(threads);
+    free(jobs);
+    return njobs;
+}
+
+void predecode_init(machine_t *m) {
+    const char *val = getenv("RVEMU_PREDECODE");
+    if (val == NULL || strcmp(val, "0") == 0 || *val == '\0')
+        return;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if ((val = getenv("RVEMU_PREDECODE_THREADS")))
+        nthreads = strtol(val, NULL, 0);
+    nthreads = MAX(nthreads, 1);
+
+    uint64_t positions = 0, decoded = 0;
+    int used = 0;
+    for (int i = 0; i < m->mmu.nsegs; i++) {
+        mmu_seg_t *s = &m->mmu.segs[i];
+        if (!(s->prot & PROT_EXEC) || (s->prot & PROT_WRITE))
+            continue;
+
+        uint64_t n = (s->end - s->start) >> 1;
+        predecode_seg_t *seg = &m->predecode[m->npredecode++];
+        *seg = (predecode_seg_t){
+            .base = s->start,
+            .end = s->end,
+            .insts = calloc(n, sizeof(inst_t)),
+            .blocks = calloc(n, sizeof(block_t *)),
+        };
+        if (seg->insts == NULL || seg->blocks == NULL)
+            fatal("cannot allocate the predecode arrays");
+        int njobs = decode_segment(seg, m->mmu.mem, nthreads);
+        used = MAX(used, njobs);
+        decoded += seg->decoded;
+        positions += n;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (getenv("RVEMU_JIT_STATS"))
+        fprintf(
+            stderr,
+            "predecode: %" PRIu64 " of %" PRIu64
+            " positions decoded in %.2f ms, %d threads\n",
+            decoded,
+            positions,
+            (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6,
+            used
+        );
+}
+
+// 下标数组里的block同时在哈希表里, 由cache_free释放
+void predecode_free(machine_t *m) {
+    for (int i = 0; i < m->npredecode; i++) {
+        free(m->predecode[i].insts);
+        free(m->predecode[i].blocks);
+    }
+    m->npredecode = 0;
+}
+
+static predecode_seg_t *find_seg(machine_t *m, uint64_t pc) {
+    for (int i = 0; i < m->npredecode; i++) {
+        predecode_seg_t *seg = &m->predecode[i];
+        if (pc >= seg->base && pc < seg->end)
+            return seg;
+    }
+    return NULL;
+}
+
+// pc处预解码好的指令, 不在预解码的段里或解不出指令时返回NULL
+inst_t *predecode_inst(machine_t *m, uint64_t pc) {
+    predecode_seg_t *seg = find_seg(m, pc);
+    if (seg == NULL)
+        return NULL;
+    inst_t *inst = &seg->insts[(pc - seg->base) >> 1];
+    return inst->size ? inst : NULL;
+}
+
+// 以pc开头的block在下标数组里的位置, 不在预解码的段里时返回NULL
+block_t **predecode_block(machine_t *m, uint64_t pc) {
+    predecode_seg_t *seg = find_seg(m, pc);
+    return seg ? &seg->blocks[(pc - seg->base) >> 1] : NULL;
+}
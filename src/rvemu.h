@@ -7,6 +7,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -20,7 +21,9 @@
 #include <unistd.h>
 
 #include "elfdef.h"
+#include "isa.h"
 #include "regs.h"
+#include "str.h"
 #include "types.h"
 
 #define fatalf(fmt, ...)                                                       \
@@ -38,160 +41,59 @@
 
 // 被模拟程序的地址可由2种addr表示：
 // 自己希望加载的地址(GUEST_ADDR)和实际在rvemu进程中被存放的地址(HOST_ADDR)
+// 每个machine的guest内存在宿主上各占一段, mem是guest地址0对应的宿主地址
+// (mmu_t和state_t里各有一份, 见mmu.c)
 // TO_HOST：GUEST_ADDR转HOST_ADDR
 // TO_GUEST：HOST_ADDR转GUEST_ADDR
-#define GUEST_MEMORY_OFFSET 0x088800000000ULL
-#define TO_HOST(addr) (addr + GUEST_MEMORY_OFFSET)
-#define TO_GUEST(addr) (addr - GUEST_MEMORY_OFFSET)
+#define TO_HOST(mem, addr) ((mem) + (addr))
+#define TO_GUEST(mem, addr) ((addr) - (mem))
 
 #define FORCE_INLINE inline __attribute__((always_inline))
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
 
+/*
+ * 操作数特化的指令变体, X(变体, 原指令)
+ * 语义与原指令完全相同, 只是某个操作数是x0或0, 处理函数不必读寄存器或做加法。
+ * 解码时不产生, 由block优化最后一步选用(见opt.c的specialize);
+ * 解释器的处理函数由interp.c中各FUNC宏族生成, JIT按inst_generic()还原成原指令。
+ * - mv: addi rd, rs, 0
+ * - ret: jalr x0, 0(ra)
+ * - l*_0: 偏移为0的load, l*_abs: 基址为x0(常量传播得到的绝对地址)的load
+ * - b*z: 与x0比较的分支, bgtz/blez是x0在左边的blt/bge
+ */
+// clang-format off
+#define SPECIAL_LIST(X)                                                        \
+    X(mv, addi) X(ret, jr)                                                     \
+    X(lb_0, lb) X(lh_0, lh) X(lw_0, lw) X(ld_0, ld) X(lbu_0, lbu)              \
+    X(lhu_0, lhu) X(lwu_0, lwu)                                                \
+    X(lb_abs, lb) X(lh_abs, lh) X(lw_abs, lw) X(ld_abs, ld) X(lbu_abs, lbu)    \
+    X(lhu_abs, lhu) X(lwu_abs, lwu)                                            \
+    X(beqz, beq) X(bnez, bne) X(bltz, blt) X(bgez, bge) X(bgtz, blt)           \
+    X(blez, bge)
+// clang-format on
+
 enum inst_type_t {
-    inst_lb,        // 从内存地址(rs1+imm)加载8位有符号数到rd，符号扩展到XLEN
-    inst_lh,        // 加载16位有符号数到rd，符号扩展到XLEN
-    inst_lw,        // 加载32位有符号数到rd，符号扩展到XLEN
-    inst_ld,        // 加载64位数据到rd
-    inst_lbu,       // 加载8位无符号数到rd，零扩展到XLEN
-    inst_lhu,       // 加载16位无符号数到rd，零扩展到XLEN
-    inst_lwu,       // 加载32位无符号数到rd，零扩展到64位
-    inst_fence,     // 内存屏障，约束内存读写的可见顺序
-    inst_fence_i,   // 指令缓存同步，确保后续能看到已修改的指令
-    inst_addi,      // rd = rs1 + imm
-    inst_slli,      // rd = rs1 << shamt，逻辑左移
-    inst_slti,      // rd = (rs1 < imm)? 1 : 0（有符号比较）
-    inst_sltiu,     // rd = (rs1 < imm)? 1 : 0（无符号比较）
-    inst_xori,      // rd = rs1 ^ imm
-    inst_srli,      // rd = rs1 >> shamt，逻辑右移
-    inst_srai,      // rd = rs1 >> shamt，算术右移（保留符号）
-    inst_ori,       // rd = rs1 | imm
-    inst_andi,      // rd = rs1 & imm
-    inst_auipc,     // rd = pc + (imm << 12)
-    inst_addiw,     // rd = signext32(rs1 + imm)
-    inst_slliw,     // rd = signext32((uint32)rs1 << shamt)
-    inst_srliw,     // rd = signext32((uint32)rs1 >> shamt)
-    inst_sraiw,     // rd = signext32((int32)rs1 >> shamt)，算术右移
-    inst_sb,        // 将rs2低8位写入内存[rs1+imm]
-    inst_sh,        // 将rs2低16位写入内存[rs1+imm]
-    inst_sw,        // 将rs2低32位写入内存[rs1+imm]
-    inst_sd,        // 将rs2的64位写入内存[rs1+imm]
-    inst_add,       // rd = rs1 + rs2
-    inst_sll,       // rd = rs1 << (rs2低5/6位)，逻辑左移
-    inst_slt,       // rd = (rs1 < rs2)? 1 : 0（有符号比较）
-    inst_sltu,      // rd = (rs1 < rs2)? 1 : 0（无符号比较）
-    inst_xor,       // rd = rs1 ^ rs2
-    inst_srl,       // rd = rs1 >> (rs2低5/6位)，逻辑右移
-    inst_or,        // rd = rs1 | rs2
-    inst_and,       // rd = rs1 & rs2
-    inst_mul,       // rd = (rs1 * rs2) 的低XLEN位
-    inst_mulh,      // rd = (有符号×有符号)乘积的高XLEN位
-    inst_mulhsu,    // rd = (有符号×无符号)乘积的高XLEN位
-    inst_mulhu,     // rd = (无符号×无符号)乘积的高XLEN位
-    inst_div,       // rd = rs1 / rs2（有符号）
-    inst_divu,      // rd = rs1 / rs2（无符号）
-    inst_rem,       // rd = rs1 % rs2（有符号）
-    inst_remu,      // rd = rs1 % rs2（无符号）
-    inst_sub,       // rd = rs1 - rs2
-    inst_sra,       // rd = rs1 >> (rs2低5/6位)，算术右移
-    inst_lui,       // rd = imm << 12
-    inst_addw,      // rd = signext32((int32)rs1 + (int32)rs2)
-    inst_sllw,      // rd = signext32((uint32)rs1 << (rs2低5位))
-    inst_srlw,      // rd = signext32((uint32)rs1 >> (rs2低5位))
-    inst_mulw,      // rd = signext32((int32)rs1 * (int32)rs2)
-    inst_divw,      // rd = signext32((int32)rs1 / (int32)rs2)
-    inst_divuw,     // rd = signext32((uint32)rs1 / (uint32)rs2)
-    inst_remw,      // rd = signext32((int32)rs1 % (int32)rs2)
-    inst_remuw,     // rd = signext32((uint32)rs1 % (uint32)rs2)
-    inst_subw,      // rd = signext32((int32)rs1 - (int32)rs2)
-    inst_sraw,      // rd = signext32((int32)rs1 >> (rs2低5位))，算术右移
-    inst_beq,       // 若rs1==rs2，则pc += imm（相对跳转）
-    inst_bne,       // 若rs1!=rs2，则pc += imm
-    inst_blt,       // 若rs1<rs2（有符号），则pc += imm
-    inst_bge,       // 若rs1>=rs2（有符号），则pc += imm
-    inst_bltu,      // 若rs1<rs2（无符号），则pc += imm
-    inst_bgeu,      // 若rs1>=rs2（无符号），则pc += imm
-    inst_jalr,      // rd=pc+4；pc=(rs1+imm)&~1（间接跳转并链接）
-    inst_jal,       // rd=pc+4；pc=pc+imm（直接跳转并链接）
-    inst_ecall,     // 环境调用，陷入到系统以执行syscall
-    inst_csrrc,     // rd=CSR；CSR &= ~rs1（原子清位）
-    inst_csrrci,    // rd=CSR；CSR &= ~zimm（立即数清位）
-    inst_csrrs,     // rd=CSR；CSR |= rs1（原子置位）
-    inst_csrrsi,    // rd=CSR；CSR |= zimm（立即数置位）
-    inst_csrrw,     // rd=CSR；CSR = rs1（原子读写）
-    inst_csrrwi,    // rd=CSR；CSR = zimm（立即数读写）
-    inst_flw,       // 从内存加载32位到浮点寄存器（单精度）
-    inst_fsw,       // 将浮点寄存器32位写入内存（单精度）
-    inst_fmadd_s,   // 单精度FMA：(rs1*rs2)+rs3
-    inst_fmsub_s,   // 单精度FMA：(rs1*rs2)-rs3
-    inst_fnmsub_s,  // 单精度FMA：-(rs1*rs2)-rs3
-    inst_fnmadd_s,  // 单精度FMA：-(rs1*rs2)+rs3
-    inst_fadd_s,    // 单精度浮点加法
-    inst_fsub_s,    // 单精度浮点减法
-    inst_fmul_s,    // 单精度浮点乘法
-    inst_fdiv_s,    // 单精度浮点除法
-    inst_fsqrt_s,   // 单精度平方根
-    inst_fsgnj_s,   // 单精度符号注入：rd=带rs2符号的rs1
-    inst_fsgnjn_s,  // 单精度符号取反注入：rd=带(~rs2符号)的rs1
-    inst_fsgnjx_s,  // 单精度符号异或：rd符号=rs1与rs2符号异或
-    inst_fmin_s,    // 单精度最小值
-    inst_fmax_s,    // 单精度最大值
-    inst_fcvt_w_s,  // 单精度转32位有符号整数
-    inst_fcvt_wu_s, // 单精度转32位无符号整数
-    inst_fmv_x_w,   // 将单精度位模式移动到整数寄存器（不做数值转换）
-    inst_feq_s,     // 单精度比较：相等返回1，否则0
-    inst_flt_s,     // 单精度比较：小于返回1，否则0
-    inst_fle_s,     // 单精度比较：小于等于返回1，否则0
-    inst_fclass_s,  // 单精度分类，返回类别位掩码
-    inst_fcvt_s_w,  // 32位有符号整数转单精度
-    inst_fcvt_s_wu, // 32位无符号整数转单精度
-    inst_fmv_w_x,   // 将整数位模式移动到单精度寄存器（不做数值转换）
-    inst_fcvt_l_s,  // 单精度转64位有符号整数
-    inst_fcvt_lu_s, // 单精度转64位无符号整数
-    inst_fcvt_s_l,  // 64位有符号整数转单精度
-    inst_fcvt_s_lu, // 64位无符号整数转单精度
-    inst_fld,       // 从内存加载64位到浮点寄存器（双精度）
-    inst_fsd,       // 将浮点寄存器64位写入内存（双精度）
-    inst_fmadd_d,   // 双精度FMA：(rs1*rs2)+rs3
-    inst_fmsub_d,   // 双精度FMA：(rs1*rs2)-rs3
-    inst_fnmsub_d,  // 双精度FMA：-(rs1*rs2)-rs3
-    inst_fnmadd_d,  // 双精度FMA：-(rs1*rs2)+rs3
-    inst_fadd_d,    // 双精度浮点加法
-    inst_fsub_d,    // 双精度浮点减法
-    inst_fmul_d,    // 双精度浮点乘法
-    inst_fdiv_d,    // 双精度浮点除法
-    inst_fsqrt_d,   // 双精度平方根
-    inst_fsgnj_d,   // 双精度符号注入
-    inst_fsgnjn_d,  // 双精度符号取反注入
-    inst_fsgnjx_d,  // 双精度符号异或注入
-    inst_fmin_d,    // 双精度最小值
-    inst_fmax_d,    // 双精度最大值
-    inst_fcvt_s_d,  // 双精度转单精度
-    inst_fcvt_d_s,  // 单精度转双精度
-    inst_feq_d,     // 双精度比较：相等返回1，否则0
-    inst_flt_d,     // 双精度比较：小于返回1，否则0
-    inst_fle_d,     // 双精度比较：小于等于返回1，否则0
-    inst_fclass_d,  // 双精度分类，返回类别位掩码
-    inst_fcvt_w_d,  // 双精度转32位有符号整数
-    inst_fcvt_wu_d, // 双精度转32位无符号整数
-    inst_fcvt_d_w,  // 32位有符号整数转双精度
-    inst_fcvt_d_wu, // 32位无符号整数转双精度
-    inst_fcvt_l_d,  // 双精度转64位有符号整数
-    inst_fcvt_lu_d, // 双精度转64位无符号整数
-    inst_fmv_x_d,   // 将双精度位模式移动到整数寄存器（不做数值转换）
-    inst_fcvt_d_l,  // 64位有符号整数转双精度
-    inst_fcvt_d_lu, // 64位无符号整数转双精度
-    inst_fmv_d_x,   // 将整数位模式移动到双精度寄存器（不做数值转换）
+#define X(name, ...) inst_##name,
+    ISA_LIST(X) // 对应编码的指令, 见isa.h
+#undef X
+    inst_nop,       // 空操作, 只由block优化产生(见opt.c), 不对应任何编码
+    inst_j,         // rd为x0的jal, 不写rd(见opt.c)
+    inst_jr,        // rd为x0的jalr, 不写rd
+    // 融合指令(macro-op fusion), 由block优化把相邻两条指令合成一条(见opt.c)
+    inst_slli_srli, // slli+srli, 零扩展/取位段, 第二个移位数在csr字段
+    inst_slli_add,  // slli+add, 数组下标换算: rd = rs2 + (rs1 << imm)
+    inst_addi_bne,  // addi+bne, 循环计数: addi的立即数在csr字段, imm是跳转偏移
+    inst_addi_blt,  // addi+blt
+    inst_addi_bltu, // addi+bltu
+#define X(name, base) inst_##name,
+    SPECIAL_LIST(X)
+#undef X
     num_insns,      // 指令数量计数器（非指令）
 
     /*
      * 未添加的指令/扩展说明：
      *
-     * - A（原子指令扩展）：
-     *   lr.w/lr.d, sc.w/sc.d, amoadd.w/d, amoswap.w/d, amoxor.w/d,
-     *   amoor.w/d, amomin.w/d, amomax.w/d, amominu.w/d, amomaxu.w/d 等。
-     *   说明：当前未在枚举中列出，属于原子内存操作，通常用于并发同步。
-     *
      * - 特权指令（Privileged）：
      *   ebreak, uret/sret/mret, wfi, sfence.vma 等。
      *   说明：本工程以用户态程序为主，这些指令涉及特权级控制与页表维护，未纳入枚举。
@@ -205,14 +107,21 @@ enum inst_type_t {
      *   说明：这些为常用的性能优化/位运算指令，未在此枚举中出现。
      *
      * - C（压缩指令）：
-     *   压缩形式未作为独立枚举项列出，decode 时通过 `inst_t.rvc` 标识压缩形式，
+     *   压缩形式未作为独立枚举项列出，解码结果的 `inst_t.size` 为2，
      *   与对应非压缩指令共享语义（如 c.add 映射到 add）。
      *
-     * 若后续需要支持上述扩展，请在此枚举与解码/执行路径中补充对应指令并实现。
+     * 若后续需要支持上述扩展，在isa.h中加上编码，再在interp.c中实现处理函数。
      */
 
 };
 
+// 按inst_type_t的顺序列出所有指令, 用于生成funcs[]等按指令类型索引的表。
+// X的参数同ISA_LIST, 只有第一个参数(名字)对所有指令都有, 应定义成X(name, ...)
+#define INST_LIST(X)                                                           \
+    ISA_LIST(X)                                                                \
+    X(nop) X(j) X(jr) X(slli_srli) X(slli_add) X(addi_bne) X(addi_blt)         \
+    X(addi_bltu)
+
 // RISC-V
 // 指令格式最多只会有一个目标寄存器（rd）、两个源寄存器（rs1、rs2）、和一个立即数（imm）
 //
@@ -222,20 +131,31 @@ enum inst_type_t {
 // - S 型指令：有 rs1、rs2、imm，没有 rd。
 // - B 型指令：有 rs1、rs2、imm，没有 rd。
 // - U/J 型指令：有 rd、imm，没有 rs1、rs2。
+//
+// 解码结果也是block里逐条执行的记录, 压到8字节, 一条cache line放8条。
+// 少见的字段与imm共用空间: csr指令和乘加指令都没有立即数,
+// 融合指令(见opt.c)的两个立即数各占16位。
 typedef struct {
-    int8_t rd;  // destination register，
-    int8_t rs1; // source register 1
-    int8_t rs2; // source register 2
-    int8_t rs3;
-    int32_t imm; // 立即数
-    int16_t csr; // 字段代表 Control and Status Register （控制与状态寄存器）。
-    enum inst_type_t type;
-    bool rvc; // RISC-V Compressed 压缩指令
-    bool
-        continue_exec; // 目前主要处理syscall,
-                       // 当遇到continue_exec标识符时,跳出内层循环,到外部循环处理syscall
+    union {
+        int32_t imm; // 立即数
+        int16_t csr; // 字段代表 Control and Status Register （控制与状态寄存器）。
+        int8_t rs3;  // 乘加指令的第三个源寄存器
+        struct {
+            int16_t imm1; // 融合指令中第一条的立即数
+            int16_t imm2; // 融合指令中第二条的立即数, 跳转偏移相对于第一条的pc
+        };
+    };
+    enum inst_type_t type : 8; // 同时是funcs[]等处理函数表的下标
+    uint32_t size : 8; // 执行完pc前进的字节数, 被优化掉的指令并入前一条(见opt.c)
+    uint32_t rd : 5;   // destination register，
+    uint32_t rs1 : 5;  // source register 1
+    uint32_t rs2 : 5;  // source register 2
+    uint32_t continue_exec : 1; // 分支/跳转/syscall, 执行后离开block
 } inst_t;
 
+_Static_assert(num_insns < 256, "inst_t.type has 8 bits");
+_Static_assert(sizeof(inst_t) == 8, "inst_t must stay 8 bytes");
+
 // clang-format off
 /*
  * mmu.c
@@ -244,7 +164,19 @@ typedef struct {
  *                         ^ 此处为base, 恒定值                      ^ 此处为被模拟进程的栈底
  **/
 // clang-format on
+#define MMU_MAX_SEGS 16
+
+// 一个PT_LOAD段按页对齐后的guest地址范围, 以及映射时的权限
 typedef struct {
+    uint64_t start;
+    uint64_t end;
+    int prot;
+} mmu_seg_t;
+
+#define MMU_GUEST_SPACE (1ULL << 36) // 每个machine预留的guest地址空间
+
+typedef struct {
+    uint64_t mem; // guest地址0对应的宿主地址, 预留了MMU_GUEST_SPACE字节
     uint64_t entry;
     uint64_t
         host_alloc; // ELF 占用区结束位置(malloc动态内存之前)，会随着malloc变化,
@@ -254,24 +186,60 @@ typedef struct {
                      // 不一定对齐page size
     uint64_t
         base; // 永远指向最初的ELF占用区结束位置（不包含堆内存）,在程序加载完毕后不再变动
+    mmu_seg_t segs[MMU_MAX_SEGS]; // 已加载的PT_LOAD段, 按加载顺序
+    int nsegs;
 } mmu_t;
 
-void mmu_load_elf(mmu_t *, int);
+/*
+ * 打开并解析好的ELF: 入口和所有PT_LOAD段, 文件一直开着。
+ * 同一个程序的多个machine都从它映射, 不必各自重新读文件(见batch.c)
+ */
+typedef struct {
+    int fd;
+    uint64_t entry;
+    elf64_phdr_t phdrs[MMU_MAX_SEGS]; // PT_LOAD段, 按文件中的顺序
+    int nphdrs;
+} elf_image_t;
+
+void elf_image_open(elf_image_t *, const char *);
+void elf_image_close(elf_image_t *);
+void mmu_load_elf(mmu_t *, elf_image_t *);
+void mmu_free(mmu_t *);
 uint64_t mmu_alloc(mmu_t *, int64_t);
-inline void mmu_write(uint64_t guest_addr, uint8_t *data, size_t len) {
-    memcpy((void *)TO_HOST(guest_addr), (void *)data, len);
+int mmu_prot(mmu_t *, uint64_t);
+inline void
+mmu_write(mmu_t *mmu, uint64_t guest_addr, uint8_t *data, size_t len) {
+    memcpy((void *)TO_HOST(mmu->mem, guest_addr), (void *)data, len);
 }
 
 /*
  * decode.c
  **/
+// isa.h中一条指令的编码和操作数, 不对应编码的指令(nop、融合指令等)mask为0
+typedef struct {
+    uint32_t mask;
+    uint32_t match;
+    uint8_t format;            // enum isa_format_t
+    uint8_t rd, rs1, rs2, rs3; // enum isa_operand_t
+    uint8_t flags;
+} isa_info_t;
+
+extern const isa_info_t isa_info[num_insns];
+
+bool decode_try(inst_t *, uint32_t);
 void decode_inst(inst_t *, uint32_t);
 
+/*
+ * decode_batch.c
+ **/
+uint32_t decode_batch(inst_t *, const uint32_t *, uint32_t, bool *);
+
 enum exit_reason_t {
     none,
     direct_branch,
     indirect_branch,
-    ecall, // riscv通过ecall触发syscall
+    ecall,   // riscv通过ecall触发syscall
+    fence_i, // fence.i之后的指令要按改写后的内存重新取指
 };
 
 enum csr_t {
@@ -283,43 +251,378 @@ enum csr_t {
 /*
  * state.c
  **/
-typedef struct {
+#define RAS_SIZE 16 // 返回地址栈深度, 溢出时覆盖最老的一项
+
+typedef struct state_t {
     enum exit_reason_t exit_reason;
     uint64_t reenter_pc;           // block切换时,下一个block的起始pc
+    uint64_t mem; // 所属machine的mmu.mem, 访存的处理函数和JIT代码都按它换算
+    const bool *exiting; // 所属machine的exiting, 不回machine_step的循环也要检查
     uint64_t gp_regs[num_gp_regs]; // 32个通用寄存器
     fp_reg_t fp_regs[num_fp_regs]; // 32个浮点寄存器
     uint64_t pc;
+    struct block_t *ras[RAS_SIZE]; // 发起调用的block, 返回时跳到它的end_pc
+    uint32_t ras_top;
+    bool reserved;        // lr建立的保留还有效, 见interp.c的sc
+    uint64_t reserve_addr;
+    uint64_t reserve_val; // lr读到的值, sc按它比较交换
+    uint64_t tid;         // guest看到的线程号
+    uint64_t clear_child_tid; // 线程退出时清零并唤醒等待者的地址, 0表示没有
+    bool halted;              // 这个hart调用了exit, 见machine_run
+    uint64_t icount;          // 执行过的guest指令数, 每进入一个block加一次
+    pthread_t thread;         // 运行这个hart的宿主线程
+    struct state_t *next;     // machine的hart链表
 } state_t;
 
+typedef void(func_t)(state_t *, inst_t *);
+typedef struct block_t *(*exec_block_func_t)(state_t *);
+
+/*
+ * cache.c
+ * 基本块缓存: guest pc -> 预解码好的基本块
+ * 基本块从pc开始, 到第一条分支/jal/jalr/ecall(即continue_exec的指令)结束,
+ * 只在第一次执行到时解码一次, 之后每次执行都直接复用
+ **/
+#define BLOCK_MAX_INSTS 256 // 单个block最多包含的指令数
+#define BLOCK_ALIGN 64      // block按cache line对齐, insts[]从新的一行开始
+
+#define BLOCK_IBTC_SIZE 4 // 每个jalr记住的最近几个跳转目标
+
+// 分层执行: 冷代码解释执行, 温热的block用模板翻译, 最热的交给clang -O3
+enum tier_t {
+    tier_interp,
+    tier_baseline,
+    tier_opt,
+};
+
+typedef struct {
+    uint64_t pc;
+    struct block_t *block;
+} ibtc_entry_t;
+
+typedef struct block_t {
+    uint64_t pc;     // block第一条指令的pc
+    uint64_t end_pc; // block最后一条指令之后的pc, 即不跳转时的下一个block
+    struct block_t *succ[2]; // 已链接的后继block: [0]跳转目标, [1]end_pc
+    ibtc_entry_t ibtc[BLOCK_IBTC_SIZE]; // 末尾jalr的目标缓存
+    uint32_t ibtc_next;                 // ibtc满时下一个被替换的项
+    uint32_t len;            // block内的指令数
+    uint32_t ninsts;         // 优化之前的guest指令数, 用于统计icount
+    bool stale;              // 代码所在的页被改写过, 已移出缓存
+    uint64_t hot;       // 执行次数, 达到next_tier后由machine_step提升一层
+    uint64_t next_tier; // 下一次提升的执行次数, 已在最高层时为UINT64_MAX
+    enum tier_t tier;   // 当前所在的层
+    uint64_t taken;   // 末尾直接跳转实际跳转的次数, 用于选择superblock路径
+    bool loop_header; // 是某个向后跳转的目标, 编译时以它为入口构造superblock
+    exec_block_func_t jit; // 基线JIT或clang编译出的本地代码, 未编译时为NULL
+    uint64_t jit_lo, jit_hi; // jit内联了的guest代码范围, superblock包括整条路径
+    uint32_t gen; // jit_lo/jit_hi里的代码失效时加一, 后台编译的代码按此丢弃
+    // 按type查funcs[]分发, 末尾额外有一个type为num_insns的哨兵项,
+    // 线索化分发时对应出口
+    inst_t insts[] __attribute__((aligned(BLOCK_ALIGN)));
+} block_t;
+
+/*
+ * hot/taken由所有hart不加锁地累加。原子读写避免数据竞争,
+ * 但不用带lock前缀的加法: 每个block入口都要加一次,
+ * 计数只用来决定何时提升, 并发时偶尔少数一次无妨。
+ */
+static inline uint64_t block_count(uint64_t *counter) {
+    uint64_t n = __atomic_load_n(counter, __ATOMIC_RELAXED) + 1;
+    __atomic_store_n(counter, n, __ATOMIC_RELAXED);
+    return n;
+}
+
+
+typedef struct {
+    uint64_t pc;
+    block_t *block;
+} cache_entry_t;
+
+#define TIER_BASELINE_COUNT 1000 // 默认提升到基线JIT的执行次数
+#define TIER_OPT_COUNT 100000    // 默认提升到clang -O3的执行次数
+#define TRACE_MAX_BLOCKS 16 // 一个superblock最多串起的block数
+
+typedef struct {
+    cache_entry_t *table; // 开放寻址的哈希表, 容量恒为2的幂
+    uint64_t capacity;
+    uint64_t size;
+    uint8_t *jitcode; // 可执行的代码缓存, 存放JIT编译出的本地代码
+    uint64_t offset;  // jitcode中已使用的字节数
+    pthread_mutex_t code_lock; // 后台编译线程也会分配jitcode
+} cache_t;
+
+cache_t *new_cache();
+void cache_free(cache_t *);
+block_t *cache_lookup(cache_t *, uint64_t);
+void cache_add(cache_t *, block_t *);
+void cache_remove(cache_t *, uint64_t);
+uint8_t *cache_alloc_code(cache_t *, uint64_t);
+
+/*
+ * trace.c
+ **/
+enum trace_cat_t {
+    trace_load = 1 << 0,    // load: reg是rd, a是地址, b是读到的值
+    trace_alu = 1 << 1,     // 整数运算写回: reg是rd, a是结果
+    trace_jump = 1 << 2,    // 间接跳转: reg是rs1, a是rs1的值, b是目标
+    trace_syscall = 1 << 3, // 系统调用: a是编号, b是a0
+};
+
+typedef struct {
+    uint64_t pc;
+    uint64_t a;
+    uint64_t b;
+    uint32_t cat; // enum trace_cat_t
+    uint32_t reg;
+} trace_rec_t;
+
+#ifdef TRACE
+extern uint32_t trace_mask; // 运行时开启的类别
+// 本线程执行的不是guest真正的指令(见opt.c的eval), 探针不产生记录
+extern __thread bool trace_suppress;
+void trace_init(void);
+void trace_record(enum trace_cat_t, uint64_t, uint32_t, uint64_t, uint64_t);
+#define TRACE_PROBE(cat, pc, reg, a, b)                                        \
+    do {                                                                       \
+        if (__builtin_expect(trace_mask & (cat), 0) && !trace_suppress)        \
+            trace_record(cat, pc, reg, a, b);                                  \
+    } while (0)
+#else
+#define TRACE_PROBE(cat, pc, reg, a, b) ((void)0)
+#endif
+
 /*
  * interp.c
  **/
-void exec_block_interp(state_t *state);
+typedef struct machine_t machine_t;
+
+block_t *block_build(machine_t *, uint64_t pc);
+extern func_t *const funcs[num_insns];
+block_t **block_exit_slot(state_t *state, block_t *block);
+block_t **exec_block_interp(state_t *state, block_t *block);
+
+/*
+ * opt.c
+ **/
+#define NUM_REGS (num_gp_regs + num_fp_regs) // 统一编号, 32及以上为浮点寄存器
+
+// 指令写的寄存器和读的寄存器, 没有时为-1; 写x0视为不写
+typedef struct {
+    int rd;
+    int rs[3];
+} inst_regs_t;
+
+inst_regs_t inst_regs(inst_t *inst);
+bool inst_is_pure(enum inst_type_t type);
+uint32_t block_optimize(uint64_t pc, inst_t *insts, uint32_t len);
+
+// 操作数特化的变体对应的原指令, 其它指令返回自身
+static inline enum inst_type_t inst_generic(enum inst_type_t type) {
+    switch (type) {
+#define X(name, base)                                                          \
+    case inst_##name:                                                          \
+        return inst_##base;
+        SPECIAL_LIST(X)
+#undef X
+    default:
+        return type;
+    }
+}
+
+// 无条件离开block的指令, 执行引擎不必在它后面生成顺序执行的出口
+static inline bool inst_is_jump(enum inst_type_t type) {
+    type = inst_generic(type);
+    return type == inst_jal || type == inst_jalr || type == inst_j ||
+           type == inst_jr || type == inst_ecall || type == inst_fence_i;
+}
+
+// 分支/jal/j的跳转目标相对于本条指令pc的偏移, 融合的分支在imm2里
+static inline int32_t inst_target_offset(inst_t *inst) {
+    if (inst->type >= inst_addi_bne && inst->type <= inst_addi_bltu)
+        return inst->imm2;
+    return inst->imm;
+}
 
 /*
- * machine.c
+ * codegen.c
+ **/
+// 生成的一段C代码, 以及代码里blocks[]表依次对应的block
+typedef struct {
+    str_t source;
+    uint32_t nblocks;
+    block_t *blocks[TRACE_MAX_BLOCKS];
+    uint32_t gen; // 生成时blocks[0]->gen, 装载前核对
+} jit_unit_t;
+
+bool machine_genblock(machine_t *, block_t *, jit_unit_t *);
+
+/*
+ * compile.c
+ **/
+exec_block_func_t machine_compile(machine_t *, jit_unit_t *);
+exec_block_func_t
+machine_load_object(machine_t *, uint8_t *, size_t, block_t **, uint32_t);
+
+/*
+ * baseline.c
+ **/
+exec_block_func_t machine_baseline(machine_t *, block_t *);
+
+/*
+ * pool.c
  **/
 typedef struct {
+    int workers;               // 工作线程数, 0表示在guest线程上同步编译
+    uint64_t submitted;        // 提交的任务数
+    uint64_t compiled;         // 编译并装载成功的任务数
+    uint64_t failed;           // 编译或装载失败的任务数
+    uint64_t busy;             // 正在编译的任务数
+    uint64_t depth;            // 当前排队的任务数
+    uint64_t max_depth;        // 排队任务数的峰值
+    uint64_t latency_total_ns; // 成功任务从提交到可执行的总耗时
+    uint64_t latency_max_ns;
+} pool_stats_t;
+
+typedef struct pool_t pool_t;
+pool_t *new_pool(machine_t *, int);
+void pool_free(pool_t *);
+void pool_submit(pool_t *, jit_unit_t *);
+pool_stats_t pool_stats(pool_t *);
+void pool_shutdown(pool_t *);
+void pool_print_stats(pool_t *, FILE *);
+
+/*
+ * pcache.c
+ **/
+typedef struct pcache_t pcache_t;
+pcache_t *pcache_open(const char *);
+void pcache_load(pcache_t *, machine_t *);
+void pcache_save(pcache_t *, block_t **, uint32_t, uint8_t *, size_t);
+void pcache_close(pcache_t *);
+
+/*
+ * smc.c
+ **/
+enum {
+    smc_writable,
+    smc_protected,
+    smc_busy, // 有线程正在mprotect这一页
+};
+
+typedef struct {
+    uint64_t page;  // guest页地址
+    uint32_t state; // 原子访问, 信号处理函数也会修改
+    bool pending;   // 写保护触发过, 页上的block还没失效
+} smc_page_t;
+
+// 开放寻址, 容量恒为2的幂; 页记录单独分配, 扩容时不会移动
+typedef struct smc_table_t {
+    struct smc_table_t *retired; // 扩容换下来的旧表, smc_free时才释放
+    uint64_t capacity;
+    smc_page_t *slots[]; // NULL表示空位
+} smc_table_t;
+
+typedef struct {
+    bool enabled; // RVEMU_SMC=0时不写保护, 只在fence.i时清空整个缓存
+    uint64_t page_size;
+    smc_table_t *table; // 装过代码的可写页, 查找不加锁, 插入持有machine->lock
+    uint64_t size;
+    uint64_t pending;     // pending的页数, 不为0时machine_step调用smc_drain
+    pthread_mutex_t lock; // 失效与后台线程装载jit代码互斥
+    uint64_t faults;      // 写保护触发的次数
+    uint64_t invalidated; // 移出缓存的block数
+} smc_t;
+
+void smc_init(machine_t *);
+void smc_attach(machine_t *);
+void smc_free(machine_t *);
+void smc_protect(machine_t *, block_t *);
+void smc_flush(machine_t *, uint64_t, uint64_t);
+void smc_drain(machine_t *);
+void smc_fence_i(machine_t *);
+void smc_cover(block_t **, uint32_t);
+bool smc_install(machine_t *, jit_unit_t *, exec_block_func_t);
+bool smc_immutable(machine_t *, block_t **, uint32_t);
+
+/*
+ * predecode.c
+ **/
+typedef struct {
+    uint64_t base; // 段的guest地址范围, 页对齐
+    uint64_t end;
+    inst_t *insts;    // 下标为(pc - base) >> 1, 解不出指令的位置size为0
+    block_t **blocks; // 同样的下标, 以该pc开头的block
+    uint64_t decoded; // 解出指令的位置数
+} predecode_seg_t;
+
+void predecode_init(machine_t *);
+void predecode_free(machine_t *);
+inst_t *predecode_inst(machine_t *, uint64_t);
+block_t **predecode_block(machine_t *, uint64_t);
+
+/*
+ * machine.c
+ **/
+#define MACHINE_MAX_FDS 256 // guest能同时打开的文件数
+
+/*
+ * 一个guest进程。每个guest线程(hart)有自己的state_t, 主线程的就是这里的state,
+ * clone出的hart各自分配; 内存、block缓存和编译线程池由所有hart共享。
+ * machine之间没有共享的可变状态, 一个宿主进程里可以同时运行多个machine,
+ * 各自在自己的线程上调用machine_run。
+ */
+struct machine_t {
     state_t state;
     mmu_t mmu;
-} machine_t;
+    cache_t *cache;
+    smc_t smc;
+    predecode_seg_t predecode[MMU_MAX_SEGS]; // RVEMU_PREDECODE开启时的只读可执行段
+    int npredecode;
+    uint64_t baseline_threshold; // 提升到基线JIT的执行次数, UINT64_MAX表示关闭
+    uint64_t opt_threshold;      // 提升到clang -O3的执行次数, 同上
+    pool_t *pool;                // 后台编译线程池
+    pcache_t *pcache;            // 程序的磁盘翻译缓存, 未启用时为NULL
+    pthread_mutex_t lock; // 多个hart查表建block、提升层级、让代码失效时互斥
+    uint32_t harts;       // 还在运行的hart数, 以下几项都由lock保护
+    uint64_t next_tid;    // 下一个clone出的hart的线程号
+    state_t *hart_list;    // 正在运行的hart, 经由state->next串起
+    pthread_cond_t halted; // 有hart结束
+    bool exiting;          // 调用过exit_group, 所有hart都要停下
+    int exit_code;
+    uint64_t icount;       // 已经结束的hart执行过的指令数之和
+    int fds[MACHINE_MAX_FDS]; // guest fd对应的宿主fd(close-on-exec), -1表示没有
+};
 
-FORCE_INLINE uint64_t machine_get_gp_reg(machine_t *m, int32_t reg) {
-    assert(reg >= 0 && reg < num_gp_regs);
-    return m->state.gp_regs[reg];
-}
+/*
+ * 一个guest程序: 解析好的ELF和它的磁盘翻译缓存。
+ * 可以同时给多个machine使用, 这些machine都释放之后才能关闭
+ */
+typedef struct {
+    elf_image_t elf;
+    pcache_t *pcache; // 未启用时为NULL
+} program_t;
 
-FORCE_INLINE void machine_set_gp_reg(machine_t *m, int32_t reg, uint64_t data) {
-    assert(reg >= 0 && reg < num_gp_regs);
-    m->state.gp_regs[reg] = data;
-}
+program_t *program_open(const char *);
+void program_close(program_t *);
 
-void machine_load_program(machine_t *, char *);
+block_t *machine_block(machine_t *, uint64_t);
+void machine_load_program(machine_t *, program_t *);
 void machine_setup(machine_t *, int, char **);
-enum exit_reason_t machine_step(machine_t *);
+void machine_set_fd(machine_t *, int, int);
+enum exit_reason_t machine_step(machine_t *, state_t *);
+void machine_run_hart(machine_t *, state_t *);
+void machine_stop(machine_t *, state_t *, int);
+int machine_run(machine_t *);
+void machine_free(machine_t *);
 #endif
 
 /*
  * syscall.c
  */
-uint64_t do_syscall(machine_t *, uint64_t);
\ No newline at end of file
+uint64_t do_syscall(machine_t *, state_t *, uint64_t);
+
+/*
+ * batch.c
+ */
+int batch_main(int, char **);
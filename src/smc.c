@@ -0,0 +1,338 @@
+#include "rvemu.h"
+#include <signal.h>
+
+/*
+ * 自修改代码(self-modifying code)的检测
+ *
+ * block一旦缓存, guest再改写对应的内存(guest里的JIT、动态加载器)就会执行到
+ * 旧的指令。block建好时把它所在的可写页在宿主上(TO_HOST之后)改成只读,
+ * guest写这些页时触发SIGSEGV, 处理函数恢复写权限、把页记为pending后返回,
+ * 被打断的写重新执行一次就成功了。处理函数不加锁、不分配内存(被打断的线程
+ * 可能正持有machine->lock), 页上的block由machine_step在两个block之间调用
+ * smc_drain移出缓存。之后再次执行到这些代码时重新解码并保护。
+ * 宿主代替guest写内存的系统调用(read等)先调用smc_flush, 否则内核返回EFAULT。
+ *
+ * 失效的block不释放: 它可能正在执行(改写自己所在的页), 本地代码也还在代码缓存里。
+ * 它从哈希表里删掉, 其它block的succ/ibtc里指向它的指针清空, 返回地址栈弹出时
+ * 跳过失效的调用者, 内联了它的superblock退回解释器重新计数, 这样之后就再也走不到它。
+ * 失效和查表建block都持有machine->lock, 多个hart不会同时修改哈希表。
+ *
+ * 按RISC-V的规定, 改写过的代码要在fence.i之后才保证可见, fence.i因此结束block,
+ * 回到machine_step时pending的页一定已经失效。RVEMU_SMC=0关闭写保护,
+ * 这时只能在fence.i处清空整个缓存。guest无法写的页(代码段)不需要保护,
+ * 也只有这些页上的代码会存进磁盘缓存(见smc_immutable)。
+ */
+
+#define SMC_INIT_CAPACITY 256
+
+// 信号处理函数没有参数可传, 经由线程局部变量找到正在执行的machine, 见smc_attach
+static __thread machine_t *smc_machine;
+
+static inline uint64_t page_hash(smc_t *smc, smc_table_t *t, uint64_t page) {
+    uint64_t h = (page / smc->page_size) * 0x9e3779b97f4a7c15ULL;
+    return h >> (64 - __builtin_ctzll(t->capacity));
+}
+
+static smc_table_t *table_new(uint64_t capacity) {
+    smc_table_t *t =
+        calloc(1, sizeof(smc_table_t) + capacity * sizeof(smc_page_t *));
+    t->capacity = capacity;
+    return t;
+}
+
+// 不加锁, 信号处理函数里也调用: 表和页记录都只增不删, 旧表到smc_free才释放
+static smc_page_t *page_find(smc_t *smc, uint64_t page) {
+    smc_table_t *t = __atomic_load_n(&smc->table, __ATOMIC_ACQUIRE);
+    uint64_t mask = t->capacity - 1;
+    for (uint64_t i = page_hash(smc, t, page);; i = (i + 1) & mask) {
+        smc_page_t *p = __atomic_load_n(&t->slots[i], __ATOMIC_ACQUIRE);
+        if (p == NULL)
+            return NULL;
+        if (p->page == page)
+            return p;
+    }
+}
+
+static void slot_put(smc_t *smc, smc_table_t *t, smc_page_t *p) {
+    uint64_t mask = t->capacity - 1;
+    uint64_t i = page_hash(smc, t, p->page);
+    while (t->slots[i] != NULL)
+        i = (i + 1) & mask;
+    __atomic_store_n(&t->slots[i], p, __ATOMIC_RELEASE);
+}
+
+// 调用方持有m->lock
+static smc_page_t *page_insert(smc_t *smc, uint64_t page) {
+    smc_table_t *t = smc->table;
+    if ((smc->size + 1) * 4 > t->capacity * 3) {
+        smc_table_t *bigger = table_new(t->capacity * 2);
+        for (uint64_t i = 0; i < t->capacity; i++) {
+            if (t->slots[i] != NULL)
+                slot_put(smc, bigger, t->slots[i]);
+        }
+        bigger->retired = t;
+        __atomic_store_n(&smc->table, bigger, __ATOMIC_RELEASE);
+        t = bigger;
+    }
+
+    smc_page_t *p = calloc(1, sizeof(smc_page_t));
+    p->page = page;
+    slot_put(smc, t, p);
+    smc->size++;
+    return p;
+}
+
+static inline bool overlaps(uint64_t lo, uint64_t hi, uint64_t a, uint64_t b) {
+    return lo < b && a < hi;
+}
+
+// 把与[lo, hi)重叠的block移出缓存, 并清掉所有指向它们的链接, 调用方持有m->lock
+static void invalidate(machine_t *m, uint64_t lo, uint64_t hi) {
+    cache_t *cache = m->cache;
+    uint64_t killed = 0;
+
+    pthread_mutex_lock(&m->smc.lock);
+    for (uint64_t i = 0; i < cache->capacity;) {
+        block_t *b = cache->table[i].block;
+        if (b == NULL || !overlaps(lo, hi, b->pc, b->end_pc)) {
+            i++;
+            continue;
+        }
+        cache_remove(cache, b->pc); // 后面的项可能移到了i
+        __atomic_store_n(&b->stale, true, __ATOMIC_RELAXED);
+        b->gen++;
+        // 其它hart不加锁读槽位, 见block_exit_slot
+        for (int k = 0; k < ARRAY_SIZE(b->succ); k++)
+            __atomic_store_n(&b->succ[k], NULL, __ATOMIC_RELEASE);
+        for (int k = 0; k < BLOCK_IBTC_SIZE; k++)
+            __atomic_store_n(&b->ibtc[k].block, NULL, __ATOMIC_RELEASE);
+        killed++;
+    }
+
+    if (killed > 0) {
+        for (uint64_t i = 0; i < cache->capacity; i++) {
+            block_t *b = cache->table[i].block;
+            if (b == NULL)
+                continue;
+            for (int k = 0; k < ARRAY_SIZE(b->succ); k++) {
+                block_t *succ = __atomic_load_n(&b->succ[k], __ATOMIC_ACQUIRE);
+                if (succ && succ->stale)
+                    __atomic_store_n(&b->succ[k], NULL, __ATOMIC_RELEASE);
+            }
+            for (int k = 0; k < BLOCK_IBTC_SIZE; k++) {
+                ibtc_entry_t *e = &b->ibtc[k];
+                block_t *target = __atomic_load_n(&e->block, __ATOMIC_ACQUIRE);
+                if (target && target->stale)
+                    __atomic_store_n(&e->block, NULL, __ATOMIC_RELEASE);
+            }
+
+            // superblock内联了失效的代码, 连同还在后台编译的版本一起作废
+            if (overlaps(lo, hi, b->jit_lo, b->jit_hi)) {
+                __atomic_store_n(&b->jit, NULL, __ATOMIC_RELEASE);
+                b->tier = tier_interp;
+                __atomic_store_n(&b->hot, 0, __ATOMIC_RELAXED);
+                __atomic_store_n(
+                    &b->next_tier,
+                    MIN(m->baseline_threshold, m->opt_threshold),
+                    __ATOMIC_RELAXED
+                );
+                b->jit_lo = b->pc;
+                b->jit_hi = b->end_pc;
+                b->gen++;
+            }
+        }
+        m->smc.invalidated += killed;
+    }
+    pthread_mutex_unlock(&m->smc.lock);
+}
+
+/*
+ * 恢复一页的写权限, 页原来受保护时返回true, 由调用方让页上的block失效。
+ * 信号处理函数里调用时不等待(wait为false): 另一个线程正在修改这一页的权限,
+ * 直接返回重新执行那条写, 仍是只读的话会再触发一次。
+ */
+static bool unprotect(machine_t *m, smc_page_t *p, bool wait) {
+    uint32_t state = smc_protected;
+    while (!__atomic_compare_exchange_n(
+        &p->state, &state, smc_busy, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE
+    )) {
+        if (state == smc_writable || !wait)
+            return false;
+        state = smc_protected;
+    }
+    int prot = mmu_prot(&m->mmu, p->page);
+    void *host = (void *)TO_HOST(m->mmu.mem, p->page);
+    if (mprotect(host, m->smc.page_size, prot) != 0)
+        fatal("cannot unprotect guest code");
+    __atomic_store_n(&p->state, smc_writable, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void smc_sigsegv(int sig, siginfo_t *info, void *ucontext) {
+    machine_t *m = smc_machine;
+    // 同一进程里的其它machine各有自己的guest内存, 只认当前线程所属的那段
+    if (m && info->si_code == SEGV_ACCERR &&
+        (uint64_t)info->si_addr - m->mmu.mem < MMU_GUEST_SPACE) {
+        uint64_t addr = TO_GUEST(m->mmu.mem, (uint64_t)info->si_addr);
+        smc_page_t *p = page_find(&m->smc, ROUNDDOWN(addr, m->smc.page_size));
+        // 已经不受保护: 别的hart刚在同一页上触发过, 直接重试
+        if (p && unprotect(m, p, false)) {
+            __atomic_fetch_add(&m->smc.faults, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&p->pending, true, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&m->smc.pending, 1, __ATOMIC_RELEASE);
+        }
+        if (p)
+            return; // 重新执行被打断的写
+    }
+
+    // 不是被保护的代码页: 恢复默认处理, 重新执行时按普通的段错误退出
+    signal(SIGSEGV, SIG_DFL);
+}
+
+void smc_init(machine_t *m) {
+    smc_t *smc = &m->smc;
+    const char *val = getenv("RVEMU_SMC");
+    smc->enabled = val == NULL || strcmp(val, "0") != 0;
+    smc->page_size = getpagesize();
+    smc->table = table_new(SMC_INIT_CAPACITY);
+    pthread_mutex_init(&smc->lock, NULL);
+    smc_attach(m);
+    if (!smc->enabled)
+        return;
+
+    struct sigaction sa = {
+        .sa_sigaction = smc_sigsegv,
+        .sa_flags = SA_SIGINFO,
+    };
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSEGV, &sa, NULL) != 0)
+        fatal("cannot install the SIGSEGV handler");
+}
+
+// 当前线程开始执行m的guest代码, 每个hart的线程都要调用
+void smc_attach(machine_t *m) { smc_machine = m; }
+
+void smc_free(machine_t *m) {
+    smc_table_t *t = m->smc.table;
+    for (uint64_t i = 0; i < t->capacity; i++)
+        free(t->slots[i]);
+    while (t) {
+        smc_table_t *retired = t->retired;
+        free(t);
+        t = retired;
+    }
+    pthread_mutex_destroy(&m->smc.lock);
+}
+
+// 新建的block缓存之前调用, 调用方持有m->lock: 写保护它覆盖的可写页
+void smc_protect(machine_t *m, block_t *block) {
+    smc_t *smc = &m->smc;
+    if (!smc->enabled)
+        return;
+
+    for (uint64_t page = ROUNDDOWN(block->pc, smc->page_size);
+         page < block->end_pc; page += smc->page_size) {
+        int prot = mmu_prot(&m->mmu, page);
+        if (!(prot & PROT_WRITE))
+            continue;
+        smc_page_t *p = page_find(smc, page);
+        if (p == NULL)
+            p = page_insert(smc, page);
+        // 信号处理函数正在恢复写权限时等它做完
+        uint32_t state = smc_writable;
+        while (!__atomic_compare_exchange_n(
+            &p->state, &state, smc_busy, false, __ATOMIC_ACQUIRE,
+            __ATOMIC_ACQUIRE
+        )) {
+            if (state == smc_protected)
+                break;
+            state = smc_writable;
+        }
+        if (state == smc_protected)
+            continue;
+        void *host = (void *)TO_HOST(m->mmu.mem, page);
+        if (mprotect(host, smc->page_size, prot & ~PROT_WRITE) != 0)
+            fatal("cannot write-protect guest code");
+        __atomic_store_n(&p->state, smc_protected, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * [addr, addr + len)即将被改写: 其中被保护的页恢复写权限, 页上的block全部失效。
+ * 系统调用替guest写内存、brk缩小堆之前也要调用。
+ */
+void smc_flush(machine_t *m, uint64_t addr, uint64_t len) {
+    smc_t *smc = &m->smc;
+    uint64_t end = TO_GUEST(m->mmu.mem, m->mmu.host_alloc);
+    if (!smc->enabled || len == 0 || addr >= end)
+        return;
+
+    uint64_t hi = addr + MIN(len, end - addr);
+    pthread_mutex_lock(&m->lock);
+    for (uint64_t page = ROUNDDOWN(addr, smc->page_size); page < hi;
+         page += smc->page_size) {
+        smc_page_t *p = page_find(smc, page);
+        if (p && unprotect(m, p, true))
+            invalidate(m, page, page + smc->page_size);
+    }
+    pthread_mutex_unlock(&m->lock);
+}
+
+/*
+ * 让写保护触发过的页上的block失效, machine_step在两个block之间调用。
+ * 先清计数再扫描: 扫描时新触发的页要么被这次扫到, 要么留下计数等下一次。
+ */
+void smc_drain(machine_t *m) {
+    smc_t *smc = &m->smc;
+    pthread_mutex_lock(&m->lock);
+    __atomic_exchange_n(&smc->pending, 0, __ATOMIC_ACQUIRE);
+    smc_table_t *t = smc->table;
+    for (uint64_t i = 0; i < t->capacity; i++) {
+        smc_page_t *p = t->slots[i];
+        if (p && __atomic_exchange_n(&p->pending, false, __ATOMIC_RELAXED))
+            invalidate(m, p->page, p->page + smc->page_size);
+    }
+    pthread_mutex_unlock(&m->lock);
+}
+
+// 写保护打开时改写过的代码已经失效, 否则不知道改了哪里, 只能全部丢掉
+void smc_fence_i(machine_t *m) {
+    if (m->smc.enabled)
+        return;
+    pthread_mutex_lock(&m->lock);
+    invalidate(m, 0, UINT64_MAX);
+    pthread_mutex_unlock(&m->lock);
+}
+
+// 记下以blocks[0]为入口的jit代码内联了哪些guest代码
+void smc_cover(block_t **blocks, uint32_t n) {
+    block_t *head = blocks[0];
+    head->jit_lo = head->pc;
+    head->jit_hi = head->end_pc;
+    for (uint32_t i = 1; i < n; i++) {
+        head->jit_lo = MIN(head->jit_lo, blocks[i]->pc);
+        head->jit_hi = MAX(head->jit_hi, blocks[i]->end_pc);
+    }
+}
+
+// 后台编译好的代码在生成之后没有失效过才装载
+bool smc_install(machine_t *m, jit_unit_t *unit, exec_block_func_t code) {
+    pthread_mutex_lock(&m->smc.lock);
+    bool ok = unit->blocks[0]->gen == unit->gen;
+    if (ok)
+        __atomic_store_n(&unit->blocks[0]->jit, code, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&m->smc.lock);
+    return ok;
+}
+
+// blocks全在guest不能写的页上, 编译结果与这次运行无关, 可以存进磁盘缓存
+bool smc_immutable(machine_t *m, block_t **blocks, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint64_t page = ROUNDDOWN(blocks[i]->pc, m->smc.page_size);
+             page < blocks[i]->end_pc; page += m->smc.page_size) {
+            if (mmu_prot(&m->mmu, page) & PROT_WRITE)
+                return false;
+        }
+    }
+    return true;
+}
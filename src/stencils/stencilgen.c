@@ -0,0 +1,179 @@
+#include "../rvemu.h"
+#include <ctype.h>
+
+/*
+ * 构建时工具: 从编译好的stencils.o中提取每个模板的机器码和空洞位置,
+ * 输出供baseline.c包含的C头文件。
+ *
+ * 用法: stencilgen stencils.o > stencils.h
+ *
+ * 每个模板在-ffunction-sections下独占一个.text.stencil_<inst>段,
+ * 段内的重定位只允许指向_HOLE_*符号; 末尾跳到_HOLE_CONTINUE的jmp被去掉。
+ * 模板引用了常量池等其它符号, 或者续接不是跳转(编译器没做尾调用)时直接报错,
+ * 这样模板写法的问题在构建时就能发现。
+ */
+
+#define SECTION_PREFIX ".text.stencil_"
+
+static const char *holes[] = {
+    "RD",   "RS1", "RS2",  "FRD",      "FRS1",  "FRS2",
+    "FRS3", "IMM", "IMM2", "CONTINUE", "TAKEN",
+};
+
+static bool is_jump_hole(const char *hole) {
+    return strcmp(hole, "CONTINUE") == 0 || strcmp(hole, "TAKEN") == 0;
+}
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+        fatalf("cannot open %s", path);
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *buf = malloc(*size);
+    if (fread(buf, 1, *size, fp) != *size)
+        fatalf("cannot read %s", path);
+    fclose(fp);
+    return buf;
+}
+
+// jmp rel32或jcc rel32的偏移字段
+static bool is_jump_operand(uint8_t *code, uint64_t off) {
+    if (off >= 1 && code[off - 1] == 0xe9)
+        return true;
+    return off >= 2 && code[off - 2] == 0x0f && (code[off - 1] & 0xf0) == 0x80;
+}
+
+static void gen_stencil(
+    uint8_t *obj, elf64_shdr_t *shdrs, int idx, const char *name,
+    size_t *max_size, size_t *max_holes
+) {
+    elf64_ehdr_t *ehdr = (elf64_ehdr_t *)obj;
+    elf64_shdr_t *text = &shdrs[idx];
+    uint8_t *code = obj + text->sh_offset;
+    uint64_t size = text->sh_size;
+
+    elf64_shdr_t *rela_sh = NULL;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        if (shdrs[i].sh_type == SHT_RELA && shdrs[i].sh_info == idx)
+            rela_sh = &shdrs[i];
+    }
+    if (rela_sh == NULL)
+        fatalf("stencil %s has no holes", name);
+
+    elf64_rela_t *relas = (elf64_rela_t *)(obj + rela_sh->sh_offset);
+    uint64_t nrelas = rela_sh->sh_size / sizeof(elf64_rela_t);
+    elf64_shdr_t *symtab = &shdrs[rela_sh->sh_link];
+    elf64_sym_t *syms = (elf64_sym_t *)(obj + symtab->sh_offset);
+    char *strtab = (char *)(obj + shdrs[symtab->sh_link].sh_offset);
+
+    // 末尾的jmp _HOLE_CONTINUE直接落到下一个模板, 不需要保留
+    uint64_t trimmed = size;
+    for (uint64_t i = 0; i < nrelas; i++) {
+        char *sym = strtab + syms[relas[i].r_sym].st_name;
+        if (strcmp(sym, "_HOLE_CONTINUE") == 0 &&
+            relas[i].r_offset + 4 == size && code[size - 5] == 0xe9)
+            trimmed = size - 5;
+    }
+
+    printf("static const stencil_hole_t stencil_%s_holes[] = {\n", name);
+    size_t nholes = 0;
+    for (uint64_t i = 0; i < nrelas; i++) {
+        elf64_rela_t *rela = &relas[i];
+        char *sym = strtab + syms[rela->r_sym].st_name;
+        if (rela->r_offset >= trimmed)
+            continue;
+        if (strncmp(sym, "_HOLE_", 6) != 0 ||
+            syms[rela->r_sym].st_shndx != SHN_UNDEF)
+            fatalf("stencil %s references '%s'", name, sym);
+
+        const char *hole = sym + 6;
+        bool known = false;
+        for (int j = 0; j < ARRAY_SIZE(holes); j++)
+            known |= strcmp(hole, holes[j]) == 0;
+        if (!known)
+            fatalf("stencil %s: unknown hole %s", name, sym);
+
+        const char *type = NULL;
+        if (is_jump_hole(hole)) {
+            if ((rela->r_type == R_X86_64_PLT32 ||
+                 rela->r_type == R_X86_64_PC32) &&
+                is_jump_operand(code, rela->r_offset))
+                type = "R_X86_64_PC32";
+        } else if (rela->r_type == R_X86_64_32) {
+            type = "R_X86_64_32";
+        } else if (rela->r_type == R_X86_64_32S) {
+            type = "R_X86_64_32S";
+        }
+        if (type == NULL)
+            fatalf(
+                "stencil %s: unsupported use of %s (reloc %u)", name, sym,
+                rela->r_type
+            );
+
+        char lower[16] = { 0 };
+        for (int j = 0; hole[j] && j < sizeof(lower) - 1; j++)
+            lower[j] = tolower(hole[j]);
+        printf(
+            "    { %" PRIu64 ", hole_%s, %s, %" PRId64 " },\n", rela->r_offset,
+            lower, type, rela->r_addend
+        );
+        nholes++;
+    }
+    printf("};\n");
+
+    printf("static const uint8_t stencil_%s_code[] = {", name);
+    for (uint64_t i = 0; i < trimmed; i++)
+        printf("%s0x%02x,", i % 12 == 0 ? "\n    " : " ", code[i]);
+    printf("\n};\n\n");
+
+    *max_size = MAX(*max_size, trimmed);
+    *max_holes = MAX(*max_holes, nholes);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s stencils.o\n", argv[0]);
+        return 1;
+    }
+
+    size_t size;
+    uint8_t *obj = read_file(argv[1], &size);
+    elf64_ehdr_t *ehdr = (elf64_ehdr_t *)obj;
+    if (size < sizeof(elf64_ehdr_t) || *(uint32_t *)ehdr != *(uint32_t *)ELFMAG)
+        fatalf("%s is not an ELF file", argv[1]);
+    elf64_shdr_t *shdrs = (elf64_shdr_t *)(obj + ehdr->e_shoff);
+    char *shstrtab = (char *)(obj + shdrs[ehdr->e_shstrndx].sh_offset);
+
+    printf("// 由stencilgen从src/stencils/stencils.c生成, 不要手动修改\n\n");
+
+    size_t max_size = 0, max_holes = 0;
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        char *name = shstrtab + shdrs[i].sh_name;
+        if (strncmp(name, SECTION_PREFIX, strlen(SECTION_PREFIX)) == 0)
+            gen_stencil(
+                obj, shdrs, i, name + strlen(SECTION_PREFIX), &max_size,
+                &max_holes
+            );
+    }
+
+    printf("static const stencil_t stencils[num_insns] = {\n");
+    for (int i = 0; i < ehdr->e_shnum; i++) {
+        char *name = shstrtab + shdrs[i].sh_name;
+        if (strncmp(name, SECTION_PREFIX, strlen(SECTION_PREFIX)) != 0)
+            continue;
+        name += strlen(SECTION_PREFIX);
+        printf(
+            "    [inst_%s] = { stencil_%s_code, sizeof(stencil_%s_code), "
+            "stencil_%s_holes, ARRAY_SIZE(stencil_%s_holes) },\n",
+            name, name, name, name, name
+        );
+    }
+    printf("};\n\n");
+    printf("#define STENCIL_MAX_SIZE %zu\n", max_size);
+    printf("#define STENCIL_MAX_HOLES %zu\n", max_holes);
+
+    free(obj);
+    return 0;
+}
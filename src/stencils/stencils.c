@@ -0,0 +1,278 @@
+#include "../rvemu.h"
+
+/*
+ * 基线JIT的指令模板(stencil)
+ *
+ * 每个STENCIL(name)对应一个inst_type_t, 构建时用-fno-pic -mcmodel=small编译,
+ * 再由stencilgen把每个函数的机器码和重定位表导出成obj/stencils.h。
+ * 模板中引用的_HOLE_*外部符号就是待填的空洞:
+ *   _HOLE_RD/RS1/RS2          通用寄存器在state_t中的偏移
+ *   _HOLE_FRD/FRS1/FRS2/FRS3  浮点寄存器在state_t中的偏移
+ *   _HOLE_IMM                 32位立即数(auipc/jal时是算好的结果, 融合指令是imm1)
+ *   _HOLE_IMM2                融合指令的第二个立即数(inst_t的imm2字段)
+ *   _HOLE_CONTINUE            下一条指令
+ *   _HOLE_TAKEN               分支跳转/jal的出口
+ * 小代码模型下编译器把符号地址当作32位常量直接编码进指令,
+ * machine_baseline拷贝模板后把这些位置改成真正的值即可。
+ *
+ * 模板之间通过尾调用衔接, state始终在rdi中, guest内存的基址state->mem
+ * 由基线JIT在入口读进rsi, 作为第二个参数一路传下去。末尾跳到_HOLE_CONTINUE的jmp
+ * 由stencilgen去掉, 直接落到下一个模板。没有模板的指令由基线JIT生成对
+ * funcs[]处理函数的调用; 模板的语义必须与interp.c中的处理函数保持一致。
+ */
+
+extern char _HOLE_RD[], _HOLE_RS1[], _HOLE_RS2[];
+extern char _HOLE_FRD[], _HOLE_FRS1[], _HOLE_FRS2[], _HOLE_FRS3[];
+extern char _HOLE_IMM[], _HOLE_IMM2[];
+extern void *_HOLE_CONTINUE(state_t *, uint64_t);
+extern void *_HOLE_TAKEN(state_t *, uint64_t);
+
+#define OFF(hole) ((uintptr_t)(hole))
+#define GP(hole) (*(uint64_t *)((char *)state + OFF(hole)))
+#define FP(hole) (*(fp_reg_t *)((char *)state + OFF(hole)))
+#define IMM ((int64_t)(int32_t)OFF(_HOLE_IMM))
+#define IMM2 ((int64_t)(int32_t)OFF(_HOLE_IMM2))
+#define MEM(ty) (*(ty *)TO_HOST(mem, GP(_HOLE_RS1) + IMM))
+
+#if defined(__has_attribute) && __has_attribute(musttail)
+#define MUSTTAIL __attribute__((musttail))
+#else
+#define MUSTTAIL
+#endif
+
+#define CONTINUE() MUSTTAIL return _HOLE_CONTINUE(state, mem)
+#define TAKEN() MUSTTAIL return _HOLE_TAKEN(state, mem)
+
+#define STENCIL(name) void *stencil_##name(state_t *state, uint64_t mem)
+
+#define RS1 GP(_HOLE_RS1)
+#define RS2 GP(_HOLE_RS2)
+
+// rd = expr
+#define ALU(name, expr)                                                        \
+    STENCIL(name) {                                                            \
+        uint64_t rs1 = RS1, rs2 = RS2;                                         \
+        (void)rs2;                                                             \
+        GP(_HOLE_RD) = (expr);                                                 \
+        CONTINUE();                                                            \
+    }
+
+#define ALUI(name, expr)                                                       \
+    STENCIL(name) {                                                            \
+        uint64_t rs1 = RS1;                                                    \
+        int64_t imm = IMM;                                                     \
+        GP(_HOLE_RD) = (expr);                                                 \
+        CONTINUE();                                                            \
+    }
+
+#define LOAD(name, ty)                                                         \
+    STENCIL(name) {                                                            \
+        GP(_HOLE_RD) = MEM(ty);                                                \
+        CONTINUE();                                                            \
+    }
+
+#define STORE(name, ty)                                                        \
+    STENCIL(name) {                                                            \
+        MEM(ty) = (ty)RS2;                                                     \
+        CONTINUE();                                                            \
+    }
+
+#define BRANCH(name, expr)                                                     \
+    STENCIL(name) {                                                            \
+        uint64_t rs1 = RS1, rs2 = RS2;                                         \
+        if (expr)                                                              \
+            TAKEN();                                                           \
+        CONTINUE();                                                            \
+    }
+
+LOAD(lb, int8_t)
+LOAD(lh, int16_t)
+LOAD(lw, int32_t)
+LOAD(ld, int64_t)
+LOAD(lbu, uint8_t)
+LOAD(lhu, uint16_t)
+LOAD(lwu, uint32_t)
+
+STORE(sb, uint8_t)
+STORE(sh, uint16_t)
+STORE(sw, uint32_t)
+STORE(sd, uint64_t)
+
+ALUI(addi, rs1 + imm)
+ALUI(slli, rs1 << (imm & 0x3f))
+ALUI(slti, (int64_t)rs1 < (int64_t)imm)
+ALUI(sltiu, (uint64_t)rs1 < (uint64_t)imm)
+ALUI(xori, rs1 ^ imm)
+ALUI(srli, rs1 >> (imm & 0x3f))
+ALUI(srai, (int64_t)rs1 >> (imm & 0x3f))
+ALUI(ori, rs1 | (uint64_t)imm)
+ALUI(andi, rs1 & (uint64_t)imm)
+ALUI(addiw, (int64_t)(int32_t)(rs1 + imm))
+ALUI(slliw, (int64_t)(int32_t)(rs1 << (imm & 0x1f)))
+ALUI(srliw, (int64_t)(int32_t)((uint32_t)rs1 >> (imm & 0x1f)))
+ALUI(sraiw, (int64_t)((int32_t)rs1 >> (imm & 0x1f)))
+
+// 立即数由基线JIT算好: lui是imm, auipc是pc + imm
+STENCIL(lui) {
+    GP(_HOLE_RD) = IMM;
+    CONTINUE();
+}
+
+STENCIL(auipc) {
+    GP(_HOLE_RD) = IMM;
+    CONTINUE();
+}
+
+ALU(add, rs1 + rs2)
+ALU(sub, rs1 - rs2)
+ALU(sll, rs1 << (rs2 & 0x3f))
+ALU(slt, (int64_t)rs1 < (int64_t)rs2)
+ALU(sltu, rs1 < rs2)
+ALU(xor, rs1 ^ rs2)
+ALU(srl, rs1 >> (rs2 & 0x3f))
+ALU(sra, (int64_t)rs1 >> (rs2 & 0x3f))
+ALU(or, rs1 | rs2)
+ALU(and, rs1 & rs2)
+ALU(addw, (int64_t)(int32_t)(rs1 + rs2))
+ALU(subw, (int64_t)(int32_t)(rs1 - rs2))
+ALU(sllw, (int64_t)(int32_t)(rs1 << (rs2 & 0x1f)))
+ALU(srlw, (int64_t)(int32_t)((uint32_t)rs1 >> (rs2 & 0x1f)))
+ALU(sraw, (int64_t)(int32_t)((int32_t)rs1 >> (rs2 & 0x1f)))
+
+// interp_util.h里的mulh系列是分段相乘的通用写法, 这里直接用128位乘法
+ALU(mul, rs1 * rs2)
+ALU(mulh, (uint64_t)(((__int128)(int64_t)rs1 * (int64_t)rs2) >> 64))
+ALU(mulhsu,
+    (uint64_t)(((__int128)(int64_t)rs1 * (unsigned __int128)rs2) >> 64))
+ALU(mulhu, (uint64_t)(((unsigned __int128)rs1 * rs2) >> 64))
+ALU(mulw, (int64_t)(int32_t)(rs1 * rs2))
+#define SIGNED_OVERFLOW (rs1 == (uint64_t)INT64_MIN && rs2 == UINT64_MAX)
+
+ALU(div,
+    rs2 == 0          ? UINT64_MAX
+    : SIGNED_OVERFLOW ? (uint64_t)INT64_MIN
+                      : (uint64_t)((int64_t)rs1 / (int64_t)rs2))
+ALU(divu, rs2 == 0 ? UINT64_MAX : rs1 / rs2)
+ALU(rem,
+    rs2 == 0          ? rs1
+    : SIGNED_OVERFLOW ? 0
+                      : (uint64_t)((int64_t)rs1 % (int64_t)rs2))
+ALU(remu, rs2 == 0 ? rs1 : rs1 % rs2)
+ALU(divw,
+    rs2 == 0 ? UINT64_MAX
+             : (int32_t)((int64_t)(int32_t)rs1 / (int64_t)(int32_t)rs2))
+ALU(divuw, rs2 == 0 ? UINT64_MAX : (int32_t)((uint32_t)rs1 / (uint32_t)rs2))
+ALU(remw,
+    rs2 == 0
+        ? (int64_t)(int32_t)rs1
+        : (int64_t)(int32_t)((int64_t)(int32_t)rs1 % (int64_t)(int32_t)rs2))
+ALU(remuw,
+    rs2 == 0 ? (int64_t)(int32_t)(uint32_t)rs1
+             : (int64_t)(int32_t)((uint32_t)rs1 % (uint32_t)rs2))
+
+BRANCH(beq, rs1 == rs2)
+BRANCH(bne, rs1 != rs2)
+BRANCH(blt, (int64_t)rs1 < (int64_t)rs2)
+BRANCH(bge, (int64_t)rs1 >= (int64_t)rs2)
+BRANCH(bltu, rs1 < rs2)
+BRANCH(bgeu, rs1 >= rs2)
+
+// 立即数是返回地址, 跳转目标由出口设置
+STENCIL(jal) {
+    GP(_HOLE_RD) = IMM;
+    TAKEN();
+}
+
+STENCIL(j) { TAKEN(); }
+
+STENCIL(flw) {
+    FP(_HOLE_FRD).v = MEM(uint32_t) | ((uint64_t)-1 << 32);
+    CONTINUE();
+}
+
+STENCIL(fld) {
+    FP(_HOLE_FRD).v = MEM(uint64_t);
+    CONTINUE();
+}
+
+STENCIL(fsw) {
+    MEM(uint32_t) = (uint32_t)FP(_HOLE_FRS2).v;
+    CONTINUE();
+}
+
+STENCIL(fsd) {
+    MEM(uint64_t) = FP(_HOLE_FRS2).v;
+    CONTINUE();
+}
+
+#define FALU(name, field, ty, expr)                                            \
+    STENCIL(name) {                                                            \
+        ty rs1 = FP(_HOLE_FRS1).field;                                         \
+        ty rs2 = FP(_HOLE_FRS2).field;                                         \
+        ty rs3 = FP(_HOLE_FRS3).field;                                         \
+        (void)rs2;                                                             \
+        (void)rs3;                                                             \
+        FP(_HOLE_FRD).field = (ty)(expr);                                      \
+        CONTINUE();                                                            \
+    }
+
+// fnmadd的取反要从常量池读符号位掩码, 模板不能引用数据, 仍走处理函数
+FALU(fadd_s, f, f32, rs1 + rs2)
+FALU(fsub_s, f, f32, rs1 - rs2)
+FALU(fmul_s, f, f32, rs1 * rs2)
+FALU(fdiv_s, f, f32, rs1 / rs2)
+FALU(fmadd_s, f, f32, rs1 * rs2 + rs3)
+FALU(fmsub_s, f, f32, rs1 * rs2 - rs3)
+FALU(fnmsub_s, f, f32, -(rs1 * rs2) + rs3)
+FALU(fadd_d, d, f64, rs1 + rs2)
+FALU(fsub_d, d, f64, rs1 - rs2)
+FALU(fmul_d, d, f64, rs1 * rs2)
+FALU(fdiv_d, d, f64, rs1 / rs2)
+FALU(fmadd_d, d, f64, rs1 * rs2 + rs3)
+FALU(fmsub_d, d, f64, rs1 * rs2 - rs3)
+FALU(fnmsub_d, d, f64, -(rs1 * rs2) + rs3)
+
+STENCIL(fmv_x_w) {
+    GP(_HOLE_RD) = (int64_t)(int32_t)FP(_HOLE_FRS1).w;
+    CONTINUE();
+}
+
+STENCIL(fmv_w_x) {
+    FP(_HOLE_FRD).w = (uint32_t)RS1;
+    CONTINUE();
+}
+
+STENCIL(fmv_x_d) {
+    GP(_HOLE_RD) = FP(_HOLE_FRS1).v;
+    CONTINUE();
+}
+
+STENCIL(fmv_d_x) {
+    FP(_HOLE_FRD).v = RS1;
+    CONTINUE();
+}
+
+// 融合指令(见opt.c)
+STENCIL(slli_srli) {
+    GP(_HOLE_RD) = (RS1 << (IMM & 0x3f)) >> (IMM2 & 0x3f);
+    CONTINUE();
+}
+
+STENCIL(slli_add) {
+    GP(_HOLE_RD) = RS2 + (RS1 << (IMM & 0x3f));
+    CONTINUE();
+}
+
+// addi的结果同时是比较的左操作数, rs2与rd不同
+#define ADDI_BRANCH(name, expr)                                                \
+    STENCIL(name) {                                                            \
+        uint64_t rs1 = RS1 + IMM, rs2 = RS2;                                   \
+        GP(_HOLE_RD) = rs1;                                                    \
+        if (expr)                                                              \
+            TAKEN();                                                           \
+        CONTINUE();                                                            \
+    }
+
+ADDI_BRANCH(addi_bne, rs1 != rs2)
+ADDI_BRANCH(addi_blt, (int64_t)rs1 < (int64_t)rs2)
+ADDI_BRANCH(addi_bltu, rs1 < rs2)
@@ -0,0 +1,46 @@
+#ifndef STR_H
+#define STR_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 可增长的字符串, 用于拼接JIT生成的C代码
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} str_t;
+
+#define STR_INIT_CAP 4096
+
+static inline str_t str_new() {
+    str_t s = { .data = malloc(STR_INIT_CAP), .len = 0, .cap = STR_INIT_CAP };
+    s.data[0] = '\0';
+    return s;
+}
+
+static inline void str_free(str_t *s) {
+    free(s->data);
+    *s = (str_t){ 0 };
+}
+
+__attribute__((format(printf, 2, 3))) static inline void
+str_appendf(str_t *s, const char *fmt, ...) {
+    while (true) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(s->data + s->len, s->cap - s->len, fmt, ap);
+        va_end(ap);
+        if (s->len + n < s->cap) {
+            s->len += n;
+            return;
+        }
+        s->cap = (s->len + n + 1) * 2;
+        s->data = realloc(s->data, s->cap);
+    }
+}
+
+#endif
@@ -1,4 +1,7 @@
 #include "rvemu.h"
+#include <asm/unistd.h>
+#include <linux/futex.h>
+#include <linux/sched.h>
 
 // Copied from https://github.com/riscv-software-src/riscv-pk
 #define SYS_exit 93
@@ -53,6 +56,8 @@
 #define SYS_getrusage 165
 #define SYS_clock_gettime 113
 #define SYS_set_tid_address 96
+#define SYS_futex 98
+#define SYS_clone 220
 #define SYS_set_robust_list 99
 #define SYS_madvise 233
 #define SYS_statx 291
@@ -67,55 +72,231 @@
 #define SYS_lstat 1039
 #define SYS_time 1062
 
-#define GET(reg, name) uint64_t name = machine_get_gp_reg(m, reg);
+#define GET(reg, name) uint64_t name = s->gp_regs[reg];
 
-typedef uint64_t (*syscall_t)(machine_t *);
+typedef uint64_t (*syscall_t)(machine_t *, state_t *);
 
-static uint64_t sys_unimplemented(machine_t *m) {
-    fatalf("unimplemented syscall: %lu", machine_get_gp_reg(m, a7));
+static uint64_t sys_unimplemented(machine_t *m, state_t *s) {
+    fatalf("unimplemented syscall: %lu", s->gp_regs[a7]);
 }
 
-static uint64_t sys_exit(machine_t *m) {
+// 宿主系统调用的结果按内核的约定返回给guest: 失败时是-errno
+static uint64_t host_ret(long ret) { return ret < 0 ? -errno : ret; }
+
+/*
+ * guest的fd是machine自己的fd表的下标(见machine_set_fd), 不同machine互不相干。
+ * 表项由打开和关闭的系统调用在m->lock下修改, 读的时候不加锁。
+ */
+static int host_fd(machine_t *m, uint64_t fd) {
+    if (fd >= MACHINE_MAX_FDS)
+        return -1;
+    return __atomic_load_n(&m->fds[fd], __ATOMIC_RELAXED);
+}
+
+// 把新打开的宿主fd放进最小的空位, 返回guest fd
+static uint64_t fd_install(machine_t *m, int fd) {
+    if (fd < 0)
+        return -errno;
+    pthread_mutex_lock(&m->lock);
+    for (int i = 0; i < MACHINE_MAX_FDS; i++) {
+        if (m->fds[i] == -1) {
+            __atomic_store_n(&m->fds[i], fd, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&m->lock);
+            return i;
+        }
+    }
+    pthread_mutex_unlock(&m->lock);
+    close(fd);
+    return -EMFILE;
+}
+
+// 结束整个guest进程, 其它hart停下后machine_run返回到宿主的调用方
+static uint64_t sys_exit_group(machine_t *m, state_t *s) {
     GET(a0, code);
-    exit(code);
+    machine_stop(m, s, (int)code);
+    return code;
+}
+
+/*
+ * 只结束调用的hart: 按set_tid_address/CLONE_CHILD_CLEARTID的约定把线程号清零
+ * 并唤醒等在上面的线程(pthread_join)。hart在系统调用返回后停下,
+ * 最后一个hart的退出码就是整个guest进程的(见machine_run_hart)。
+ */
+static uint64_t sys_exit(machine_t *m, state_t *s) {
+    GET(a0, code);
+    if (s->clear_child_tid) {
+        smc_flush(m, s->clear_child_tid, sizeof(uint32_t));
+        uint32_t *tid = (uint32_t *)TO_HOST(s->mem, s->clear_child_tid);
+        __atomic_store_n(tid, 0, __ATOMIC_SEQ_CST);
+        syscall(__NR_futex, tid, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+    s->halted = true;
+    return code;
+}
+
+typedef struct {
+    machine_t *machine;
+    state_t *state;
+} hart_t;
+
+static void *hart_main(void *arg) {
+    hart_t hart = *(hart_t *)arg;
+    free(arg);
+    machine_run_hart(hart.machine, hart.state);
+    free(hart.state);
+    return NULL;
 }
 
-static uint64_t sys_close(machine_t *m) {
+/*
+ * 只支持创建线程: 新的hart与调用者共享内存(CLONE_VM)和所有翻译好的代码,
+ * 在宿主的一个新线程上运行。fork/vfork式的clone返回-ENOSYS。
+ * RISC-V的参数顺序是flags, stack, parent_tid, tls, child_tid。
+ */
+static uint64_t sys_clone(machine_t *m, state_t *s) {
+    GET(a0, flags);
+    GET(a1, stack);
+    GET(a2, parent_tid);
+    GET(a3, tls);
+    GET(a4, child_tid);
+    if (!(flags & CLONE_VM) || !(flags & CLONE_THREAD) || stack == 0)
+        return -ENOSYS;
+
+    // 子线程从ecall之后开始执行, state->pc已经指向那里
+    state_t *child = malloc(sizeof(state_t));
+    *child = *s;
+    memset(child->ras, 0, sizeof(child->ras));
+    child->reserved = false;
+    child->icount = 0; // 父hart执行过的指令由它自己汇总, 见machine_run_hart
+    child->gp_regs[sp] = stack;
+    child->gp_regs[a0] = 0;
+    if (flags & CLONE_SETTLS)
+        child->gp_regs[tp] = tls;
+    child->tid = __atomic_fetch_add(&m->next_tid, 1, __ATOMIC_RELAXED);
+    child->clear_child_tid = (flags & CLONE_CHILD_CLEARTID) ? child_tid : 0;
+
+    uint32_t tid = child->tid;
+    if (flags & CLONE_PARENT_SETTID) {
+        smc_flush(m, parent_tid, sizeof(uint32_t));
+        mmu_write(&m->mmu, parent_tid, (uint8_t *)&tid, sizeof(uint32_t));
+    }
+    if (flags & CLONE_CHILD_SETTID) {
+        smc_flush(m, child_tid, sizeof(uint32_t));
+        mmu_write(&m->mmu, child_tid, (uint8_t *)&tid, sizeof(uint32_t));
+    }
+
+    hart_t *hart = malloc(sizeof(hart_t));
+    *hart = (hart_t){ m, child };
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_mutex_lock(&m->lock);
+    m->harts++;
+    pthread_mutex_unlock(&m->lock);
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, hart_main, hart);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        pthread_mutex_lock(&m->lock);
+        m->harts--;
+        pthread_mutex_unlock(&m->lock);
+        free(hart);
+        free(child);
+        return -EAGAIN;
+    }
+    return tid;
+}
+
+/*
+ * guest内存就是宿主内存, futex直接交给宿主内核, 只换算地址。
+ * 等待类操作的第4个参数是超时(struct timespec在两边布局相同),
+ * requeue/wake_op的是个数; wake_op会由内核改写uaddr2。
+ */
+static uint64_t sys_futex(machine_t *m, state_t *s) {
+    GET(a0, uaddr);
+    GET(a1, op);
+    GET(a2, val);
+    GET(a3, timeout);
+    GET(a4, uaddr2);
+    GET(a5, val3);
+    uint64_t arg4 = timeout;
+    switch (op & FUTEX_CMD_MASK) {
+    case FUTEX_WAIT:
+    case FUTEX_WAIT_BITSET:
+        if (timeout)
+            arg4 = TO_HOST(s->mem, timeout);
+        break;
+    case FUTEX_WAKE_OP:
+        smc_flush(m, uaddr2, sizeof(uint32_t));
+        break;
+    }
+    return host_ret(syscall(
+        __NR_futex, TO_HOST(s->mem, uaddr), (int)op, (uint32_t)val, arg4,
+        uaddr2 ? TO_HOST(s->mem, uaddr2) : 0, (uint32_t)val3
+    ));
+}
+
+static uint64_t sys_set_tid_address(machine_t *m, state_t *s) {
+    GET(a0, tidptr);
+    s->clear_child_tid = tidptr;
+    return s->tid;
+}
+
+static uint64_t sys_gettid(machine_t *m, state_t *s) { return s->tid; }
+
+static uint64_t sys_getpid(machine_t *m, state_t *s) { return m->state.tid; }
+
+// 0/1/2也是machine自己dup出来的, 关掉不影响宿主
+static uint64_t sys_close(machine_t *m, state_t *s) {
     GET(a0, fd);
-    if (fd > 2)
-        return close(fd);
-    return 0;
+    pthread_mutex_lock(&m->lock);
+    int host = host_fd(m, fd);
+    if (host != -1)
+        __atomic_store_n(&m->fds[fd], -1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&m->lock);
+    if (host == -1)
+        return -EBADF;
+    return host_ret(close(host));
 }
 
-static uint64_t sys_write(machine_t *m) {
+static uint64_t sys_write(machine_t *m, state_t *s) {
     GET(a0, fd);
     GET(a1, ptr);
     GET(a2, len);
-    return write(fd, (void *)TO_HOST(ptr), (size_t)len);
+    return host_ret(
+        write(host_fd(m, fd), (void *)TO_HOST(s->mem, ptr), (size_t)len)
+    );
 }
 
-static uint64_t sys_fstat(machine_t *m) {
+static uint64_t sys_fstat(machine_t *m, state_t *s) {
     GET(a0, fd);
     GET(a1, addr);
-    return fstat(fd, (struct stat *)TO_HOST(addr));
+    smc_flush(m, addr, sizeof(struct stat));
+    return host_ret(
+        fstat(host_fd(m, fd), (struct stat *)TO_HOST(s->mem, addr))
+    );
 }
 
-static uint64_t sys_gettimeofday(machine_t *m) {
+static uint64_t sys_gettimeofday(machine_t *m, state_t *s) {
     GET(a0, tv_addr);
     GET(a1, tz_addr);
-    struct timeval *tv = (struct timeval *)TO_HOST(tv_addr);
+    struct timeval *tv = (struct timeval *)TO_HOST(s->mem, tv_addr);
     struct timezone *tz = NULL;
-    if (tz_addr != 0)
-        tz = (struct timezone *)TO_HOST(tz_addr);
+    smc_flush(m, tv_addr, sizeof(struct timeval));
+    if (tz_addr != 0) {
+        smc_flush(m, tz_addr, sizeof(struct timezone));
+        tz = (struct timezone *)TO_HOST(s->mem, tz_addr);
+    }
     return gettimeofday(tv, tz);
 }
 
-static uint64_t sys_brk(machine_t *m) {
+static uint64_t sys_brk(machine_t *m, state_t *s) {
     GET(a0, addr);
     if (addr == 0)
         addr = m->mmu.guest_alloc;
     assert(addr >= m->mmu.base);
     int64_t incr = (int64_t)addr - m->mmu.guest_alloc;
+    if (incr < 0) // 释放的页重新分配时是可写的, 上面的代码要先失效
+        smc_flush(m, addr, -incr);
     mmu_alloc(&m->mmu, incr);
     return addr;
 }
@@ -142,43 +323,49 @@ static int convert_flags(int flags) {
     REWRITE_FLAG(O_CREAT);
     REWRITE_FLAG(O_TRUNC);
     REWRITE_FLAG(O_EXCL);
-    return hostflags;
+    // guest的文件不能漏给JIT启动的编译器; guest没有execve, 不影响它自己
+    return hostflags | O_CLOEXEC;
 }
 
-static uint64_t sys_openat(machine_t *m) {
+static uint64_t sys_openat(machine_t *m, state_t *s) {
     GET(a0, dirfd);
     GET(a1, nameptr);
     GET(a2, flags);
     GET(a3, mode);
-    return openat(dirfd, (char *)TO_HOST(nameptr), convert_flags(flags), mode);
+    int dir = (int)dirfd == AT_FDCWD ? AT_FDCWD : host_fd(m, dirfd);
+    char *name = (char *)TO_HOST(s->mem, nameptr);
+    return fd_install(m, openat(dir, name, convert_flags(flags), mode));
 }
 
-static uint64_t sys_open(machine_t *m) {
+static uint64_t sys_open(machine_t *m, state_t *s) {
     GET(a0, nameptr);
     GET(a1, flags);
     GET(a2, mode);
-    uint64_t ret =
-        open((char *)TO_HOST(nameptr), convert_flags(flags), (mode_t)mode);
-    return ret;
+    char *name = (char *)TO_HOST(s->mem, nameptr);
+    return fd_install(m, open(name, convert_flags(flags), (mode_t)mode));
 }
 
-static uint64_t sys_lseek(machine_t *m) {
+static uint64_t sys_lseek(machine_t *m, state_t *s) {
     GET(a0, fd);
     GET(a1, offset);
     GET(a2, whence);
-    return lseek(fd, offset, whence);
+    return host_ret(lseek(host_fd(m, fd), offset, whence));
 }
 
-static uint64_t sys_read(machine_t *m) {
+static uint64_t sys_read(machine_t *m, state_t *s) {
     GET(a0, fd);
     GET(a1, bufptr);
     GET(a2, count);
-    return read(fd, (char *)TO_HOST(bufptr), (size_t)count);
+    // 内核写只读页不会触发SIGSEGV, 而是返回EFAULT, 先解除写保护
+    smc_flush(m, bufptr, count);
+    return host_ret(
+        read(host_fd(m, fd), (char *)TO_HOST(s->mem, bufptr), (size_t)count)
+    );
 }
 
 static syscall_t syscall_table[] = {
     [SYS_exit] = sys_exit,
-    [SYS_exit_group] = sys_exit,
+    [SYS_exit_group] = sys_exit_group,
     [SYS_read] = sys_read,
     [SYS_pread] = sys_unimplemented,
     [SYS_write] = sys_write,
@@ -195,12 +382,12 @@ static syscall_t syscall_table[] = {
     [SYS_getcwd] = sys_unimplemented,
     [SYS_brk] = sys_brk,
     [SYS_uname] = sys_unimplemented,
-    [SYS_getpid] = sys_unimplemented,
+    [SYS_getpid] = sys_getpid,
     [SYS_getuid] = sys_unimplemented,
     [SYS_geteuid] = sys_unimplemented,
     [SYS_getgid] = sys_unimplemented,
     [SYS_getegid] = sys_unimplemented,
-    [SYS_gettid] = sys_unimplemented,
+    [SYS_gettid] = sys_gettid,
     [SYS_tgkill] = sys_unimplemented,
     [SYS_mmap] = sys_unimplemented,
     [SYS_munmap] = sys_unimplemented,
@@ -219,6 +406,9 @@ static syscall_t syscall_table[] = {
     [SYS_rt_sigprocmask] = sys_unimplemented,
     [SYS_clock_gettime] = sys_unimplemented,
     [SYS_chdir] = sys_unimplemented,
+    [SYS_clone] = sys_clone,
+    [SYS_futex] = sys_futex,
+    [SYS_set_tid_address] = sys_set_tid_address,
 };
 
 static syscall_t old_syscall_table[] = {
@@ -232,7 +422,7 @@ static syscall_t old_syscall_table[] = {
     [-OLD_SYSCALL_THRESHOLD + SYS_time] = sys_unimplemented,
 };
 
-uint64_t do_syscall(machine_t *m, uint64_t n) {
+uint64_t do_syscall(machine_t *m, state_t *s, uint64_t n) {
     syscall_t f = NULL;
     if (n < ARRAY_SIZE(syscall_table))
         f = syscall_table[n];
@@ -242,5 +432,6 @@ uint64_t do_syscall(machine_t *m, uint64_t n) {
     if (!f)
         fatal("unknown syscall");
 
-    return f(m);
+    TRACE_PROBE(trace_syscall, s->pc, 0, n, s->gp_regs[a0]);
+    return f(m, s);
 }
\ No newline at end of file
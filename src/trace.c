@@ -0,0 +1,134 @@
+#include "rvemu.h"
+
+/*
+ * 跟踪探针, 只在TRACE=1构建时编译进来, 否则TRACE_PROBE展开为空
+ *
+ * RVEMU_TRACE按类别开启, 逗号分隔: load, alu, jump, syscall, 或all。
+ * 记录按固定大小的trace_rec_t写进内存里的环形缓冲区, 满了覆盖最旧的,
+ * 进程退出时原样写到RVEMU_TRACE_FILE(默认rvemu.trace):
+ * 一个trace_file_hdr_t, 后面是按时间顺序的count个trace_rec_t。
+ * RVEMU_TRACE_SIZE是缓冲区能放的记录数, 向上取2的幂, 默认1M条(32MB)。
+ *
+ * 探针都在解释器的处理函数里, 开启跟踪时不再提升到JIT层(见machine.c)。
+ */
+
+#ifdef TRACE
+
+#define TRACE_MAGIC "RVTRACE"
+#define TRACE_VERSION 1
+#define TRACE_DEFAULT_SIZE (1 << 20)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t rec_size; // sizeof(trace_rec_t)
+    uint64_t count;    // 文件中的记录数
+    uint64_t total;    // 一共产生过的记录数, 超过count的部分已被覆盖
+} trace_file_hdr_t;
+
+uint32_t trace_mask;
+__thread bool trace_suppress;
+
+static trace_rec_t *ring;
+static uint64_t ring_size; // 2的幂
+static uint64_t ring_head; // 下一条记录的序号, 对ring_size取模就是位置
+static const char *trace_path;
+
+static const struct {
+    const char *name;
+    uint32_t mask;
+} categories[] = {
+    { "load", trace_load },
+    { "alu", trace_alu },
+    { "jump", trace_jump },
+    { "syscall", trace_syscall },
+    { "all", trace_load | trace_alu | trace_jump | trace_syscall },
+};
+
+static uint32_t parse_categories(const char *spec) {
+    uint32_t mask = 0;
+    char *copy = strdup(spec);
+    for (char *tok = strtok(copy, ","); tok; tok = strtok(NULL, ",")) {
+        bool found = false;
+        for (int i = 0; i < ARRAY_SIZE(categories); i++) {
+            if (strcmp(tok, categories[i].name) == 0) {
+                mask |= categories[i].mask;
+                found = true;
+            }
+        }
+        if (!found)
+            fatalf("unknown trace category '%s'", tok);
+    }
+    free(copy);
+    return mask;
+}
+
+static void trace_flush(void) {
+    FILE *fp = fopen(trace_path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "rvemu: cannot write trace to %s\n", trace_path);
+        return;
+    }
+
+    uint64_t total = ring_head;
+    uint64_t count = MIN(total, ring_size);
+    trace_file_hdr_t hdr = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .rec_size = sizeof(trace_rec_t),
+        .count = count,
+        .total = total,
+    };
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+
+    // 缓冲区绕回过时, 最旧的记录从ring_head所在的位置开始
+    uint64_t start = (total - count) & (ring_size - 1);
+    uint64_t first = MIN(count, ring_size - start);
+    fwrite(ring + start, sizeof(trace_rec_t), first, fp);
+    fwrite(ring, sizeof(trace_rec_t), count - first, fp);
+    fclose(fp);
+}
+
+// 缓冲区属于整个宿主进程, 所有machine的记录写在一起, 只初始化一次
+static void trace_setup(void) {
+    const char *spec = getenv("RVEMU_TRACE");
+    if (spec == NULL || *spec == '\0')
+        return;
+    trace_mask = parse_categories(spec);
+
+    uint64_t size = TRACE_DEFAULT_SIZE;
+    const char *val = getenv("RVEMU_TRACE_SIZE");
+    if (val)
+        size = MAX(strtoull(val, NULL, 0), 1);
+    ring_size = 1;
+    while (ring_size < size)
+        ring_size <<= 1;
+    ring = calloc(ring_size, sizeof(trace_rec_t));
+    if (ring == NULL)
+        fatal("cannot allocate the trace buffer");
+
+    trace_path = getenv("RVEMU_TRACE_FILE");
+    if (trace_path == NULL)
+        trace_path = "rvemu.trace";
+    atexit(trace_flush);
+}
+
+void trace_init(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, trace_setup);
+}
+
+void trace_record(
+    enum trace_cat_t cat, uint64_t pc, uint32_t reg, uint64_t a, uint64_t b
+) {
+    uint64_t seq = __atomic_fetch_add(&ring_head, 1, __ATOMIC_RELAXED);
+    ring[seq & (ring_size - 1)] = (trace_rec_t){
+        .pc = pc,
+        .a = a,
+        .b = b,
+        .cat = cat,
+        .reg = reg,
+    };
+}
+
+#endif